@@ -93,6 +93,9 @@ typedef struct	data_hdr {
     int		xm1;			/* last value in prev record	*/
     int		xm2;			/* next to last val in prev rec	*/
     float	rate_spsec;		/* blockette 100 sample rate	*/
+    int		sncl_id;		/* interned SNCL id, or -1.	*/
+    INT_TIME	clock_anchor;		/* anchor of ms_pack2_update_hdr*/
+    int		clock_index;		/* # samples since clock_anchor	*/
 } DATA_HDR;
 
 /* Attribute structure for a specific data_hdr and blksize.		*/
@@ -0,0 +1,1028 @@
+/************************************************************************/
+/*  Routines for FDSN miniSEED version 3 records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "qsteim.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qtime.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "pack.h"
+#include "unpack.h"
+#include "ms_pack2.h"
+#include "ms_unpack.h"
+#include "ms_sncl.h"
+#include "ms3.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define	CRC32C_X86		/* SSE4.2 crc32 instruction at run time.*/
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && \
+    defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define	CRC32C_ARM		/* ARMv8 crc32c instructions.		*/
+#include <arm_acle.h>
+#endif
+
+#define	CRC32C_POLY	0x82f63b78	/* reflected Castagnoli polynomial.*/
+#define	MS3_CRC_OFFSET	28	/* offset of CRC in fixed header.	*/
+#define	MS3_EXTRA_LEN	64	/* max length of generated extra hdrs.	*/
+#define	VALS_PER_FRAME	(16-1)		/* # of ints for data per frame.*/
+
+static unsigned int crc32c_table[8][256];
+static int crc32c_hw = 0;	/* crc32c instructions are available.	*/
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+/************************************************************************/
+/*  crc32c_init:							*/
+/*	Build the tables for the table driven CRC-32C, and determine	*/
+/*	whether the CPU has crc32c instructions.			*/
+/************************************************************************/
+static void crc32c_init (void)
+{
+    unsigned int c;
+    int		i, j;
+
+    for (i=0; i<256; i++) {
+	c = i;
+	for (j=0; j<8; j++) c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+	crc32c_table[0][i] = c;
+    }
+    for (i=0; i<256; i++) {
+	c = crc32c_table[0][i];
+	for (j=1; j<8; j++) {
+	    c = crc32c_table[0][c & 0xff] ^ (c >> 8);
+	    crc32c_table[j][i] = c;
+	}
+    }
+#ifdef	CRC32C_X86
+    crc32c_hw = __builtin_cpu_supports ("sse4.2");
+#endif
+#ifdef	CRC32C_ARM
+    crc32c_hw = 1;
+#endif
+}
+
+/************************************************************************/
+/*  crc32c_sw:								*/
+/*	Update a CRC-32C with the slicing-by-8 table driven algorithm.	*/
+/*	The CRC is not inverted on entry or exit.			*/
+/************************************************************************/
+static unsigned int crc32c_sw
+   (unsigned int crc,		/* running CRC.				*/
+    unsigned char *p,		/* ptr to bytes.			*/
+    size_t	len)		/* # of bytes.				*/
+{
+    unsigned int (*t)[256] = crc32c_table;
+
+    while (len >= 8) {
+	crc ^= (unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+	    ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+	crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^
+	    t[5][(crc >> 16) & 0xff] ^ t[4][crc >> 24] ^
+	    t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+	p += 8;
+	len -= 8;
+    }
+    while (len-- > 0) crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return (crc);
+}
+
+#ifdef	CRC32C_X86
+/************************************************************************/
+/*  crc32c_x86:								*/
+/*	Update a CRC-32C with the SSE4.2 crc32 instruction.		*/
+/************************************************************************/
+__attribute__((target("sse4.2")))
+static unsigned int crc32c_x86
+   (unsigned int crc,		/* running CRC.				*/
+    unsigned char *p,		/* ptr to bytes.			*/
+    size_t	len)		/* # of bytes.				*/
+{
+    uint64_t	c = crc, v;
+
+    while (len >= 8) {
+	memcpy ((void *)&v, p, 8);
+	c = __builtin_ia32_crc32di (c, v);
+	p += 8;
+	len -= 8;
+    }
+    while (len-- > 0) c = __builtin_ia32_crc32qi ((unsigned int)c, *p++);
+    return ((unsigned int)c);
+}
+#endif
+
+#ifdef	CRC32C_ARM
+/************************************************************************/
+/*  crc32c_arm:								*/
+/*	Update a CRC-32C with the ARMv8 crc32c instructions.		*/
+/************************************************************************/
+static unsigned int crc32c_arm
+   (unsigned int crc,		/* running CRC.				*/
+    unsigned char *p,		/* ptr to bytes.			*/
+    size_t	len)		/* # of bytes.				*/
+{
+    uint64_t	v;
+
+    while (len >= 8) {
+	memcpy ((void *)&v, p, 8);
+	crc = __crc32cd (crc, v);
+	p += 8;
+	len -= 8;
+    }
+    while (len-- > 0) crc = __crc32cb (crc, *p++);
+    return (crc);
+}
+#endif
+
+/************************************************************************/
+/*  ms3_crc32c:								*/
+/*	Compute the CRC-32C (Castagnoli) of a buffer, as used in	*/
+/*	miniSEED 3 records.  The CRC of consecutive buffers may be	*/
+/*	computed by passing the CRC of the preceding buffers, or 0 for	*/
+/*	the first buffer.  The crc32c instructions of the CPU are used	*/
+/*	when available.							*/
+/*  return:	CRC-32C of the bytes.					*/
+/************************************************************************/
+unsigned int ms3_crc32c
+   (unsigned int crc,		/* CRC of preceding bytes, or 0.	*/
+    char	*buf,		/* ptr to bytes.			*/
+    size_t	len)		/* # of bytes.				*/
+{
+    pthread_once (&crc32c_once, crc32c_init);
+    crc = ~crc;
+#ifdef	CRC32C_X86
+    if (crc32c_hw) return (~crc32c_x86 (crc, (unsigned char *)buf, len));
+#endif
+#ifdef	CRC32C_ARM
+    if (crc32c_hw) return (~crc32c_arm (crc, (unsigned char *)buf, len));
+#endif
+    return (~crc32c_sw (crc, (unsigned char *)buf, len));
+}
+
+/************************************************************************/
+/*  Little endian field access.  miniSEED 3 headers are always little	*/
+/*  endian.								*/
+/************************************************************************/
+static unsigned int get_le16
+   (char	*b)		/* ptr to value.			*/
+{
+    unsigned char *p = (unsigned char *)b;
+    return ((unsigned int)p[0] | ((unsigned int)p[1] << 8));
+}
+
+static unsigned int get_le32
+   (char	*b)		/* ptr to value.			*/
+{
+    unsigned char *p = (unsigned char *)b;
+    return ((unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+	    ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24));
+}
+
+static void put_le16
+   (char	*b,		/* ptr to value.			*/
+    unsigned int v)		/* value to store.			*/
+{
+    b[0] = v & 0xff;
+    b[1] = (v >> 8) & 0xff;
+}
+
+static void put_le32
+   (char	*b,		/* ptr to value.			*/
+    unsigned int v)		/* value to store.			*/
+{
+    b[0] = v & 0xff;
+    b[1] = (v >> 8) & 0xff;
+    b[2] = (v >> 16) & 0xff;
+    b[3] = (v >> 24) & 0xff;
+}
+
+static double get_le_double
+   (char	*b)		/* ptr to value.			*/
+{
+    uint64_t	u;
+    double	d;
+
+    u = (uint64_t)get_le32 (b) | ((uint64_t)get_le32 (b+4) << 32);
+    memcpy ((void *)&d, (void *)&u, sizeof(d));
+    return (d);
+}
+
+static void put_le_double
+   (char	*b,		/* ptr to value.			*/
+    double	d)		/* value to store.			*/
+{
+    uint64_t	u;
+
+    memcpy ((void *)&u, (void *)&d, sizeof(u));
+    put_le32 (b, (unsigned int)(u & 0xffffffff));
+    put_le32 (b+4, (unsigned int)(u >> 32));
+}
+
+/************************************************************************/
+/*  ms3_sid_to_sncl:							*/
+/*	Convert an FDSN source identifier of the form			*/
+/*	FDSN:NET_STA_LOC_B_S_SS to SEED 2 network, station, location	*/
+/*	and channel names.  The channel is the concatenation of the	*/
+/*	band, source and subsource codes.				*/
+/*  return:	1 on success, 0 if the id has no SEED 2 names.		*/
+/************************************************************************/
+int ms3_sid_to_sncl
+   (char	*sid,		/* FDSN source identifier.		*/
+    char	*network,	/* network name (returned).		*/
+    char	*station,	/* station name (returned).		*/
+    char	*location,	/* location name (returned).		*/
+    char	*channel)	/* channel name (returned).		*/
+{
+    static int	maxlen[6] = { DH_NETWORK_LEN, DH_STATION_LEN,
+			      DH_LOCATION_LEN, 1, 1, 1 };
+    char	field[6][DH_STATION_LEN+1];
+    char	*p, *q;
+    int		i;
+
+    network[0] = station[0] = location[0] = channel[0] = '\0';
+    if (strncmp (sid, "FDSN:", 5) != 0) return (0);
+    p = sid + 5;
+    for (i=0; i<6; i++) {
+	q = (i < 5) ? strchr (p, '_') : p + strlen (p);
+	if (q == NULL || q - p > maxlen[i] || (i >= 3 && q - p != 1))
+	    return (0);
+	memcpy (field[i], p, q - p);
+	field[i][q-p] = '\0';
+	p = q + 1;
+    }
+    strcpy (network, field[0]);
+    strcpy (station, field[1]);
+    strcpy (location, field[2]);
+    sprintf (channel, "%s%s%s", field[3], field[4], field[5]);
+    return (1);
+}
+
+/************************************************************************/
+/*  ms3_sncl_to_sid:							*/
+/*	Convert SEED 2 network, station, location and channel names to	*/
+/*	an FDSN source identifier.					*/
+/************************************************************************/
+void ms3_sncl_to_sid
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    char	*sid)		/* FDSN source identifier (returned).	*/
+{
+    if (strlen (channel) == 3)
+	sprintf (sid, "FDSN:%s_%s_%s_%c_%c_%c", network, station, location,
+		 channel[0], channel[1], channel[2]);
+    else
+	sprintf (sid, "FDSN:%s_%s_%s_%s", network, station, location, channel);
+}
+
+/************************************************************************/
+/*  ms3_record_length:							*/
+/*	Determine the length of the miniSEED 3 record at the start of	*/
+/*	a buffer from its fixed header.					*/
+/*  return:								*/
+/*	length of the record on success.				*/
+/*	0 if more bytes are needed to determine the length.		*/
+/*	MS_ERROR if the buffer does not start with a miniSEED 3 record.	*/
+/************************************************************************/
+int ms3_record_length
+   (char	*rec,		/* ptr to start of miniSEED 3 record.	*/
+    int		nbytes)		/* # of bytes of record available.	*/
+{
+    unsigned int data_len;
+    int		len;
+
+    if (nbytes < 3) return (0);
+    if (rec[0] != 'M' || rec[1] != 'S' || rec[2] != MS3_FORMAT_VERSION)
+	return (MS_ERROR);
+    if (nbytes < MS3_FIXED_HDR_LEN) return (0);
+    len = MS3_FIXED_HDR_LEN + (unsigned char)rec[33] + get_le16 (rec+34);
+    data_len = get_le32 (rec+36);
+    if (data_len > (unsigned int)(INT_MAX - len)) return (MS_ERROR);
+    return (len + (int)data_len);
+}
+
+/************************************************************************/
+/*  ms3_parse_hdr:							*/
+/*	Parse the header of a miniSEED 3 record and verify its CRC.	*/
+/*	The sample rate is returned in samples per second, whether the	*/
+/*	record contains a rate or a period.  The begtime has the usecs	*/
+/*	of the record time, and h->nsec has the remaining nanoseconds.	*/
+/*	h->extra points into the record.				*/
+/*  return:								*/
+/*	length of the record on success.				*/
+/*	0 if the record extends past nbytes.				*/
+/*	MS_ERROR if the record is not a valid miniSEED 3 record.	*/
+/************************************************************************/
+int ms3_parse_hdr
+   (char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		nbytes,		/* # of bytes of record available.	*/
+    MS3_HDR	*h)		/* decoded header (returned).		*/
+{
+    EXT_TIME	et;
+    static char	zero[4];
+    unsigned int crc, ns;
+    double	rate;
+    int		reclen, idlen;
+
+    if ((reclen = ms3_record_length (rec, nbytes)) <= 0) return (reclen);
+    if (reclen > nbytes) return (0);
+    memset ((char *)h, 0, sizeof(MS3_HDR));
+    idlen = (unsigned char)rec[33];
+    memcpy (h->sid, rec + MS3_FIXED_HDR_LEN, idlen);
+    h->sid[idlen] = '\0';
+    h->sncl_id = MS_SNCL_NONE;
+    ms3_sid_to_sncl (h->sid, h->network_id, h->station_id,
+		     h->location_id, h->channel_id);
+
+    /* Decode the time as decode_time_sdr does.				*/
+    ns = get_le32 (rec+4);
+    et.year = get_le16 (rec+8);
+    et.doy = get_le16 (rec+10);
+    et.hour = (unsigned char)rec[12];
+    et.minute = (unsigned char)rec[13];
+    et.second = (unsigned char)rec[14];
+    if (ns > 999999999 || et.doy < 1 || et.doy > 366 || et.hour > 23 ||
+	et.minute > 59 || et.second > 60) return (MS_ERROR);
+    et.usec = ns / 1000;
+    dy_to_mdy (et.doy, et.year, &et.month, &et.day);
+    h->begtime = normalize_time (ext_to_int (et));
+    h->nsec = ns % 1000;
+
+    h->flags = (unsigned char)rec[3];
+    h->data_type = (unsigned char)rec[15];
+    rate = get_le_double (rec+16);
+    h->sample_rate = (rate < 0) ? -1. / rate : rate;
+    h->num_samples = (int)get_le32 (rec+24);
+    h->crc = get_le32 (rec + MS3_CRC_OFFSET);
+    h->pub_version = (unsigned char)rec[32];
+    h->extra_len = get_le16 (rec+34);
+    h->extra = (h->extra_len > 0) ? rec + MS3_FIXED_HDR_LEN + idlen : NULL;
+    h->data_offset = MS3_FIXED_HDR_LEN + idlen + h->extra_len;
+    h->data_len = reclen - h->data_offset;
+    h->reclen = reclen;
+    if (h->num_samples < 0) return (MS_ERROR);
+
+    /* The CRC is computed with the CRC field set to 0.			*/
+    crc = ms3_crc32c (0, rec, MS3_CRC_OFFSET);
+    crc = ms3_crc32c (crc, zero, 4);
+    crc = ms3_crc32c (crc, rec + MS3_CRC_OFFSET + 4,
+		      reclen - MS3_CRC_OFFSET - 4);
+    if (crc != h->crc) {
+	fprintf (stderr, "Error: CRC mismatch for %s in ms3_parse_hdr\n",
+		 h->sid);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    return (reclen);
+}
+
+/************************************************************************/
+/*  ms3_unpack:								*/
+/*	Decode the samples of a miniSEED 3 record with the SEED 2	*/
+/*	decoding routines.  Steim data is big endian, and other data	*/
+/*	is little endian.  Integer formats are returned as int, and	*/
+/*	floating point formats as float or double.  For Steim data,	*/
+/*	h->xm1 is set from the first difference.			*/
+/*  return:	# of samples on success, error code on error.		*/
+/************************************************************************/
+int ms3_unpack
+   (MS3_HDR	*h,		/* ptr to header of record.		*/
+    char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		max_num_points,	/* max # of samples to return.		*/
+    void	*data_buffer)	/* ptr to output data buffer.		*/
+{
+    char	*dbuf;
+    int		*diffbuff;
+    int		ns = h->num_samples;
+    int		x0, xn, n;
+    int		nbuf = (h->data_len + 7) & ~7;
+    char	msg[QLIB2_ERRMSG_LEN];
+
+    if (ns == 0 || max_num_points <= 0) return (0);
+    /* The data is copied to aligned storage for the decoders.		*/
+    if (IS_STEIM_COMP(h->data_type)) n = nbuf + ns * sizeof(int);
+    else n = nbuf;
+    if ((dbuf = (char *)malloc (n > 0 ? n : 1)) == NULL) {
+	fprintf (stderr, "Error: unable to malloc data buffer in ms3_unpack\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    memcpy (dbuf, rec + h->data_offset, h->data_len);
+    diffbuff = (int *)(dbuf + nbuf);
+    msg[0] = '\0';
+
+    switch (h->data_type) {
+      case STEIM1:
+	n = unpack_steim1_r ((FRAME *)dbuf, h->data_len, ns, max_num_points,
+			     (int *)data_buffer, diffbuff, &x0, &xn,
+			     SEED_BIG_ENDIAN, msg);
+	if (n > 0) h->xm1 = x0 - diffbuff[0];
+	break;
+      case STEIM2:
+	n = unpack_steim2_r ((FRAME *)dbuf, h->data_len, ns, max_num_points,
+			     (int *)data_buffer, diffbuff, &x0, &xn,
+			     SEED_BIG_ENDIAN, msg);
+	if (n > 0) h->xm1 = x0 - diffbuff[0];
+	break;
+      case INT_16:
+	n = unpack_int_16 ((short *)dbuf, h->data_len, ns, max_num_points,
+			   (int *)data_buffer, SEED_LITTLE_ENDIAN, NULL);
+	break;
+      case INT_32:
+	n = unpack_int_32 ((int *)dbuf, h->data_len, ns, max_num_points,
+			   (int *)data_buffer, SEED_LITTLE_ENDIAN, NULL);
+	break;
+      case IEEE_FP_SP:
+	n = unpack_fp_sp ((float *)dbuf, h->data_len, ns, max_num_points,
+			  (float *)data_buffer, SEED_LITTLE_ENDIAN, NULL);
+	break;
+      case IEEE_FP_DP:
+	n = unpack_fp_dp ((double *)dbuf, h->data_len, ns, max_num_points,
+			  (double *)data_buffer, SEED_LITTLE_ENDIAN, NULL);
+	break;
+      case UNKNOWN_DATATYPE:
+	/* Text.							*/
+	n = (ns < max_num_points) ? ns : max_num_points;
+	if (n > h->data_len) n = h->data_len;
+	memcpy (data_buffer, dbuf, n);
+	break;
+      default:
+	snprintf (msg, sizeof(msg),
+		  "Error: unable to decode encoding %d in ms3_unpack\n",
+		  h->data_type);
+	n = MS_ERROR;
+	break;
+    }
+    free (dbuf);
+    if (n > 0) return (n);
+    if (msg[0]) {
+	fprintf (stderr, "%s", msg);
+	fflush (stderr);
+    }
+    return (MS_ERROR);
+}
+
+/************************************************************************/
+/*  ms3_write:								*/
+/*	Write a miniSEED 3 record with the specified header and data,	*/
+/*	and compute its CRC.						*/
+/*  return:	length of record on success, MS_ERROR if it does not	*/
+/*		fit in maxlen bytes.					*/
+/************************************************************************/
+static int ms3_write
+   (MS3_HDR	*h,		/* ptr to header for record.		*/
+    char	*data,		/* encoded data.			*/
+    int		data_len,	/* length of encoded data.		*/
+    int		num_samples,	/* # of samples in data.		*/
+    char	*rec,		/* output buffer for record.		*/
+    int		maxlen)		/* max length of record.		*/
+{
+    EXT_TIME	et;
+    double	rate = h->sample_rate;
+    int		idlen = strlen (h->sid);
+    int		off;
+
+    off = MS3_FIXED_HDR_LEN + idlen + h->extra_len;
+    if (idlen > MS3_SID_LEN || h->extra_len > 65535 || off + data_len > maxlen)
+	return (MS_ERROR);
+    et = int_to_ext (h->begtime);
+    rec[0] = 'M';
+    rec[1] = 'S';
+    rec[2] = MS3_FORMAT_VERSION;
+    rec[3] = h->flags;
+    put_le32 (rec+4, et.usec * 1000 + h->nsec);
+    put_le16 (rec+8, et.year);
+    put_le16 (rec+10, et.doy);
+    rec[12] = et.hour;
+    rec[13] = et.minute;
+    rec[14] = et.second;
+    rec[15] = h->data_type;
+    /* Rates below 1 sample per second are written as a period.	*/
+    put_le_double (rec+16, (rate > 0 && rate < 1.) ? -1. / rate : rate);
+    put_le32 (rec+24, num_samples);
+    put_le32 (rec + MS3_CRC_OFFSET, 0);
+    rec[32] = h->pub_version;
+    rec[33] = idlen;
+    put_le16 (rec+34, h->extra_len);
+    put_le32 (rec+36, data_len);
+    memcpy (rec + MS3_FIXED_HDR_LEN, h->sid, idlen);
+    if (h->extra_len > 0)
+	memcpy (rec + MS3_FIXED_HDR_LEN + idlen, h->extra, h->extra_len);
+    memcpy (rec + off, data, data_len);
+    h->crc = ms3_crc32c (0, rec, off + data_len);
+    put_le32 (rec + MS3_CRC_OFFSET, h->crc);
+    return (off + data_len);
+}
+
+/************************************************************************/
+/*  ms3_pack:								*/
+/*	Pack as many samples as fit in maxlen bytes into a miniSEED 3	*/
+/*	record, in the encoding h->data_type, with the SEED 2 packing	*/
+/*	routines.  Integer formats are packed from int data, and	*/
+/*	floating point formats from float or double data.  The source	*/
+/*	id is built from the SEED 2 names if h->sid is empty.  Since	*/
+/*	records have no padding, the record is only as long as its	*/
+/*	data.  On return, h->begtime and h->xm1 are set for the next	*/
+/*	record, so that a series of samples can be packed by repeated	*/
+/*	calls.								*/
+/*  return:	length of record on success, error code on error.	*/
+/************************************************************************/
+int ms3_pack
+   (MS3_HDR	*h,		/* ptr to header for record.		*/
+    void	*data,		/* ptr to samples.			*/
+    int		num_samples,	/* # of samples available.		*/
+    char	*rec,		/* output buffer for record.		*/
+    int		maxlen,		/* max length of record.		*/
+    int		*n_samples)	/* # of samples packed (returned).	*/
+{
+    SAMPLE_CLOCK sc;
+    char	*pbuf;
+    int		*idata = (int *)data;
+    int		*diff = NULL;
+    int		avail, nf, nd, nbytes = 0, n = 0;
+    int		status = 0, i;
+    int64_t	d64;
+
+    *n_samples = 0;
+    if (h->sid[0] == '\0')
+	ms3_sncl_to_sid (h->network_id, h->station_id, h->location_id,
+			 h->channel_id, h->sid);
+    avail = maxlen - MS3_FIXED_HDR_LEN - (int)strlen (h->sid) - h->extra_len;
+    if (avail < 0 || (avail < 64 && IS_STEIM_COMP(h->data_type) &&
+		      num_samples > 0)) {
+	fprintf (stderr, "Error: record length %d too small in ms3_pack\n",
+		 maxlen);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    if (num_samples < 0) num_samples = 0;
+    nf = avail / 64;
+    /* Limit the differences to those that could fit in nf frames.	*/
+    nd = (num_samples < nf * 8 * VALS_PER_FRAME) ?
+	num_samples : nf * 8 * VALS_PER_FRAME;
+    if ((pbuf = (char *)malloc (avail + 8)) == NULL ||
+	(IS_STEIM_COMP(h->data_type) && nd > 0 &&
+	 (diff = (int *)malloc (nd * sizeof(int))) == NULL)) {
+	if (pbuf) free (pbuf);
+	fprintf (stderr, "Error: unable to malloc buffer in ms3_pack\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    if (num_samples > 0) switch (h->data_type) {
+      case STEIM1:
+      case STEIM2:
+	diff[0] = idata[0] - h->xm1;
+	for (i=1; i<nd; i++) {
+	    /* Out of range differences raise an error in the packer.	*/
+	    d64 = (int64_t)idata[i] - (int64_t)idata[i-1];
+	    if (d64 > INT_MAX) d64 = INT_MAX;
+	    if (d64 < INT_MIN) d64 = INT_MIN;
+	    diff[i] = (int)d64;
+	}
+	if (h->data_type == STEIM1)
+	    status = pack_steim1 ((SDF *)pbuf, idata, diff, nd, nf, 0,
+				  SEED_BIG_ENDIAN, &nf, &n);
+	else
+	    status = pack_steim2 ((SDF *)pbuf, idata, diff, nd, nf, 0,
+				  SEED_BIG_ENDIAN, &nf, &n);
+	nbytes = nf * 64;
+	break;
+      case INT_16:
+	status = pack_int_16 ((short int *)pbuf, idata, num_samples, avail, 0,
+			      SEED_LITTLE_ENDIAN, &nbytes, &n);
+	break;
+      case INT_32:
+	status = pack_int_32 ((int *)pbuf, idata, num_samples, avail, 0,
+			      SEED_LITTLE_ENDIAN, &nbytes, &n);
+	break;
+      case IEEE_FP_SP:
+	status = pack_fp_sp ((float *)pbuf, (float *)data, num_samples, avail,
+			     0, SEED_LITTLE_ENDIAN, &nbytes, &n);
+	break;
+      case IEEE_FP_DP:
+	status = pack_fp_dp ((double *)pbuf, (double *)data, num_samples,
+			     avail, 0, SEED_LITTLE_ENDIAN, &nbytes, &n);
+	break;
+      case UNKNOWN_DATATYPE:
+	n = nbytes = (num_samples < avail) ? num_samples : avail;
+	memcpy (pbuf, data, n);
+	break;
+      default:
+	fprintf (stderr, "Error: unable to pack encoding %d in ms3_pack\n",
+		 h->data_type);
+	fflush (stderr);
+	status = MS_ERROR;
+	break;
+    }
+    if (diff) free ((char *)diff);
+    if (status != 0) {
+	free (pbuf);
+	return ((status < 0) ? status : MS_ERROR);
+    }
+    status = ms3_write (h, pbuf, nbytes, n, rec, maxlen);
+    free (pbuf);
+    if (status < 0) return (status);
+
+    /* Set the header for the next record.				*/
+    *n_samples = n;
+    if (n > 0 && h->data_type != IEEE_FP_SP && h->data_type != IEEE_FP_DP &&
+	h->data_type != UNKNOWN_DATATYPE) h->xm1 = idata[n-1];
+    if (n > 0 && h->sample_rate > 0 &&
+	init_sample_clock_sps (&sc, h->begtime, h->sample_rate) == 0)
+	h->begtime = sample_clock_time (&sc, n);
+    return (status);
+}
+
+/************************************************************************/
+/*  ms3_read_record:							*/
+/*	Read the next miniSEED 3 record from a file into a buffer,	*/
+/*	which is grown as needed.  *prec may be NULL initially, and	*/
+/*	the caller must free it.  The record is not verified; use	*/
+/*	ms3_parse_hdr to decode its header and verify its CRC.		*/
+/*  return:								*/
+/*	length of record on success.					*/
+/*	EOF on eof.							*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms3_read_record
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    char	**prec,		/* ptr to record buffer (updated).	*/
+    int		*pbuflen)	/* length of record buffer (updated).	*/
+{
+    char	hdr[MS3_FIXED_HDR_LEN];
+    char	*p;
+    int		nread, reclen;
+
+    if ((nread = fread (hdr, 1, MS3_FIXED_HDR_LEN, fp)) != MS3_FIXED_HDR_LEN)
+	return ((nread == 0) ? EOF : MS_ERROR);
+    if ((reclen = ms3_record_length (hdr, MS3_FIXED_HDR_LEN)) <= 0)
+	return (MS_ERROR);
+    if (*prec == NULL || *pbuflen < reclen) {
+	if ((p = (char *)realloc (*prec, reclen)) == NULL) {
+	    fprintf (stderr,
+		     "Error: unable to malloc record in ms3_read_record\n");
+	    fflush (stderr);
+	    if (QLIB2_CLASSIC) exit(1);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	*prec = p;
+	*pbuflen = reclen;
+    }
+    memcpy (*prec, hdr, MS3_FIXED_HDR_LEN);
+    if (fread (*prec + MS3_FIXED_HDR_LEN, 1, reclen - MS3_FIXED_HDR_LEN, fp) !=
+	(size_t)(reclen - MS3_FIXED_HDR_LEN)) return (MS_ERROR);
+    return (reclen);
+}
+
+/************************************************************************/
+/*  steim_frames_used:							*/
+/*	Determine the number of Steim frames of a big endian record	*/
+/*	that hold its samples, by counting the differences in each	*/
+/*	word from the control words, without decoding them.		*/
+/*  return:	# of frames.						*/
+/************************************************************************/
+static int steim_frames_used
+   (unsigned char *p,		/* ptr to first frame.			*/
+    int		nframes,	/* # of frames in record.		*/
+    int		ns,		/* # of samples in record.		*/
+    int		steim2)		/* 1 for Steim2, 0 for Steim1.		*/
+{
+    static int	steim1_count[4] = { 0, 4, 2, 1 };
+    static int	steim2_count[4][4] = {
+	{ 0, 0, 0, 0 }, { 4, 4, 4, 4 }, { 0, 1, 2, 3 }, { 5, 6, 7, 0 } };
+    unsigned int ctrl;
+    unsigned char *w;
+    int		count = 0;
+    int		f, i, nib;
+
+    for (f=0; f<nframes; f++) {
+	ctrl = ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) |
+	    ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+	for (i=1; i<VALS_PER_FRAME+1; i++) {
+	    nib = (ctrl >> (30 - 2*i)) & 3;
+	    w = p + 4*i;
+	    count += (steim2) ?
+		steim2_count[nib][w[0] >> 6] : steim1_count[nib];
+	}
+	p += 64;
+	if (count >= ns) return (f + 1);
+    }
+    return (nframes);
+}
+
+/************************************************************************/
+/*  ms2_to_ms3:								*/
+/*	Convert a SEED 2 miniSEED data record to a miniSEED 3 record.	*/
+/*	Big endian Steim frames are copied without decoding, and only	*/
+/*	the frames holding samples are kept.  INT_16, INT_32, floating	*/
+/*	point and text data are copied and converted to little endian.	*/
+/*	Other data, such as little endian Steim or INT_24 data, is	*/
+/*	decoded and packed again, with INT_24 written as INT_32.  The	*/
+/*	quality indicator is written as the publication version, and	*/
+/*	the timing quality of a blockette 1001 as an extra header.	*/
+/*  return:	length of record on success, error code on error.	*/
+/************************************************************************/
+int ms2_to_ms3
+   (char	*ms,		/* ptr to SEED 2 miniSEED record.	*/
+    int		nbytes,		/* # of bytes in record.		*/
+    char	*rec,		/* output buffer for record.		*/
+    int		maxlen)		/* length of output buffer.		*/
+{
+    DATA_HDR	*hdr;
+    MS3_HDR	h;
+    BS		*bs;
+    char	extra[MS3_EXTRA_LEN];
+    char	*src, *pbuf = NULL, c;
+    int		*data;
+    int		size = 0, len = 0, space, nf, i, j, n;
+    int		status;
+
+    if ((hdr = decode_hdr_sdr ((SDR_HDR *)ms, nbytes)) == NULL)
+	return (MS_ERROR);
+    if (! is_data_hdr_ind (hdr->record_type) || hdr->blksize > nbytes ||
+	hdr->first_data > hdr->blksize) {
+	free_data_hdr (hdr);
+	return (MS_ERROR);
+    }
+    memset ((char *)&h, 0, sizeof(MS3_HDR));
+    ms3_sncl_to_sid (hdr->network_id, hdr->station_id, hdr->location_id,
+		     hdr->channel_id, h.sid);
+    h.begtime = hdr->begtime;
+    if (hdr->activity_flags & 0x01) h.flags |= MS3_FLAG_CALIBRATION;
+    if (hdr->data_quality_flags & 0x80) h.flags |= MS3_FLAG_TIME_QUESTIONABLE;
+    if (hdr->io_flags & 0x20) h.flags |= MS3_FLAG_CLOCK_LOCKED;
+    h.data_type = hdr->data_type;
+    h.sample_rate = (hdr->rate_spsec > 0) ? hdr->rate_spsec :
+	sps_rate (hdr->sample_rate, hdr->sample_rate_mult);
+    switch (hdr->record_type) {
+      case 'R': h.pub_version = 1; break;
+      case 'Q': h.pub_version = 3; break;
+      case 'M': h.pub_version = 4; break;
+      default: h.pub_version = 2; break;
+    }
+    if ((bs = find_blockette (hdr, 1001))) {
+	sprintf (extra, "{\"FDSN\":{\"Time\":{\"Quality\":%d}}}",
+		 ((BLOCKETTE_1001 *)bs->pb)->clock_quality);
+	h.extra = extra;
+	h.extra_len = strlen (extra);
+    }
+
+    src = ms + hdr->first_data;
+    space = hdr->blksize - hdr->first_data;
+    switch (hdr->data_type) {
+      case STEIM1:
+      case STEIM2:
+	if (hdr->data_wordorder != SEED_BIG_ENDIAN) break;
+	nf = space / 64;
+	if (bs && ((BLOCKETTE_1001 *)bs->pb)->frame_count > 0 &&
+	    ((BLOCKETTE_1001 *)bs->pb)->frame_count <= nf)
+	    nf = ((BLOCKETTE_1001 *)bs->pb)->frame_count;
+	else if (hdr->num_samples > 0)
+	    nf = steim_frames_used ((unsigned char *)src, nf, hdr->num_samples,
+				    hdr->data_type == STEIM2);
+	else nf = 0;
+	len = nf * 64;
+	pbuf = src;
+	break;
+      case INT_16: size = 2; break;
+      case INT_32: size = 4; break;
+      case IEEE_FP_SP: size = 4; break;
+      case IEEE_FP_DP: size = 8; break;
+      case UNKNOWN_DATATYPE: size = 1; break;
+      default: break;
+    }
+    if (size > 0) {
+	len = hdr->num_samples * size;
+	if (len > space || (pbuf = (char *)malloc (len + 1)) == NULL) {
+	    free_data_hdr (hdr);
+	    return (MS_ERROR);
+	}
+	memcpy (pbuf, src, len);
+	if (size > 1 && hdr->data_wordorder == SEED_BIG_ENDIAN) {
+	    for (i=0; i<len; i+=size) {
+		for (j=0; j<size/2; j++) {
+		    c = pbuf[i+j];
+		    pbuf[i+j] = pbuf[i+size-1-j];
+		    pbuf[i+size-1-j] = c;
+		}
+	    }
+	}
+    }
+    if (pbuf) {
+	status = ms3_write (&h, pbuf, len, hdr->num_samples, rec, maxlen);
+	if (pbuf != src) free (pbuf);
+	free_data_hdr (hdr);
+	return (status);
+    }
+
+    /* Decode the samples and pack them again.				*/
+    if (h.data_type == INT_24) h.data_type = INT_32;
+    if ((data = (int *)malloc ((hdr->num_samples + 1) * sizeof(int))) == NULL) {
+	fprintf (stderr, "Error: unable to malloc data in ms2_to_ms3\n");
+	fflush (stderr);
+	free_data_hdr (hdr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    status = n = ms_unpack (hdr, hdr->num_samples, ms, data);
+    h.xm1 = hdr->xm1;
+    if (n >= 0) status = ms3_pack (&h, data, n, rec, maxlen, &i);
+    if (status >= 0 && i < n) status = MS_ERROR;
+    free ((char *)data);
+    free_data_hdr (hdr);
+    return (status);
+}
+
+/************************************************************************/
+/*  ms3_timing_quality:							*/
+/*	Find the timing quality in the extra headers of a record.	*/
+/*  return:	timing quality, or -1 if none.				*/
+/************************************************************************/
+static int ms3_timing_quality
+   (MS3_HDR	*h)		/* ptr to header of record.		*/
+{
+    char	extra[1024];
+    char	*p;
+    int		q;
+
+    if (h->extra_len <= 0 || h->extra_len >= (int)sizeof(extra)) return (-1);
+    memcpy (extra, h->extra, h->extra_len);
+    extra[h->extra_len] = '\0';
+    if ((p = strstr (extra, "\"Time\"")) == NULL ||
+	(p = strstr (p, "\"Quality\"")) == NULL ||
+	(p = strchr (p, ':')) == NULL) return (-1);
+    q = atoi (p+1);
+    return ((q >= 0 && q <= 100) ? q : -1);
+}
+
+/************************************************************************/
+/*  ms3_to_ms2:								*/
+/*	Convert a miniSEED 3 record to SEED 2 miniSEED records of	*/
+/*	blksize bytes, using ms_pack2_data.  Records whose source id	*/
+/*	has no SEED 2 names, or whose encoding has no SEED 2 format,	*/
+/*	cannot be converted.  A blockette 100 is added if the sample	*/
+/*	rate cannot be represented exactly by the rate and multiplier,	*/
+/*	and a blockette 1001 if the time has sub-100 usecs or the	*/
+/*	record has a timing quality.  Nanoseconds beyond the usec are	*/
+/*	dropped.  Memory for the records is handled as in ms_pack2.	*/
+/*  return:	# of samples packed on success, error code on error.	*/
+/************************************************************************/
+int ms3_to_ms2
+   (char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		nbytes,		/* # of bytes in record.		*/
+    int		blksize,	/* blksize of SEED 2 records.		*/
+    char	**pp_ms,	/* ptr **miniSEED (returned).		*/
+    int		ms_len,		/* miniSEED buffer len (if supplied).	*/
+    int		*n_blocks)	/* # miniSEED blocks (returned).	*/
+{
+    DATA_HDR	*hdr;
+    MS3_HDR	h;
+    BLOCKETTE_100 b100;
+    BLOCKETTE_1001 b1001;
+    double	*data;
+    double	p;
+    int		n, npacked = 0, tq, status;
+
+    *n_blocks = 0;
+    if ((status = ms3_parse_hdr (rec, nbytes, &h)) <= 0)
+	return ((status == 0) ? MS_ERROR : status);
+    if (h.channel_id[0] == '\0') {
+	fprintf (stderr, "Error: no SEED 2 channel for %s in ms3_to_ms2\n",
+		 h.sid);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    switch (h.data_type) {
+      case STEIM1: case STEIM2: case INT_16: case INT_32:
+      case IEEE_FP_SP: case IEEE_FP_DP: case UNKNOWN_DATATYPE:
+	break;
+      default:
+	fprintf (stderr,
+		 "Error: no SEED 2 format for encoding %d in ms3_to_ms2\n",
+		 h.data_type);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    data = (double *)malloc ((h.num_samples + 1) * sizeof(double));
+    if (data == NULL ||
+	(hdr = new_data_hdr ()) == NULL) {
+	if (data) free ((char *)data);
+	fprintf (stderr, "Error: unable to malloc data in ms3_to_ms2\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    if ((n = ms3_unpack (&h, rec, h.num_samples, data)) < 0) {
+	free ((char *)data);
+	free_data_hdr (hdr);
+	return (n);
+    }
+
+    strcpy (hdr->station_id, h.station_id);
+    strcpy (hdr->location_id, h.location_id);
+    strcpy (hdr->channel_id, h.channel_id);
+    strcpy (hdr->network_id, h.network_id);
+    hdr->begtime = hdr->hdrtime = h.begtime;
+    hdr->num_samples = n;
+    hdr->data_type = h.data_type;
+    hdr->blksize = blksize;
+    hdr->hdr_wordorder = hdr->data_wordorder = SEED_BIG_ENDIAN;
+    switch (h.pub_version) {
+      case 1: hdr->record_type = 'R'; break;
+      case 3: hdr->record_type = 'Q'; break;
+      case 4: hdr->record_type = 'M'; break;
+      default: hdr->record_type = 'D'; break;
+    }
+    if (h.flags & MS3_FLAG_CALIBRATION) hdr->activity_flags |= 0x01;
+    if (h.flags & MS3_FLAG_TIME_QUESTIONABLE) hdr->data_quality_flags |= 0x80;
+    if (h.flags & MS3_FLAG_CLOCK_LOCKED) hdr->io_flags |= 0x20;
+    hdr->xm1 = h.xm1;
+
+    /* Use an integer rate or period if possible, and a blockette 100	*/
+    /* for any other rate.						*/
+    hdr->sample_rate = 0;
+    hdr->sample_rate_mult = 1;
+    if (h.sample_rate >= 1.) {
+	p = floor (h.sample_rate + 0.5);
+	hdr->sample_rate = (p > 32767) ? 32767 : (int)p;
+    }
+    else if (h.sample_rate > 0) {
+	p = floor (1. / h.sample_rate + 0.5);
+	hdr->sample_rate = (p > 32767) ? -32767 : -(int)p;
+    }
+    status = 0;
+    if (my_wordorder < 0) get_my_wordorder();
+    if (sps_rate (hdr->sample_rate, hdr->sample_rate_mult) != h.sample_rate) {
+	memset ((char *)&b100, 0, sizeof(b100));
+	b100.hdr.type = 100;
+	b100.actual_rate = h.sample_rate;
+	if (! add_blockette (hdr, (char *)&b100, 100, sizeof(BLOCKETTE_100),
+			     my_wordorder, -1)) status = MS_ERROR;
+    }
+    tq = ms3_timing_quality (&h);
+    if (tq >= 0 || hdr->hdrtime.usec % 100 != 0) {
+	memset ((char *)&b1001, 0, sizeof(b1001));
+	b1001.hdr.type = 1001;
+	b1001.clock_quality = (tq >= 0) ? tq : 0;
+	if (! add_blockette (hdr, (char *)&b1001, 1001, sizeof(BLOCKETTE_1001),
+			     my_wordorder, -1)) status = MS_ERROR;
+    }
+    if (status == 0)
+	status = ms_pack2_data (hdr, NULL, n, data, n_blocks, &npacked, pp_ms,
+				ms_len, NULL);
+    free ((char *)data);
+    free_data_hdr (hdr);
+    return ((status < 0) ? status : npacked);
+}
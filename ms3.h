@@ -0,0 +1,152 @@
+/************************************************************************/
+/*  Routines for FDSN miniSEED version 3 records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#ifndef	__ms3_h
+#define	__ms3_h
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "timedef.h"
+#include "data_hdr.h"
+
+#define	MS3_FIXED_HDR_LEN	40	/* length of fixed header.	*/
+#define	MS3_SID_LEN		255	/* max length of source id.	*/
+#define	MS3_FORMAT_VERSION	3	/* miniSEED format version.	*/
+
+/*	Flags in the fixed header.					*/
+#define	MS3_FLAG_CALIBRATION	0x01	/* calibration signals present.	*/
+#define	MS3_FLAG_TIME_QUESTIONABLE 0x02	/* time tag is questionable.	*/
+#define	MS3_FLAG_CLOCK_LOCKED	0x04	/* clock locked.		*/
+
+/*	Header of a miniSEED 3 record.					*/
+
+typedef struct _ms3_hdr {
+    char	sid[MS3_SID_LEN+1];	/* FDSN source identifier.	*/
+    char	station_id[DH_STATION_LEN+1];	/* station name.	*/
+    char	location_id[DH_LOCATION_LEN+1];	/* location id.		*/
+    char	channel_id[DH_CHANNEL_LEN+1];	/* channel name.	*/
+    char	network_id[DH_NETWORK_LEN+1];	/* network id.		*/
+    int		sncl_id;	/* SNCL id of channel, MS_SNCL_NONE	*/
+				/* until assigned by the caller.	*/
+    INT_TIME	begtime;	/* time of first sample.		*/
+    int		nsec;		/* nanoseconds beyond begtime (0-999).	*/
+    int		flags;		/* MS3_FLAG_* flags.			*/
+    int		data_type;	/* data encoding, as in blockette 1000.	*/
+    double	sample_rate;	/* samples per second, or 0.		*/
+    int		num_samples;	/* # of samples in record.		*/
+    int		pub_version;	/* data publication version.		*/
+    int		xm1;		/* sample before x0, for Steim.		*/
+    unsigned int crc;		/* CRC-32C of record.			*/
+    char	*extra;		/* extra headers (JSON), or NULL.	*/
+    int		extra_len;	/* length of extra headers.		*/
+    int		data_offset;	/* offset of data in record.		*/
+    int		data_len;	/* length of data in bytes.		*/
+    int		reclen;		/* length of record in bytes.		*/
+} MS3_HDR;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern unsigned int ms3_crc32c
+   (unsigned int crc,		/* CRC of preceding bytes, or 0.	*/
+    char	*buf,		/* ptr to bytes.			*/
+    size_t	len);		/* # of bytes.				*/
+
+extern int ms3_sid_to_sncl
+   (char	*sid,		/* FDSN source identifier.		*/
+    char	*network,	/* network name (returned).		*/
+    char	*station,	/* station name (returned).		*/
+    char	*location,	/* location name (returned).		*/
+    char	*channel);	/* channel name (returned).		*/
+
+extern void ms3_sncl_to_sid
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    char	*sid);		/* FDSN source identifier (returned).	*/
+
+extern int ms3_record_length
+   (char	*rec,		/* ptr to start of miniSEED 3 record.	*/
+    int		nbytes);	/* # of bytes of record available.	*/
+
+extern int ms3_parse_hdr
+   (char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		nbytes,		/* # of bytes of record available.	*/
+    MS3_HDR	*h);		/* decoded header (returned).		*/
+
+extern int ms3_unpack
+   (MS3_HDR	*h,		/* ptr to header of record.		*/
+    char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		max_num_points,	/* max # of samples to return.		*/
+    void	*data_buffer);	/* ptr to output data buffer.		*/
+
+extern int ms3_pack
+   (MS3_HDR	*h,		/* ptr to header for record.		*/
+    void	*data,		/* ptr to samples.			*/
+    int		num_samples,	/* # of samples available.		*/
+    char	*rec,		/* output buffer for record.		*/
+    int		maxlen,		/* max length of record.		*/
+    int		*n_samples);	/* # of samples packed (returned).	*/
+
+extern int ms3_read_record
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    char	**prec,		/* ptr to record buffer (updated).	*/
+    int		*pbuflen);	/* length of record buffer (updated).	*/
+
+extern int ms2_to_ms3
+   (char	*ms,		/* ptr to SEED 2 miniSEED record.	*/
+    int		nbytes,		/* # of bytes in record.		*/
+    char	*rec,		/* output buffer for record.		*/
+    int		maxlen);	/* length of output buffer.		*/
+
+extern int ms3_to_ms2
+   (char	*rec,		/* ptr to miniSEED 3 record.		*/
+    int		nbytes,		/* # of bytes in record.		*/
+    int		blksize,	/* blksize of SEED 2 records.		*/
+    char	**pp_ms,	/* ptr **miniSEED (returned).		*/
+    int		ms_len,		/* miniSEED buffer len (if supplied).	*/
+    int		*n_blocks);	/* # miniSEED blocks (returned).	*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,345 @@
+/************************************************************************/
+/*  Routines for demultiplexing MiniSEED records by channel.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qtime.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_unpack.h"
+#include "ms_reader.h"
+#include "ms_sncl.h"
+#include "ms_demux.h"
+
+#define	DEMUX_NCHANS	64	/* # of channels to allocate at a time.	*/
+#define	DEMUX_INCREMENT	1024	/* # of items to allocate at a time.	*/
+
+/************************************************************************/
+/*  demux_add:								*/
+/*	Add a channel for the record with the specified header, and	*/
+/*	enter it in the array of channels indexed by SNCL id.		*/
+/*  return:	ptr to channel, or NULL on malloc error.		*/
+/************************************************************************/
+static MS_DEMUX_CHAN *demux_add
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    DATA_HDR	*hdr)		/* ptr to DATA_HDR of record.		*/
+{
+    MS_DEMUX_CHAN *c;
+    int		n, i;
+    void	*p;
+
+    if (hdr->sncl_id >= dm->nbyid) {
+	n = (dm->nbyid > 0) ? 2 * dm->nbyid : DEMUX_NCHANS;
+	while (n <= hdr->sncl_id) n *= 2;
+	if ((p = realloc (dm->byid, n * sizeof(MS_DEMUX_CHAN *))) == NULL)
+	    return (NULL);
+	dm->byid = (MS_DEMUX_CHAN **)p;
+	for (i=dm->nbyid; i<n; i++) dm->byid[i] = NULL;
+	dm->nbyid = n;
+    }
+    if (dm->nchans % DEMUX_NCHANS == 0) {
+	if ((p = realloc (dm->chan, (dm->nchans + DEMUX_NCHANS) * 
+			  sizeof(MS_DEMUX_CHAN *))) == NULL) return (NULL);
+	dm->chan = (MS_DEMUX_CHAN **)p;
+    }
+    if ((c = (MS_DEMUX_CHAN *)calloc (1, sizeof(MS_DEMUX_CHAN))) == NULL)
+	return (NULL);
+    strcpy (c->station_id, hdr->station_id);
+    strcpy (c->location_id, hdr->location_id);
+    strcpy (c->channel_id, hdr->channel_id);
+    strcpy (c->network_id, hdr->network_id);
+    c->index = dm->nchans;
+    c->sncl_id = hdr->sncl_id;
+    c->sample_rate = hdr->sample_rate;
+    c->sample_rate_mult = hdr->sample_rate_mult;
+    dm->byid[hdr->sncl_id] = c;
+    dm->chan[dm->nchans++] = c;
+    return (c);
+}
+
+/************************************************************************/
+/*  demux_gap:								*/
+/*	Record a gap or overlap before the next sample of a channel.	*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int demux_gap
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    MS_DEMUX_CHAN *c,		/* ptr to channel.			*/
+    INT_TIME	actual,		/* actual time of next sample.		*/
+    double	gap)		/* usecs from expected time.		*/
+{
+    MS_DEMUX_GAP *g;
+    void	*p;
+
+    if (dm->ngaps % DEMUX_INCREMENT == 0) {
+	if ((p = realloc (dm->gap, (dm->ngaps + DEMUX_INCREMENT) * 
+			  sizeof(MS_DEMUX_GAP))) == NULL) 
+	    return (QLIB2_MALLOC_ERROR);
+	dm->gap = (MS_DEMUX_GAP *)p;
+    }
+    g = &dm->gap[dm->ngaps++];
+    g->chan = c->index;
+    g->sample_index = c->nsamples;
+    g->expected = c->next;
+    g->actual = actual;
+    g->gap = gap;
+    if (gap < 0) c->noverlaps++;
+    else c->ngaps++;
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_demux_init:							*/
+/*	Initialize a demultiplexer.					*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+int ms_demux_init
+   (MS_DEMUX	*dm)		/* ptr to MS_DEMUX.			*/
+{
+    memset ((char *)dm, 0, sizeof(MS_DEMUX));
+    return (qlib2_ctx_init (&dm->ctx));
+}
+
+/************************************************************************/
+/*  ms_demux_free:							*/
+/*	Free the storage in a demultiplexer, including the channel	*/
+/*	sample buffers.							*/
+/************************************************************************/
+void ms_demux_free
+   (MS_DEMUX	*dm)		/* ptr to MS_DEMUX.			*/
+{
+    int		i;
+
+    for (i=0; i<dm->nchans; i++) {
+	if (dm->chan[i]->data) free ((char *)dm->chan[i]->data);
+	free ((char *)dm->chan[i]);
+    }
+    if (dm->chan) free ((char *)dm->chan);
+    if (dm->byid) free ((char *)dm->byid);
+    if (dm->gap) free ((char *)dm->gap);
+    qlib2_ctx_free (&dm->ctx);
+    memset ((char *)dm, 0, sizeof(MS_DEMUX));
+}
+
+/************************************************************************/
+/*  ms_demux_record:							*/
+/*	Decode the samples of a MiniSEED record and append them to the	*/
+/*	buffer of the record's channel, which is found by the SNCL id	*/
+/*	of the record's header.  A gap or overlap is recorded when the	*/
+/*	record does not start within half a sample of the time		*/
+/*	expected from the channel's previous record, or when its	*/
+/*	sample rate differs.  Volume headers and records without	*/
+/*	samples are ignored.  Only integer data formats can be		*/
+/*	demultiplexed.  Error messages are returned in dm->ctx.errmsg.	*/
+/*  return:								*/
+/*	# of samples on success.					*/
+/*	MS_ERROR if the record cannot be decoded.			*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int ms_demux_record
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*rec,		/* ptr to MiniSEED record.		*/
+    int		blksize)	/* size of record.			*/
+{
+    MS_DEMUX_CHAN *c;
+    DATA_HDR	*hdr;
+    SAMPLE_CLOCK sc;
+    double	half, d = 0;
+    int64_t	k;
+    int		n, status, timed;
+    void	*p;
+
+    if (blksize <= 6 || is_vol_hdr_ind (rec[6])) return (0);
+    if ((hdr = decode_hdr_sdr_ctx (&dm->ctx, (SDR_HDR *)rec, blksize)) == NULL)
+	return (MS_ERROR);
+    if ((n = hdr->num_samples) <= 0) {
+	free_data_hdr (hdr);
+	return (0);
+    }
+    switch (hdr->data_type) {
+      case STEIM1:
+      case STEIM2:
+      case INT_16:
+      case INT_24:
+      case INT_32:
+	break;
+      default:
+	sprintf (dm->ctx.errmsg, "Error: unable to demultiplex format %d for %s.%s.%s.%s\n",
+		 hdr->data_type, hdr->network_id, hdr->station_id, 
+		 hdr->location_id, hdr->channel_id);
+	free_data_hdr (hdr);
+	return (MS_ERROR);
+    }
+
+    if (hdr->sncl_id < 0 &&
+	(hdr->sncl_id = ms_sncl_id (hdr->network_id, hdr->station_id,
+				    hdr->location_id, hdr->channel_id)) < 0) {
+	status = hdr->sncl_id;
+	free_data_hdr (hdr);
+	return (status);
+    }
+    if ((c = (hdr->sncl_id < dm->nbyid) ? dm->byid[hdr->sncl_id] : NULL) == NULL &&
+	(c = demux_add (dm, hdr)) == NULL) {
+	free_data_hdr (hdr);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Make room for the samples, and decode them in place.		*/
+    if (c->nsamples + n > c->maxsamples) {
+	k = (c->maxsamples > 0) ? 2 * c->maxsamples : DEMUX_INCREMENT;
+	while (k < c->nsamples + n) k *= 2;
+	if ((p = realloc (c->data, k * sizeof(int))) == NULL) {
+	    free_data_hdr (hdr);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	c->data = (int *)p;
+	c->maxsamples = k;
+    }
+    status = ms_unpack_ctx (&dm->ctx, hdr, n, rec, c->data + c->nsamples);
+    if (status != n) {
+	free_data_hdr (hdr);
+	return ((status < 0) ? status : MS_ERROR);
+    }
+
+    /* Check continuity with the channel's previous record.		*/
+    timed = (init_sample_clock_hdr (&sc, hdr) == 0);
+    if (c->nrecords > 0 && timed) {
+	half = 0.5 * USECS_PER_SEC * (double)sc.den / (double)sc.num;
+	d = tdiff (hdr->begtime, c->next);
+	if (d < -half || d > half || c->sample_rate != hdr->sample_rate ||
+	    c->sample_rate_mult != hdr->sample_rate_mult) {
+	    if (demux_gap (dm, c, hdr->begtime, d) < 0) {
+		free_data_hdr (hdr);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	}
+    }
+    if (c->nrecords == 0) c->begtime = hdr->begtime;
+    c->sample_rate = hdr->sample_rate;
+    c->sample_rate_mult = hdr->sample_rate_mult;
+    c->next = (timed) ? sample_clock_time (&sc, n) : hdr->endtime;
+    c->nsamples += n;
+    c->nrecords++;
+    dm->nsamples += n;
+    dm->nrecords++;
+    free_data_hdr (hdr);
+    return (n);
+}
+
+/************************************************************************/
+/*  ms_demux_reader:							*/
+/*	Demultiplex the remaining records of an MS_READER.  Records	*/
+/*	that cannot be decoded are counted in dm->nerrors and skipped.	*/
+/*  return:								*/
+/*	# of channels on success.					*/
+/*	MS_ERROR if the input is not MiniSEED.				*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int ms_demux_reader
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    MS_READER	*r)		/* ptr to MS_READER.			*/
+{
+    char	*rec;
+    int		n, status;
+
+    while ((n = ms_reader_next (r, &rec)) > 0) {
+	if ((status = ms_demux_record (dm, rec, n)) == QLIB2_MALLOC_ERROR) {
+	    fprintf (stderr, "Error: unable to malloc data in ms_demux_reader\n");
+	    fflush (stderr);
+	    if (QLIB2_CLASSIC) exit(1);
+	    return (status);
+	}
+	if (status < 0) dm->nerrors++;
+    }
+    if (n != EOF) {
+	fprintf (stderr, "Error: invalid MiniSEED record at offset %lld in ms_demux_reader\n",
+		 (long long)r->offset);
+	fflush (stderr);
+	return (n);
+    }
+    return (dm->nchans);
+}
+
+/************************************************************************/
+/*  ms_demux_file:							*/
+/*	Demultiplex the records of a plain or compressed MiniSEED file.	*/
+/*  return:								*/
+/*	# of channels on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_demux_file
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*filename)	/* name of MiniSEED file.		*/
+{
+    MS_READER	*r;
+    int		status;
+
+    if ((r = ms_reader_open (filename, MS_READER_AUTO)) == NULL) 
+	return (MS_ERROR);
+    status = ms_demux_reader (dm, r);
+    ms_reader_close (r);
+    return (status);
+}
+
+/************************************************************************/
+/*  ms_demux_find:							*/
+/*	Find a channel of a demultiplexer by name.  A location of "--"	*/
+/*	matches a blank location.					*/
+/*  return:	ptr to channel, or NULL if not found.			*/
+/************************************************************************/
+MS_DEMUX_CHAN *ms_demux_find
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    int		id;
+
+    if (strcmp (location, "--") == 0) location = "";
+    id = ms_sncl_find (network, station, location, channel);
+    return ((id >= 0 && id < dm->nbyid) ? dm->byid[id] : NULL);
+}
@@ -0,0 +1,130 @@
+/************************************************************************/
+/*  Routines for demultiplexing MiniSEED records by channel.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_demux_h
+#define	__ms_demux_h
+
+#include <sys/types.h>
+#include "timedef.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "ms_reader.h"
+
+/*	Samples and time state of one channel of a demultiplexer.	*/
+
+typedef struct _ms_demux_chan {
+    char	station_id[DH_STATION_LEN+1];	/* station name.	*/
+    char	location_id[DH_LOCATION_LEN+1];	/* location id.		*/
+    char	channel_id[DH_CHANNEL_LEN+1];	/* channel name.	*/
+    char	network_id[DH_NETWORK_LEN+1];	/* network id.		*/
+    int		index;		/* index of channel in demux->chan.	*/
+    int		sncl_id;	/* interned SNCL id of channel.		*/
+    int		sample_rate;	/* sample rate in qlib convention.	*/
+    int		sample_rate_mult;/* rate_mult in qlib convention.	*/
+    INT_TIME	begtime;	/* time of first sample.		*/
+    INT_TIME	next;		/* expected time of next sample.	*/
+    int64_t	nsamples;	/* # of samples in data.		*/
+    int64_t	maxsamples;	/* # of samples allocated for data.	*/
+    int		*data;		/* samples, in record order.		*/
+    int		nrecords;	/* # of records.			*/
+    int		ngaps;		/* # of gaps.				*/
+    int		noverlaps;	/* # of overlaps.			*/
+} MS_DEMUX_CHAN;
+
+/*	A gap or overlap found by a demultiplexer.			*/
+
+typedef struct _ms_demux_gap {
+    int		chan;		/* index of channel in demux->chan.	*/
+    int64_t	sample_index;	/* index in channel data of first	*/
+				/* sample after the discontinuity.	*/
+    INT_TIME	expected;	/* expected time of the sample.		*/
+    INT_TIME	actual;		/* actual time of the sample.		*/
+    double	gap;		/* usecs from expected to actual time,	*/
+				/* negative for an overlap.		*/
+} MS_DEMUX_GAP;
+
+/*	State of a demultiplexer.					*/
+
+typedef struct _ms_demux {
+    int		nchans;		/* # of channels.			*/
+    MS_DEMUX_CHAN **chan;	/* channels, in order of appearance.	*/
+    MS_DEMUX_CHAN **byid;	/* channels indexed by SNCL id.		*/
+    int		nbyid;		/* # of entries in byid.		*/
+    int		ngaps;		/* # of gaps and overlaps.		*/
+    MS_DEMUX_GAP *gap;		/* gaps and overlaps, in stream order.	*/
+    int64_t	nsamples;	/* total # of samples.			*/
+    int		nrecords;	/* # of data records demultiplexed.	*/
+    int		nerrors;	/* # of records that failed to decode.	*/
+    QLIB2_CTX	ctx;		/* context for decoding.		*/
+} MS_DEMUX;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_demux_init
+   (MS_DEMUX	*dm);		/* ptr to MS_DEMUX.			*/
+
+extern void ms_demux_free
+   (MS_DEMUX	*dm);		/* ptr to MS_DEMUX.			*/
+
+extern int ms_demux_record
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*rec,		/* ptr to MiniSEED record.		*/
+    int		blksize);	/* size of record.			*/
+
+extern int ms_demux_reader
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    MS_READER	*r);		/* ptr to MS_READER.			*/
+
+extern int ms_demux_file
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*filename);	/* name of MiniSEED file.		*/
+
+extern MS_DEMUX_CHAN *ms_demux_find
+   (MS_DEMUX	*dm,		/* ptr to MS_DEMUX.			*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel);	/* channel name.			*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,578 @@
+/************************************************************************/
+/*  Extraction of time windows from MiniSEED data.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qtime.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_unpack.h"
+#include "ms_scan.h"
+#include "ms_index.h"
+#include "ms_extract.h"
+
+#define	EXTRACT_RECLEN	65536	/* initial size of record buffer.	*/
+#define	EXTRACT_INCREMENT 1024	/* # of items to allocate at a time.	*/
+
+/*	A record that overlaps the time window.				*/
+typedef struct _extract_rec {
+    int64_t	offset;		/* offset of record in file.		*/
+    INT_TIME	begtime;	/* time of first sample.		*/
+    int		blksize;	/* record size in bytes.		*/
+} EXTRACT_REC;
+
+/*	State of an extraction.						*/
+typedef struct _extract_state {
+    MS_EXTRACT	*out;		/* extracted data.			*/
+    QLIB2_CTX	ctx;		/* context for decoding.		*/
+    INT_TIME	t0;		/* start of time window.		*/
+    INT_TIME	t1;		/* end of time window (exclusive).	*/
+    INT_TIME	next;		/* expected time of next sample.	*/
+    char	*rec;		/* record buffer.			*/
+    int		reclen;		/* size of record buffer.		*/
+    int		*tmp;		/* buffer for Steim decoding.		*/
+    int		tmplen;		/* # of ints in tmp.			*/
+    int64_t	seglen;		/* # of samples allocated for segment.	*/
+} EXTRACT_STATE;
+
+/************************************************************************/
+/*  time_cmp:								*/
+/*	Compare two INT_TIMEs.						*/
+/*  return:	<0, 0, >0 if a is before, equal to, or after b.		*/
+/************************************************************************/
+static int time_cmp
+   (INT_TIME	a,		/* first time.				*/
+    INT_TIME	b)		/* second time.				*/
+{
+    if (a.year != b.year) return ((a.year < b.year) ? -1 : 1);
+    if (a.second != b.second) return ((a.second < b.second) ? -1 : 1);
+    if (a.usec != b.usec) return ((a.usec < b.usec) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  rec_cmp:								*/
+/*	Compare records by time, then by offset.			*/
+/************************************************************************/
+static int rec_cmp
+   (const void	*pa,		/* ptr to first EXTRACT_REC.		*/
+    const void	*pb)		/* ptr to second EXTRACT_REC.		*/
+{
+    const EXTRACT_REC *a = (const EXTRACT_REC *)pa;
+    const EXTRACT_REC *b = (const EXTRACT_REC *)pb;
+    int c;
+
+    if ((c = time_cmp (a->begtime, b->begtime)) != 0) return (c);
+    if (a->offset != b->offset) return ((a->offset < b->offset) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  sncl_match:								*/
+/*	Determine whether a record summary is for the specified		*/
+/*	channel.  A location of "--" matches a blank location.		*/
+/************************************************************************/
+static int sncl_match
+   (MS_SUMMARY	*s,		/* ptr to record summary.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    if (strcmp (location, "--") == 0) location = "";
+    return (strcmp (network, s->network_id) == 0 &&
+	    strcmp (station, s->station_id) == 0 &&
+	    strcmp (location, s->location_id) == 0 &&
+	    strcmp (channel, s->channel_id) == 0);
+}
+
+/************************************************************************/
+/*  sncl_check:								*/
+/*	Verify that a single channel is specified.  The samples of	*/
+/*	different channels cannot be merged into one set of segments,	*/
+/*	so every name must be given and contain no wildcards, which	*/
+/*	ms_index_query would otherwise expand.				*/
+/*  return:	0 on success, MS_ERROR if any name is NULL or wild.	*/
+/************************************************************************/
+static int sncl_check
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    if (network && station && location && channel &&
+	strpbrk (network, "*?") == NULL && strpbrk (station, "*?") == NULL &&
+	strpbrk (location, "*?") == NULL && strpbrk (channel, "*?") == NULL)
+	return (0);
+    strcpy (xs->ctx.errmsg, 
+	    "Error: channel not fully specified in ms_extract_window\n");
+    return (MS_ERROR);
+}
+
+/************************************************************************/
+/*  in_window:								*/
+/*	Determine whether a record has samples in the time window.	*/
+/************************************************************************/
+static int in_window
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    MS_SUMMARY	*s)		/* ptr to record summary.		*/
+{
+    return (s->num_samples > 0 &&
+	    time_cmp (s->begtime, xs->t1) < 0 && 
+	    time_cmp (s->endtime, xs->t0) >= 0);
+}
+
+/************************************************************************/
+/*  int_width:								*/
+/*	Return the # of bytes per sample of a fixed width integer	*/
+/*	format, 0 for Steim formats, or -1 for other formats.		*/
+/************************************************************************/
+static int int_width
+   (int		format)		/* data format.				*/
+{
+    switch (format) {
+      case STEIM1:
+      case STEIM2:
+	return (0);
+      case INT_16:
+	return (2);
+      case INT_24:
+	return (3);
+      case INT_32:
+	return (4);
+      default:
+	return (-1);
+    }
+}
+
+/************************************************************************/
+/*  new_segment:							*/
+/*	Start a new segment.						*/
+/*  return:	ptr to segment, or NULL on malloc error.		*/
+/************************************************************************/
+static MS_SEGMENT *new_segment
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR of first record.	*/
+    INT_TIME	begtime,	/* time of first sample.		*/
+    double	gap)		/* usecs from expected time.		*/
+{
+    MS_EXTRACT	*out = xs->out;
+    MS_SEGMENT	*seg;
+
+    if (out->nsegments % EXTRACT_INCREMENT == 0) {
+	seg = (MS_SEGMENT *)realloc (out->seg, (out->nsegments + EXTRACT_INCREMENT) *
+				     sizeof(MS_SEGMENT));
+	if (seg == NULL) return (NULL);
+	out->seg = seg;
+    }
+    seg = &out->seg[out->nsegments++];
+    memset ((char *)seg, 0, sizeof(MS_SEGMENT));
+    seg->begtime = begtime;
+    seg->gap = gap;
+    seg->sample_rate = hdr->sample_rate;
+    seg->sample_rate_mult = hdr->sample_rate_mult;
+    xs->seglen = 0;
+    return (seg);
+}
+
+/************************************************************************/
+/*  extract_record:							*/
+/*	Decode the samples of a record that are in the time window and	*/
+/*	append them to the output.  Sample times are computed from the	*/
+/*	record's sample clock.  Only the samples up to the end of the	*/
+/*	window are decoded, and for fixed width integer formats only	*/
+/*	the samples in the window are decoded.  Samples that overlap	*/
+/*	data already extracted are dropped.				*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int extract_record
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    char	*rec,		/* ptr to MiniSEED record.		*/
+    int		blksize)	/* size of record.			*/
+{
+    MS_EXTRACT	*out = xs->out;
+    MS_SEGMENT	*seg = NULL;
+    DATA_HDR	*hdr;
+    SAMPLE_CLOCK sc;
+    INT_TIME	first;
+    double	half, d = 0;
+    int64_t	k0, k1, k;
+    int		n, m, width, status;
+    int		*dst;
+    void	*p;
+
+    if ((hdr = decode_hdr_sdr_ctx (&xs->ctx, (SDR_HDR *)rec, blksize)) == NULL)
+	return (MS_ERROR);
+    n = hdr->num_samples;
+    if ((width = int_width (hdr->data_type)) < 0) {
+	sprintf (xs->ctx.errmsg, "Error: unable to extract format %d in ms_extract_window\n",
+		 hdr->data_type);
+	free_data_hdr (hdr);
+	return (MS_ERROR);
+    }
+    if (n <= 0 || init_sample_clock_hdr (&sc, hdr) != 0) {
+	free_data_hdr (hdr);
+	return (0);
+    }
+    half = 0.5 * USECS_PER_SEC * (double)sc.den / (double)sc.num;
+
+    /* Samples in [t0, t1).						*/
+    k0 = sample_clock_index (&sc, add_time (xs->t0, 0, -1)) + 1;
+    k1 = sample_clock_index (&sc, add_time (xs->t1, 0, -1));
+    if (k0 < 0) k0 = 0;
+    if (k1 > n - 1) k1 = n - 1;
+
+    /* Drop samples that overlap the data already extracted, and	*/
+    /* determine whether this record continues the current segment.	*/
+    if (out->nsegments > 0 && k0 <= k1) {
+	seg = &out->seg[out->nsegments-1];
+	first = sample_clock_time (&sc, k0);
+	if ((d = tdiff (first, xs->next)) < -half) {
+	    k = sample_clock_index (&sc, add_dtime (xs->next, -half)) + 1;
+	    if (k > k0) k0 = k;
+	    if (k0 <= k1) d = tdiff (sample_clock_time (&sc, k0), xs->next);
+	}
+	if (d < -half || d > half || seg->sample_rate != hdr->sample_rate ||
+	    seg->sample_rate_mult != hdr->sample_rate_mult) seg = NULL;
+    }
+    if (k0 > k1) {
+	free_data_hdr (hdr);
+	return (0);
+    }
+    if (seg == NULL && 
+	(seg = new_segment (xs, hdr, sample_clock_time (&sc, k0), 
+			    (out->nsegments > 0) ? d : 0.)) == NULL) {
+	free_data_hdr (hdr);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Make room for the samples.					*/
+    m = (int)(k1 - k0 + 1);
+    if (seg->nsamples + m > xs->seglen) {
+	k = (xs->seglen > 0) ? 2 * xs->seglen : EXTRACT_INCREMENT;
+	while (k < seg->nsamples + m) k *= 2;
+	if ((p = realloc (seg->data, k * sizeof(int))) == NULL) {
+	    free_data_hdr (hdr);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	seg->data = (int *)p;
+	xs->seglen = k;
+    }
+    dst = seg->data + seg->nsamples;
+
+    if (width > 0) {
+	/* Fixed width samples can be decoded starting at sample k0.	*/
+	hdr->first_data += (int)k0 * width;
+	hdr->num_samples -= (int)k0;
+	status = ms_unpack_ctx (&xs->ctx, hdr, m, rec, dst);
+    }
+    else {
+	/* Steim samples must be decoded from the start of the record,	*/
+	/* but frames after sample k1 are not decoded.			*/
+	if ((int)k1 + 1 > xs->tmplen) {
+	    if ((p = realloc (xs->tmp, (k1 + 1) * sizeof(int))) == NULL) {
+		free_data_hdr (hdr);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	    xs->tmp = (int *)p;
+	    xs->tmplen = (int)k1 + 1;
+	}
+	status = ms_unpack_ctx (&xs->ctx, hdr, (k1 + 1 < n) ? -(int)(k1 + 1) : n,
+				rec, xs->tmp);
+	if (status == k1 + 1) {
+	    memcpy ((char *)dst, (char *)(xs->tmp + k0), m * sizeof(int));
+	    status = m;
+	}
+    }
+    free_data_hdr (hdr);
+    if (status != m) return ((status < 0) ? status : MS_ERROR);
+
+    seg->nsamples += m;
+    out->nsamples += m;
+    out->nrecords++;
+    xs->next = sample_clock_time (&sc, k1 + 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  read_record:							*/
+/*	Read a record at the specified offset of a file.		*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int read_record
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    FILE	*fp,		/* FILE pointer for input file.		*/
+    int64_t	offset,		/* offset of record.			*/
+    int		blksize)	/* size of record.			*/
+{
+    void *p;
+
+    if (blksize > xs->reclen) {
+	if ((p = realloc (xs->rec, blksize)) == NULL) return (QLIB2_MALLOC_ERROR);
+	xs->rec = (char *)p;
+	xs->reclen = blksize;
+    }
+    if (fseeko (fp, (off_t)offset, SEEK_SET) != 0 || 
+	fread (xs->rec, blksize, 1, fp) != 1) return (MS_ERROR);
+    return (0);
+}
+
+/************************************************************************/
+/*  extract_init:							*/
+/*	Initialize an extraction.					*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int extract_init
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_EXTRACT	*out)		/* extracted data (returned).		*/
+{
+    memset ((char *)out, 0, sizeof(MS_EXTRACT));
+    memset ((char *)xs, 0, sizeof(EXTRACT_STATE));
+    xs->out = out;
+    xs->t0 = t0;
+    xs->t1 = t1;
+    qlib2_ctx_init (&xs->ctx);
+    if ((xs->rec = (char *)malloc (EXTRACT_RECLEN)) == NULL) {
+	qlib2_ctx_free (&xs->ctx);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    xs->reclen = EXTRACT_RECLEN;
+    return (0);
+}
+
+/************************************************************************/
+/*  extract_done:							*/
+/*	Finish an extraction.  On error, free the output and print the	*/
+/*	error message.							*/
+/*  return:	# of segments on success, negative error code on error.	*/
+/************************************************************************/
+static int extract_done
+   (EXTRACT_STATE *xs,		/* ptr to extraction state.		*/
+    int		status)		/* status of extraction.		*/
+{
+    MS_EXTRACT	*out = xs->out;
+    MS_SEGMENT	*seg;
+    int		i;
+
+    /* Trim the segment buffers to their final size.			*/
+    for (i=0; status == 0 && i<out->nsegments; i++) {
+	seg = &out->seg[i];
+	if (seg->nsamples > 0) {
+	    void *p = realloc (seg->data, seg->nsamples * sizeof(int));
+	    if (p) seg->data = (int *)p;
+	}
+    }
+    if (status < 0) {
+	ms_extract_free (out);
+	if (status == QLIB2_MALLOC_ERROR) 
+	    fprintf (stderr, "Error: unable to malloc data in ms_extract_window\n");
+	else if (xs->ctx.errmsg[0])
+	    fprintf (stderr, "%s", xs->ctx.errmsg);
+	fflush (stderr);
+	if (status == QLIB2_MALLOC_ERROR && QLIB2_CLASSIC) exit(1);
+    }
+    free (xs->rec);
+    if (xs->tmp) free ((char *)xs->tmp);
+    qlib2_ctx_free (&xs->ctx);
+    return ((status < 0) ? status : out->nsegments);
+}
+
+/************************************************************************/
+/*  ms_extract_window:							*/
+/*	Extract the samples of a channel in the time window [t0, t1)	*/
+/*	from a MiniSEED file.  The file is positioned at t0 with	*/
+/*	ms_seek_time, the headers of the following records are scanned	*/
+/*	to find the records that overlap the window, and only those	*/
+/*	records are decoded, in time order.  The samples are trimmed	*/
+/*	to the window using each record's sample clock, and returned	*/
+/*	as contiguous segments separated by gaps.  The scan stops at	*/
+/*	the first record of the channel that starts at or after t1.	*/
+/*	All names must be given, and a location of "--" matches a	*/
+/*	blank location.  Only integer data formats can be extracted.	*/
+/*  return:								*/
+/*	# of segments on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_extract_window
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_EXTRACT	*out)		/* extracted data (returned).		*/
+{
+    EXTRACT_STATE xs;
+    EXTRACT_REC	*r = NULL;
+    MS_SUMMARY	s;
+    int64_t	offset;
+    void	*p;
+    int		nrecs = 0;
+    int		status, i;
+
+    if ((status = extract_init (&xs, t0, t1, out)) < 0) 
+	return (extract_done (&xs, status));
+    if ((status = sncl_check (&xs, network, station, location, channel)) < 0)
+	return (extract_done (&xs, status));
+
+    /* Find the records that overlap the window, starting at the	*/
+    /* first record with samples at or after t0.			*/
+    if ((offset = ms_seek_time (fp, t0)) < 0) status = (int)offset;
+    while (status == 0 && (status = ms_scan_record (fp, &s)) > 0) {
+	status = 0;
+	if (! sncl_match (&s, network, station, location, channel)) continue;
+	if (time_cmp (s.begtime, t1) >= 0) break;
+	if (! in_window (&xs, &s)) continue;
+	if (nrecs % EXTRACT_INCREMENT == 0) {
+	    if ((p = realloc (r, (nrecs + EXTRACT_INCREMENT) * 
+			      sizeof(EXTRACT_REC))) == NULL) {
+		status = QLIB2_MALLOC_ERROR;
+		break;
+	    }
+	    r = (EXTRACT_REC *)p;
+	}
+	r[nrecs].offset = s.offset;
+	r[nrecs].begtime = s.begtime;
+	r[nrecs].blksize = s.blksize;
+	++nrecs;
+    }
+    if (status == EOF) status = 0;
+
+    /* Decode them in time order.					*/
+    if (nrecs > 0) qsort ((char *)r, nrecs, sizeof(EXTRACT_REC), rec_cmp);
+    for (i=0; status == 0 && i<nrecs; i++) {
+	if ((status = read_record (&xs, fp, r[i].offset, r[i].blksize)) == 0)
+	    status = extract_record (&xs, xs.rec, r[i].blksize);
+    }
+    if (r) free ((char *)r);
+    return (extract_done (&xs, status));
+}
+
+/************************************************************************/
+/*  ms_extract_window_index:						*/
+/*	Extract the samples of a channel in the time window [t0, t1)	*/
+/*	using an index to find the records, as with ms_extract_window.	*/
+/*	Only the byte ranges returned by ms_index_query are read.	*/
+/*  return:								*/
+/*	# of segments on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_extract_window_index
+   (MS_INDEX	*ix,		/* ptr to MS_INDEX.			*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_EXTRACT	*out)		/* extracted data (returned).		*/
+{
+    EXTRACT_STATE xs;
+    MS_INDEX_RANGE *r = NULL;
+    MS_SUMMARY	s;
+    FILE	*fp = NULL;
+    char	*fname = NULL;
+    int64_t	offset;
+    int		nranges, blksize;
+    int		status, i;
+
+    if ((status = extract_init (&xs, t0, t1, out)) < 0) 
+	return (extract_done (&xs, status));
+    if ((status = sncl_check (&xs, network, station, location, channel)) < 0)
+	return (extract_done (&xs, status));
+    if ((nranges = ms_index_query (ix, network, station, location, channel, 
+				   t0, t1, &r)) < 0) 
+	return (extract_done (&xs, nranges));
+
+    /* Each range is a run of consecutive records of one channel with	*/
+    /* the same blksize, in time order, and the ranges of a channel	*/
+    /* are sorted by time.						*/
+    for (i=0; status == 0 && i<nranges; i++) {
+	if (fname == NULL || strcmp (fname, r[i].filename) != 0) {
+	    if (fp) fclose (fp);
+	    fname = r[i].filename;
+	    if ((fp = fopen (fname, "r")) == NULL) {
+		sprintf (xs.ctx.errmsg, "Error: unable to open %s in ms_extract_window\n",
+			 fname);
+		status = MS_ERROR;
+		break;
+	    }
+	}
+	blksize = 1 << r[i].entry->blkexp;
+	for (offset = r[i].offset; status == 0 && offset < r[i].offset + r[i].length; 
+	     offset += blksize) {
+	    if ((status = read_record (&xs, fp, offset, blksize)) < 0) break;
+	    if (ms_parse_summary (xs.rec, blksize, &s) < 0) {
+		status = MS_ERROR;
+		break;
+	    }
+	    if (in_window (&xs, &s)) status = extract_record (&xs, xs.rec, blksize);
+	}
+    }
+    if (fp) fclose (fp);
+    if (r) free ((char *)r);
+    return (extract_done (&xs, status));
+}
+
+/************************************************************************/
+/*  ms_extract_free:							*/
+/*	Free all storage in an MS_EXTRACT structure.			*/
+/************************************************************************/
+void ms_extract_free
+   (MS_EXTRACT	*out)		/* ptr to MS_EXTRACT.			*/
+{
+    int i;
+
+    for (i=0; i<out->nsegments; i++) {
+	if (out->seg[i].data) free ((char *)out->seg[i].data);
+    }
+    if (out->seg) free ((char *)out->seg);
+    memset ((char *)out, 0, sizeof(MS_EXTRACT));
+}
@@ -0,0 +1,100 @@
+/************************************************************************/
+/*  Extraction of time windows from MiniSEED data.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_extract_h
+#define	__ms_extract_h
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "timedef.h"
+#include "ms_index.h"
+
+/*	Contiguous samples of an extracted time window.			*/
+
+typedef struct _ms_segment {
+    INT_TIME	begtime;	/* time of first sample.		*/
+    double	gap;		/* usecs from the expected time of the	*/
+				/* first sample to its actual time.	*/
+				/* (0 for the first segment).		*/
+    int		sample_rate;	/* sample rate in qlib convention.	*/
+    int		sample_rate_mult;/* rate_mult in qlib convention.	*/
+    int64_t	nsamples;	/* # of samples.			*/
+    int		*data;		/* samples.				*/
+} MS_SEGMENT;
+
+/*	Result of a time window extraction.				*/
+
+typedef struct _ms_extract {
+    int		nsegments;	/* # of segments.			*/
+    MS_SEGMENT	*seg;		/* array of segments, in time order.	*/
+    int64_t	nsamples;	/* total # of samples in all segments.	*/
+    int		nrecords;	/* # of records decoded.		*/
+} MS_EXTRACT;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_extract_window
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_EXTRACT	*out);		/* extracted data (returned).		*/
+
+extern int ms_extract_window_index
+   (MS_INDEX	*ix,		/* ptr to MS_INDEX.			*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel,	/* channel name.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_EXTRACT	*out);		/* extracted data (returned).		*/
+
+extern void ms_extract_free
+   (MS_EXTRACT	*out);		/* ptr to MS_EXTRACT.			*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
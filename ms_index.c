@@ -0,0 +1,646 @@
+/************************************************************************/
+/*  Persistent index of MiniSEED records.				*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * An index file contains an MS_INDEX_HDR, a table of the indexed files,
+ * a table of their names, and an array of MS_INDEX_ENTRY sorted by
+ * network, station, location, channel, and start time.  All values are
+ * in the native byte order of the machine that built the index.  The
+ * file is memory mapped by ms_index_open, so queries do not read it.
+ *
+ * Within each channel the entries are sorted by start time, and
+ * max_end_time is non-decreasing, so both ends of a time window can be
+ * found by binary search.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "ms_scan.h"
+#include "ms_index.h"
+
+#define	INDEX_MAGIC	"QLIB2IDX"
+#define	INDEX_BYTEORDER	0x01020304
+#define	INDEX_INCREMENT	1024	/* # of entries to allocate at a time.	*/
+#define	MIN_BLKEXP	7	/* smallest valid blksize exponent.	*/
+#define	MAX_BLKEXP	30	/* largest valid blksize exponent.	*/
+
+/*	Index under construction.					*/
+typedef struct _index_build {
+    MS_INDEX_ENTRY *entry;	/* array of entries.			*/
+    int		nentries;	/* # of entries.			*/
+    int		nalloc;		/* # of entries allocated.		*/
+    MS_INDEX_FILE *file;	/* array of files.			*/
+    char	**name;		/* array of file names.			*/
+    int		nfiles;		/* # of files.				*/
+    int		nfalloc;	/* # of files allocated.		*/
+} INDEX_BUILD;
+
+/************************************************************************/
+/*  time_cmp:								*/
+/*	Compare two INT_TIMEs.						*/
+/*  return:	<0, 0, >0 if a is before, equal to, or after b.		*/
+/************************************************************************/
+static int time_cmp
+   (INT_TIME	a,		/* first time.				*/
+    INT_TIME	b)		/* second time.				*/
+{
+    if (a.year != b.year) return ((a.year < b.year) ? -1 : 1);
+    if (a.second != b.second) return ((a.second < b.second) ? -1 : 1);
+    if (a.usec != b.usec) return ((a.usec < b.usec) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  sncl_cmp:								*/
+/*	Compare the channel names of two entries in index order.	*/
+/************************************************************************/
+static int sncl_cmp
+   (const MS_INDEX_ENTRY *a,	/* first entry.				*/
+    const MS_INDEX_ENTRY *b)	/* second entry.			*/
+{
+    int c;
+
+    if ((c = strcmp (a->network, b->network)) != 0) return (c);
+    if ((c = strcmp (a->station, b->station)) != 0) return (c);
+    if ((c = strcmp (a->location, b->location)) != 0) return (c);
+    return (strcmp (a->channel, b->channel));
+}
+
+/************************************************************************/
+/*  entry_cmp:								*/
+/*	Compare two entries in index order.				*/
+/************************************************************************/
+static int entry_cmp
+   (const void	*pa,		/* ptr to first entry.			*/
+    const void	*pb)		/* ptr to second entry.			*/
+{
+    const MS_INDEX_ENTRY *a = (const MS_INDEX_ENTRY *)pa;
+    const MS_INDEX_ENTRY *b = (const MS_INDEX_ENTRY *)pb;
+    int c;
+
+    if ((c = sncl_cmp (a, b)) != 0) return (c);
+    if ((c = time_cmp (a->start_time, b->start_time)) != 0) return (c);
+    if (a->file != b->file) return ((a->file < b->file) ? -1 : 1);
+    if (a->offset != b->offset) return ((a->offset < b->offset) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  name_cmp:								*/
+/*	Compare two file names for qsort.				*/
+/************************************************************************/
+static int name_cmp
+   (const void	*pa,		/* ptr to first name ptr.		*/
+    const void	*pb)		/* ptr to second name ptr.		*/
+{
+    return (strcmp (*(char * const *)pa, *(char * const *)pb));
+}
+
+/************************************************************************/
+/*  wildmatch:								*/
+/*	Match a string against a pattern containing '*' (any string)	*/
+/*	and '?' (any character).  A NULL pattern matches everything.	*/
+/*  return:	1 if the string matches, 0 otherwise.			*/
+/************************************************************************/
+static int wildmatch
+   (char	*pat,		/* pattern.				*/
+    char	*str)		/* string to match.			*/
+{
+    if (pat == NULL) return (1);
+    for (; *pat; pat++, str++) {
+	if (*pat == '*') {
+	    while (*pat == '*') pat++;
+	    if (*pat == '\0') return (1);
+	    for (; *str; str++) {
+		if (wildmatch (pat, str)) return (1);
+	    }
+	    return (0);
+	}
+	if (*str == '\0') return (0);
+	if (*pat != '?' && *pat != *str) return (0);
+    }
+    return (*str == '\0');
+}
+
+/************************************************************************/
+/*  add_entry:								*/
+/*	Add an entry for a record, or extend the previous entry if the	*/
+/*	record immediately follows it in the file for the same channel.	*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int add_entry
+   (INDEX_BUILD	*b,		/* ptr to index under construction.	*/
+    int		file,		/* index of file.			*/
+    int		first,		/* 1 if first record of file.		*/
+    MS_SUMMARY	*s)		/* summary of record.			*/
+{
+    MS_INDEX_ENTRY *e;
+    int blkexp;
+
+    for (blkexp=0; (1 << blkexp) < s->blksize; blkexp++) ;
+    if (! first) {
+	e = &b->entry[b->nentries-1];
+	if (e->blkexp == blkexp && e->data_type == s->data_type &&
+	    e->offset + e->length == s->offset &&
+	    time_cmp (s->begtime, e->end_time) > 0 &&
+	    strcmp (e->station, s->station_id) == 0 &&
+	    strcmp (e->network, s->network_id) == 0 &&
+	    strcmp (e->channel, s->channel_id) == 0 &&
+	    strcmp (e->location, s->location_id) == 0) {
+	    e->length += s->blksize;
+	    e->nrecords++;
+	    e->end_time = s->endtime;
+	    return (0);
+	}
+    }
+
+    if (b->nentries == b->nalloc) {
+	e = (MS_INDEX_ENTRY *)realloc (b->entry, (b->nalloc + INDEX_INCREMENT) * 
+				       sizeof(MS_INDEX_ENTRY));
+	if (e == NULL) return (QLIB2_MALLOC_ERROR);
+	b->entry = e;
+	b->nalloc += INDEX_INCREMENT;
+    }
+    e = &b->entry[b->nentries++];
+    memset ((char *)e, 0, sizeof(MS_INDEX_ENTRY));
+    strcpy (e->station, s->station_id);
+    strcpy (e->network, s->network_id);
+    strcpy (e->channel, s->channel_id);
+    strcpy (e->location, s->location_id);
+    e->blkexp = blkexp;
+    e->data_type = s->data_type;
+    e->record_type = s->record_type;
+    e->sample_rate = s->sample_rate;
+    e->sample_rate_mult = s->sample_rate_mult;
+    e->file = file;
+    e->nrecords = 1;
+    e->start_time = s->begtime;
+    e->end_time = s->endtime;
+    e->offset = s->offset;
+    e->length = s->blksize;
+    return (0);
+}
+
+/************************************************************************/
+/*  index_file:								*/
+/*	Scan a MiniSEED file and add its records to the index.		*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int index_file
+   (INDEX_BUILD	*b,		/* ptr to index under construction.	*/
+    char	*path,		/* name of file.			*/
+    struct stat	*sb)		/* stat of file.			*/
+{
+    MS_SUMMARY	*sum;
+    void	*p;
+    int		n, i, status = 0;
+
+    if ((n = ms_scan_file (path, &sum)) <= 0) return (n);
+    if (b->nfiles == b->nfalloc) {
+	if ((p = realloc (b->file, (b->nfalloc + INDEX_INCREMENT) * 
+			  sizeof(MS_INDEX_FILE))) == NULL) {
+	    free ((char *)sum);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	b->file = (MS_INDEX_FILE *)p;
+	if ((p = realloc (b->name, (b->nfalloc + INDEX_INCREMENT) * 
+			  sizeof(char *))) == NULL) {
+	    free ((char *)sum);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	b->name = (char **)p;
+	b->nfalloc += INDEX_INCREMENT;
+    }
+    if ((b->name[b->nfiles] = strdup (path)) == NULL) {
+	free ((char *)sum);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    b->file[b->nfiles].size = sb->st_size;
+    b->file[b->nfiles].mtime = sb->st_mtime;
+    b->file[b->nfiles].name = 0;
+    for (i=0; i<n && status == 0; i++) 
+	status = add_entry (b, b->nfiles, i == 0, &sum[i]);
+    b->nfiles++;
+    free ((char *)sum);
+    return (status);
+}
+
+/************************************************************************/
+/*  index_path:								*/
+/*	Add a file, or all files in a directory tree, to the index.	*/
+/*	Files found in directories that are not MiniSEED are ignored.	*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int index_path
+   (INDEX_BUILD	*b,		/* ptr to index under construction.	*/
+    char	*path,		/* name of file or directory.		*/
+    int		explicit)	/* 1 if path was named by the caller.	*/
+{
+    struct stat	sb;
+    struct dirent *de;
+    DIR		*dir;
+    char	**names = NULL;
+    char	*name;
+    void	*p;
+    int		nnames = 0;
+    int		nalloc = 0;
+    int		status = 0;
+    int		i;
+
+    if (stat (path, &sb) != 0) {
+	if (! explicit) return (0);
+	fprintf (stderr, "Error: unable to stat %s in ms_index_build\n", path);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    if (S_ISREG(sb.st_mode)) {
+	status = index_file (b, path, &sb);
+	if (status == QLIB2_MALLOC_ERROR || (status < 0 && explicit)) return (status);
+	return (0);
+    }
+    if (! S_ISDIR(sb.st_mode)) return (0);
+
+    /* Index the directory entries in name order.			*/
+    if ((dir = opendir (path)) == NULL) return (explicit ? MS_ERROR : 0);
+    while ((de = readdir (dir)) != NULL) {
+	if (de->d_name[0] == '.') continue;
+	if (nnames == nalloc) {
+	    if ((p = realloc (names, (nalloc + INDEX_INCREMENT) * sizeof(char *))) == NULL) {
+		status = QLIB2_MALLOC_ERROR;
+		break;
+	    }
+	    names = (char **)p;
+	    nalloc += INDEX_INCREMENT;
+	}
+	if ((name = (char *)malloc (strlen(path) + strlen(de->d_name) + 2)) == NULL) {
+	    status = QLIB2_MALLOC_ERROR;
+	    break;
+	}
+	sprintf (name, "%s/%s", path, de->d_name);
+	names[nnames++] = name;
+    }
+    closedir (dir);
+    if (status == 0) qsort ((char *)names, nnames, sizeof(char *), name_cmp);
+    for (i=0; i<nnames; i++) {
+	if (status == 0) status = index_path (b, names[i], 0);
+	free (names[i]);
+    }
+    if (names) free ((char *)names);
+    return (status);
+}
+
+/************************************************************************/
+/*  write_index:							*/
+/*	Sort the entries and write the index file.  The index is	*/
+/*	written to a temporary file which is then renamed, so that	*/
+/*	readers never see a partial index.				*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int write_index
+   (INDEX_BUILD	*b,		/* ptr to index under construction.	*/
+    char	*indexfile)	/* name of index file to create.	*/
+{
+    MS_INDEX_HDR hdr;
+    char	*tmpfile;
+    char	pad[8];
+    FILE	*fp;
+    int64_t	name_len = 0;
+    int		i, npad, ok;
+
+    /* Compute the running max end time within each channel.		*/
+    qsort ((char *)b->entry, b->nentries, sizeof(MS_INDEX_ENTRY), entry_cmp);
+    for (i=0; i<b->nentries; i++) {
+	b->entry[i].max_end_time = b->entry[i].end_time;
+	if (i > 0 && sncl_cmp (&b->entry[i], &b->entry[i-1]) == 0 &&
+	    time_cmp (b->entry[i-1].max_end_time, b->entry[i].end_time) > 0)
+	    b->entry[i].max_end_time = b->entry[i-1].max_end_time;
+    }
+    for (i=0; i<b->nfiles; i++) {
+	b->file[i].name = name_len;
+	name_len += strlen (b->name[i]) + 1;
+    }
+    npad = (int)((8 - (name_len % 8)) % 8);
+
+    memset ((char *)&hdr, 0, sizeof(hdr));
+    memcpy (hdr.magic, INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = MS_INDEX_VERSION;
+    hdr.byteorder = INDEX_BYTEORDER;
+    hdr.nfiles = b->nfiles;
+    hdr.nentries = b->nentries;
+    hdr.file_offset = sizeof(MS_INDEX_HDR);
+    hdr.name_offset = hdr.file_offset + b->nfiles * sizeof(MS_INDEX_FILE);
+    hdr.entry_offset = hdr.name_offset + name_len + npad;
+
+    if ((tmpfile = (char *)malloc (strlen(indexfile) + 5)) == NULL) 
+	return (QLIB2_MALLOC_ERROR);
+    sprintf (tmpfile, "%s.tmp", indexfile);
+    if ((fp = fopen (tmpfile, "w")) == NULL) {
+	fprintf (stderr, "Error: unable to create %s in ms_index_build\n", tmpfile);
+	fflush (stderr);
+	free (tmpfile);
+	return (MS_ERROR);
+    }
+    memset (pad, 0, sizeof(pad));
+    ok = (fwrite (&hdr, sizeof(hdr), 1, fp) == 1);
+    if (ok && b->nfiles > 0)
+	ok = (fwrite (b->file, sizeof(MS_INDEX_FILE), b->nfiles, fp) == (size_t)b->nfiles);
+    for (i=0; ok && i<b->nfiles; i++) 
+	ok = (fwrite (b->name[i], strlen(b->name[i]) + 1, 1, fp) == 1);
+    if (ok && npad > 0) ok = (fwrite (pad, npad, 1, fp) == 1);
+    if (ok && b->nentries > 0) 
+	ok = (fwrite (b->entry, sizeof(MS_INDEX_ENTRY), b->nentries, fp) == (size_t)b->nentries);
+    if (fclose (fp) != 0) ok = 0;
+    if (ok && rename (tmpfile, indexfile) != 0) ok = 0;
+    if (! ok) {
+	fprintf (stderr, "Error: unable to write %s in ms_index_build\n", indexfile);
+	fflush (stderr);
+	unlink (tmpfile);
+    }
+    free (tmpfile);
+    return (ok ? 0 : MS_ERROR);
+}
+
+/************************************************************************/
+/*  ms_index_build:							*/
+/*	Create an index file for the MiniSEED records in the specified	*/
+/*	files and directory trees.  Each entry describes a run of	*/
+/*	consecutive records of one channel in one file.			*/
+/*  return:								*/
+/*	# of index entries on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_index_build
+   (char	**paths,	/* MiniSEED files or directories.	*/
+    int		npaths,		/* # of paths.				*/
+    char	*indexfile)	/* name of index file to create.	*/
+{
+    INDEX_BUILD	b;
+    int		status = 0;
+    int		i;
+
+    memset ((char *)&b, 0, sizeof(b));
+    for (i=0; i<npaths && status == 0; i++) 
+	status = index_path (&b, paths[i], 1);
+    if (status == 0) status = write_index (&b, indexfile);
+    if (status == 0) status = b.nentries;
+
+    for (i=0; i<b.nfiles; i++) free (b.name[i]);
+    if (b.name) free ((char *)b.name);
+    if (b.file) free ((char *)b.file);
+    if (b.entry) free ((char *)b.entry);
+    if (status == QLIB2_MALLOC_ERROR) {
+	fprintf (stderr, "Error: unable to malloc index in ms_index_build\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+    }
+    return (status);
+}
+
+/************************************************************************/
+/*  index_valid:							*/
+/*	Verify that the tables of a loaded index lie within the index	*/
+/*	file, that every file name is terminated within the name	*/
+/*	table, and that every entry refers to a valid file and has	*/
+/*	terminated names, a valid blksize, and a valid byte range.	*/
+/*  return:	1 if valid, 0 otherwise.				*/
+/************************************************************************/
+static int index_valid
+   (MS_INDEX	*ix)		/* ptr to MS_INDEX.			*/
+{
+    MS_INDEX_HDR *hdr = ix->hdr;
+    MS_INDEX_FILE *f;
+    MS_INDEX_ENTRY *e;
+    int64_t	name_len;
+    int		i;
+
+    if (memcmp (hdr->magic, INDEX_MAGIC, sizeof(hdr->magic)) != 0 ||
+	hdr->version != MS_INDEX_VERSION || hdr->byteorder != INDEX_BYTEORDER ||
+	hdr->nfiles < 0 || hdr->nentries < 0 ||
+	hdr->file_offset < (int64_t)sizeof(MS_INDEX_HDR) ||
+	hdr->file_offset % sizeof(int64_t) != 0 ||
+	hdr->name_offset < hdr->file_offset + 
+	    (int64_t)hdr->nfiles * (int64_t)sizeof(MS_INDEX_FILE) ||
+	hdr->entry_offset < hdr->name_offset ||
+	hdr->entry_offset % sizeof(int64_t) != 0 ||
+	hdr->entry_offset + (int64_t)hdr->nentries * (int64_t)sizeof(MS_INDEX_ENTRY) > ix->maplen)
+	return (0);
+
+    /* The name table lies between the file table and the entries.	*/
+    f = (MS_INDEX_FILE *)(ix->map + hdr->file_offset);
+    name_len = hdr->entry_offset - hdr->name_offset;
+    for (i=0; i<hdr->nfiles; i++) {
+	if (f[i].name < 0 || f[i].name >= name_len ||
+	    memchr (ix->map + hdr->name_offset + f[i].name, '\0', 
+		    (size_t)(name_len - f[i].name)) == NULL)
+	    return (0);
+    }
+
+    e = (MS_INDEX_ENTRY *)(ix->map + hdr->entry_offset);
+    for (i=0; i<hdr->nentries; i++) {
+	if (e[i].file < 0 || e[i].file >= hdr->nfiles ||
+	    e[i].station[DH_STATION_LEN] != '\0' ||
+	    e[i].network[DH_NETWORK_LEN] != '\0' ||
+	    e[i].channel[DH_CHANNEL_LEN] != '\0' ||
+	    e[i].location[DH_LOCATION_LEN] != '\0' ||
+	    e[i].blkexp < MIN_BLKEXP || e[i].blkexp > MAX_BLKEXP ||
+	    e[i].nrecords < 0 || e[i].offset < 0 || e[i].length < 0)
+	    return (0);
+    }
+    return (1);
+}
+
+/************************************************************************/
+/*  ms_index_open:							*/
+/*	Open an index file created by ms_index_build.  The file is	*/
+/*	memory mapped if possible, otherwise it is read into memory.	*/
+/*	Every table and entry is validated before the index is used.	*/
+/*  return:	ptr to MS_INDEX on success, NULL on error.		*/
+/************************************************************************/
+MS_INDEX *ms_index_open
+   (char	*indexfile)	/* name of index file.			*/
+{
+    struct stat	sb;
+    MS_INDEX	*ix;
+    MS_INDEX_HDR *hdr;
+    int		fd;
+
+    if ((fd = open (indexfile, O_RDONLY)) < 0) {
+	fprintf (stderr, "Error: unable to open %s in ms_index_open\n", indexfile);
+	fflush (stderr);
+	return (NULL);
+    }
+    if (fstat (fd, &sb) != 0 || sb.st_size < (off_t)sizeof(MS_INDEX_HDR) ||
+	(ix = (MS_INDEX *)calloc (1, sizeof(MS_INDEX))) == NULL) {
+	close (fd);
+	return (NULL);
+    }
+    ix->maplen = sb.st_size;
+    ix->map = (char *)mmap (NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ix->mapped = 1;
+    if (ix->map == (char *)MAP_FAILED) {
+	ix->mapped = 0;
+	if ((ix->map = (char *)malloc ((size_t)sb.st_size)) == NULL ||
+	    read (fd, ix->map, (size_t)sb.st_size) != (ssize_t)sb.st_size) {
+	    if (ix->map) free (ix->map);
+	    free ((char *)ix);
+	    close (fd);
+	    return (NULL);
+	}
+    }
+    close (fd);
+
+    hdr = ix->hdr = (MS_INDEX_HDR *)ix->map;
+    if (! index_valid (ix)) {
+	fprintf (stderr, "Error: invalid index file %s in ms_index_open\n", indexfile);
+	fflush (stderr);
+	ms_index_close (ix);
+	return (NULL);
+    }
+    ix->file = (MS_INDEX_FILE *)(ix->map + hdr->file_offset);
+    ix->names = ix->map + hdr->name_offset;
+    ix->entry = (MS_INDEX_ENTRY *)(ix->map + hdr->entry_offset);
+    ix->nfiles = hdr->nfiles;
+    ix->nentries = hdr->nentries;
+    return (ix);
+}
+
+/************************************************************************/
+/*  ms_index_close:							*/
+/*	Close an index opened by ms_index_open.				*/
+/************************************************************************/
+void ms_index_close
+   (MS_INDEX	*ix)		/* ptr to MS_INDEX.			*/
+{
+    if (ix == NULL) return;
+    if (ix->mapped) munmap (ix->map, (size_t)ix->maplen);
+    else free (ix->map);
+    free ((char *)ix);
+}
+
+/************************************************************************/
+/*  ms_index_query:							*/
+/*	Find the byte ranges of the records of all channels matching	*/
+/*	the network, station, location, and channel patterns that	*/
+/*	contain samples in the time window [t0, t1).  Patterns may	*/
+/*	contain '*' and '?', a NULL pattern matches everything, and a	*/
+/*	location of "--" matches a blank location.  The caller must	*/
+/*	free the returned array.					*/
+/*  return:								*/
+/*	# of ranges on success.						*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_index_query
+   (MS_INDEX	*ix,		/* ptr to MS_INDEX.			*/
+    char	*network,	/* network pattern.			*/
+    char	*station,	/* station pattern.			*/
+    char	*location,	/* location pattern.			*/
+    char	*channel,	/* channel pattern.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_INDEX_RANGE **pranges)	/* array of ranges (returned).		*/
+{
+    MS_INDEX_RANGE *r = NULL;
+    MS_INDEX_ENTRY *e = ix->entry;
+    void	*p;
+    int		nranges = 0;
+    int		nalloc = 0;
+    int		first, last, lo, hi, mid, k;
+
+    *pranges = NULL;
+    if (location && strcmp (location, "--") == 0) location = "";
+
+    for (first=0; first<ix->nentries; first=last) {
+	/* Find the end of this channel's entries.			*/
+	lo = first + 1;
+	hi = ix->nentries;
+	while (lo < hi) {
+	    mid = lo + (hi - lo) / 2;
+	    if (sncl_cmp (&e[mid], &e[first]) == 0) lo = mid + 1;
+	    else hi = mid;
+	}
+	last = lo;
+	if (! (wildmatch (network, e[first].network) &&
+	       wildmatch (station, e[first].station) &&
+	       wildmatch (location, e[first].location) &&
+	       wildmatch (channel, e[first].channel))) continue;
+
+	/* First entry that may end at or after t0.			*/
+	lo = first;
+	hi = last;
+	while (lo < hi) {
+	    mid = lo + (hi - lo) / 2;
+	    if (time_cmp (e[mid].max_end_time, t0) < 0) lo = mid + 1;
+	    else hi = mid;
+	}
+	for (k=lo; k<last && time_cmp (e[k].start_time, t1) < 0; k++) {
+	    if (time_cmp (e[k].end_time, t0) < 0) continue;
+	    if (nranges == nalloc) {
+		if ((p = realloc (r, (nalloc + INDEX_INCREMENT) * 
+				  sizeof(MS_INDEX_RANGE))) == NULL) {
+		    if (r) free ((char *)r);
+		    fprintf (stderr, "Error: unable to malloc ranges in ms_index_query\n");
+		    fflush (stderr);
+		    if (QLIB2_CLASSIC) exit(1);
+		    return (QLIB2_MALLOC_ERROR);
+		}
+		r = (MS_INDEX_RANGE *)p;
+		nalloc += INDEX_INCREMENT;
+	    }
+	    r[nranges].filename = ix->names + ix->file[e[k].file].name;
+	    r[nranges].offset = e[k].offset;
+	    r[nranges].length = e[k].length;
+	    r[nranges].entry = &e[k];
+	    ++nranges;
+	}
+    }
+    *pranges = r;
+    return (nranges);
+}
@@ -0,0 +1,149 @@
+/************************************************************************/
+/*  Persistent index of MiniSEED records.				*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_index_h
+#define	__ms_index_h
+
+#include <sys/types.h>
+#include "timedef.h"
+#include "data_hdr.h"
+
+#define	MS_INDEX_VERSION	1
+
+/*	Index entry for a run of consecutive records of one channel in	*/
+/*	a file.  The fields follow the HOLDING_SHORT record in		*/
+/*	holdings.h, with 64 bit offsets, INT_TIME times, and a file	*/
+/*	number so that one index can describe many large files.		*/
+
+typedef struct _ms_index_entry {
+    char	station[DH_STATION_LEN+1];	/* SEED station name.	*/
+    char	network[DH_NETWORK_LEN+1];	/* SEED network name.	*/
+    char	channel[DH_CHANNEL_LEN+1];	/* SEED channel name.	*/
+    char	location[DH_LOCATION_LEN+1];	/* SEED location name.	*/
+    char	blkexp;		/* blksize = 2**blkexp.			*/
+    char	data_type;	/* MiniSEED data type.			*/
+    char	record_type;	/* MiniSEED record type.		*/
+    char	pad;		/* padding.				*/
+    short int	sample_rate;	/* sample rate in qlib convention.	*/
+    short int	sample_rate_mult;/* rate_mult in qlib convention.	*/
+    int		file;		/* index of file in file table.		*/
+    int		nrecords;	/* # of records in run.			*/
+    INT_TIME	start_time;	/* time of first sample.		*/
+    INT_TIME	end_time;	/* time of last sample.			*/
+    INT_TIME	max_end_time;	/* latest end_time of this and all	*/
+				/* previous entries of the channel.	*/
+    int		pad2;		/* padding.				*/
+    int64_t	offset;		/* offset of first record in file.	*/
+    int64_t	length;		/* length in bytes of run.		*/
+} MS_INDEX_ENTRY;
+
+/*	File table entry.						*/
+
+typedef struct _ms_index_file {
+    int64_t	size;		/* size of file when indexed.		*/
+    int64_t	mtime;		/* modification time when indexed.	*/
+    int64_t	name;		/* offset of name in name table.	*/
+} MS_INDEX_FILE;
+
+/*	Index file header.						*/
+
+typedef struct _ms_index_hdr {
+    char	magic[8];	/* "QLIB2IDX"				*/
+    int		version;	/* MS_INDEX_VERSION.			*/
+    int		byteorder;	/* 0x01020304 in native byte order.	*/
+    int		nfiles;		/* # of files.				*/
+    int		nentries;	/* # of entries.			*/
+    int64_t	file_offset;	/* offset of file table.		*/
+    int64_t	name_offset;	/* offset of name table.		*/
+    int64_t	entry_offset;	/* offset of entries.			*/
+} MS_INDEX_HDR;
+
+/*	Open index.							*/
+
+typedef struct _ms_index {
+    char	*map;		/* mapped index file.			*/
+    int64_t	maplen;		/* length of mapped index file.		*/
+    MS_INDEX_HDR *hdr;		/* ptr to index header.			*/
+    MS_INDEX_FILE *file;	/* ptr to file table.			*/
+    char	*names;		/* ptr to name table.			*/
+    MS_INDEX_ENTRY *entry;	/* ptr to entries, sorted by network,	*/
+				/* station, location, channel, time.	*/
+    int		nfiles;		/* # of files.				*/
+    int		nentries;	/* # of entries.			*/
+    int		mapped;		/* 1 if mapped, 0 if read into memory.	*/
+} MS_INDEX;
+
+/*	Byte range returned by a query.					*/
+
+typedef struct _ms_index_range {
+    char	*filename;	/* name of file.			*/
+    int64_t	offset;		/* offset of first record.		*/
+    int64_t	length;		/* length in bytes.			*/
+    MS_INDEX_ENTRY *entry;	/* ptr to index entry.			*/
+} MS_INDEX_RANGE;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_index_build
+   (char	**paths,	/* MiniSEED files or directories.	*/
+    int		npaths,		/* # of paths.				*/
+    char	*indexfile);	/* name of index file to create.	*/
+
+extern MS_INDEX *ms_index_open
+   (char	*indexfile);	/* name of index file.			*/
+
+extern void ms_index_close
+   (MS_INDEX	*ix);		/* ptr to MS_INDEX.			*/
+
+extern int ms_index_query
+   (MS_INDEX	*ix,		/* ptr to MS_INDEX.			*/
+    char	*network,	/* network pattern.			*/
+    char	*station,	/* station pattern.			*/
+    char	*location,	/* location pattern.			*/
+    char	*channel,	/* channel pattern.			*/
+    INT_TIME	t0,		/* start of time window.		*/
+    INT_TIME	t1,		/* end of time window (exclusive).	*/
+    MS_INDEX_RANGE **pranges);	/* array of ranges (returned).		*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
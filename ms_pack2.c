@@ -147,12 +147,34 @@ int ms_pack2_update_hdr
     int		*data)		/* data buffer used for last ms_pack.	*/
 {
     BS		    *bs;	/* ptr to blockette structure.		*/
+    SAMPLE_CLOCK    sc;		/* sample clock for the header.		*/
+    INT_TIME	    begtime;
 
     int seconds, usecs;	
-    /* Update the time in the header.					*/
-    /* Use the actual sample rate in the blockette 100 if it exists.	*/
-    /* Otherwise, use the nominal rate in the data_hdr.			*/
-    if ((bs=find_blockette(hdr,100))) {
+    /* Update the time in the header from its sample clock, which	*/
+    /* uses the actual sample rate in the blockette 100 if it exists,	*/
+    /* and the nominal rate in the data_hdr otherwise.			*/
+    /* The clock stays anchored at the time of the first update, and	*/
+    /* clock_index counts the samples packed since then, so that	*/
+    /* successive updates do not accumulate roundoff error.  The clock	*/
+    /* is re-anchored if the caller has changed the header time.	*/
+    /* If there is no valid clock, advance the time by the interval	*/
+    /* of the data.							*/
+    if (init_sample_clock_hdr (&sc, hdr) == 0) {
+	if (hdr->clock_index > 0 && hdr->clock_index <= INT_MAX - num_samples) {
+	    sc.anchor = hdr->clock_anchor;
+	    if (tdiff (sample_clock_time (&sc, hdr->clock_index), hdr->begtime) != 0)
+		hdr->clock_index = 0;
+	}
+	else hdr->clock_index = 0;
+	if (hdr->clock_index == 0) hdr->clock_anchor = hdr->begtime;
+	sc.anchor = hdr->clock_anchor;
+	hdr->clock_index += num_samples;
+	begtime = sample_clock_time (&sc, hdr->clock_index);
+	hdr->hdrtime = add_dtime (begtime, tdiff (hdr->hdrtime, hdr->begtime));
+	hdr->begtime = begtime;
+    }
+    else if ((bs=find_blockette(hdr,100))) {
 	double actual_rate, dusecs;
         BLOCKETTE_100 *b = (BLOCKETTE_100 *) bs->pb;
 	actual_rate = b->actual_rate;
@@ -266,6 +288,25 @@ int update_miniseed_hdr
     return (0);
 }
 
+/************************************************************************/
+/*  set_record_time:							*/
+/*	Set the begtime and hdrtime of the next record to the time of	*/
+/*	sample n of the data being packed.  The time is computed from	*/
+/*	the sample clock of the initial header, so that record times do	*/
+/*	not accumulate roundoff error.  If the clock is not valid, the	*/
+/*	incrementally updated times are left unchanged.			*/
+/************************************************************************/
+static void set_record_time
+   (DATA_HDR	*hdr,		/* ptr to data hdr to update.		*/
+    DATA_HDR	*hdr0,		/* ptr to initial data hdr.		*/
+    SAMPLE_CLOCK *sc,		/* sample clock for initial data hdr.	*/
+    int		n)		/* index of next sample to pack.	*/
+{
+    if (sc->num <= 0) return;
+    hdr->begtime = sample_clock_time (sc, n);
+    hdr->hdrtime = add_dtime (hdr->begtime, tdiff (hdr0->hdrtime, hdr0->begtime));
+}
+
 /************************************************************************/
 /*  ms_pack2_steim:							*/
 /*	Pack data into Mini-SEED records in STEIM1 or STEIM2 format.	*/
@@ -298,6 +339,7 @@ int ms_pack2_steim
     unsigned char *minbits;	/* min # of bits required to pack data.	*/
     int free_diff = 0;		/* flag to remind whether we free diff.	*/
     int ipt;			/* index of data to pack.		*/
+    SAMPLE_CLOCK sc;		/* sample clock for data to pack.	*/
     int nblks_malloced;		/* # Mini-SEED output blocks malloced.	*/
     int num_blocks;		/* # Mini-SEED block created.		*/
     int samples_remaining;	/* # samples left to cvt to Mini-seed.	*/
@@ -362,6 +404,7 @@ int ms_pack2_steim
 	if (free_diff) free(diff);
 	return (MS_ERROR);
     }
+    init_sample_clock_hdr (&sc, hdr0);
 
     /* Start compressor.						*/
     num_blocks = 0;
@@ -457,6 +500,7 @@ int ms_pack2_steim
 	    hdr->num_samples = nsamples;
 	    update_miniseed_hdr ((SDR_HDR *)p_ms, hdr);
 	    ms_pack2_update_hdr (hdr, 1, nsamples, &data[ipt]);
+	    set_record_time (hdr, hdr0, &sc, ipt + nsamples);
 	    ipt += nsamples;
 	    samples_remaining -= nsamples;
 	    ++num_blocks;
@@ -504,6 +548,7 @@ int ms_pack2_int
     void *p_packed;		/* ptr to packed output data.		*/
     char errmsg[256];		/* error msg buffer.			*/
     int ipt;			/* index of data to pack.		*/
+    SAMPLE_CLOCK sc;		/* sample clock for data to pack.	*/
     int nblks_malloced;		/* # of miniSEED output blocks malloced.*/
     int num_blocks;		/* # of miniSEED block created.		*/
     int samples_remaining;	/* # samples left to cvt to miniseed.	*/
@@ -542,6 +587,7 @@ int ms_pack2_int
     if (hdr == NULL) {
 	return (MS_ERROR);
     }
+    init_sample_clock_hdr (&sc, hdr0);
 
     /* Start compressor.						*/
     num_blocks = 0;
@@ -622,6 +668,7 @@ int ms_pack2_int
 	hdr->num_samples = nsamples;
 	update_miniseed_hdr ((SDR_HDR *)p_ms, hdr);
 	ms_pack2_update_hdr (hdr, 1, nsamples, &data[ipt]);
+	set_record_time (hdr, hdr0, &sc, ipt + nsamples);
 	ipt += nsamples;
 	samples_remaining -= nsamples;
 	++num_blocks;
@@ -665,6 +712,7 @@ int ms_pack2_float
     void *p_packed;		/* ptr to packed output data.		*/
     char errmsg[256];		/* error msg buffer.			*/
     int ipt;			/* index of data to pack.		*/
+    SAMPLE_CLOCK sc;		/* sample clock for data to pack.	*/
     int nblks_malloced;		/* # of miniSEED output blocks malloced.*/
     int num_blocks;		/* # of miniSEED block created.		*/
     int samples_remaining;	/* # samples left to cvt to miniseed.	*/
@@ -703,6 +751,7 @@ int ms_pack2_float
     if (hdr == NULL) {
 	return (MS_ERROR);
     }
+    init_sample_clock_hdr (&sc, hdr0);
 
     /* Start compressor.						*/
     num_blocks = 0;
@@ -772,6 +821,7 @@ int ms_pack2_float
 	hdr->num_samples = nsamples;
 	update_miniseed_hdr ((SDR_HDR *)p_ms, hdr);
 	ms_pack2_update_hdr (hdr, 1, nsamples, (int*)data+ipt);
+	set_record_time (hdr, hdr0, &sc, ipt + nsamples);
 	ipt += nsamples;
 	samples_remaining -= nsamples;
 	++num_blocks;
@@ -815,6 +865,7 @@ int ms_pack2_double
     void *p_packed;		/* ptr to packed output data.		*/
     char errmsg[256];		/* error msg buffer.			*/
     int ipt;			/* index of data to pack.		*/
+    SAMPLE_CLOCK sc;		/* sample clock for data to pack.	*/
     int nblks_malloced;		/* # of miniSEED output blocks malloced.*/
     int num_blocks;		/* # of miniSEED block created.		*/
     int samples_remaining;	/* # samples left to cvt to miniseed.	*/
@@ -853,6 +904,7 @@ int ms_pack2_double
     if (hdr == NULL) {
 	return (MS_ERROR);
     }
+    init_sample_clock_hdr (&sc, hdr0);
 
     /* Start compressor.						*/
     num_blocks = 0;
@@ -922,6 +974,7 @@ int ms_pack2_double
 	hdr->num_samples = nsamples;
 	update_miniseed_hdr ((SDR_HDR *)p_ms, hdr);
 	ms_pack2_update_hdr (hdr, 1, nsamples, (int*)data+ipt);
+	set_record_time (hdr, hdr0, &sc, ipt + nsamples);
 	ipt += nsamples;
 	samples_remaining -= nsamples;
 	++num_blocks;
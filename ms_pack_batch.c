@@ -0,0 +1,355 @@
+/************************************************************************/
+/*  Packing of many MiniSEED channels in parallel.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * Jobs that share a DATA_HDR form a chain, which is packed in order by
+ * one thread so that the channel's seq_no, time, and compressor state
+ * (xm1, xm2) carry from one job to the next.  Chains are the unit of
+ * work.  They are sorted by size, largest first, and dealt to the
+ * threads' deques.  Each thread packs chains from the front of its own
+ * deque, and when it runs out it steals chains from the back of the
+ * other threads' deques.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "ms_pack2.h"
+#include "ms_pack_batch.h"
+
+/*	A chain of jobs for one channel.				*/
+typedef struct _pack_chain {
+    int		first;		/* index of first job in chain order.	*/
+    int		njobs;		/* # of jobs in chain.			*/
+    double	cost;		/* total # of samples in chain.		*/
+} PACK_CHAIN;
+
+/*	Deque of chains for one thread.					*/
+typedef struct _pack_deque {
+    int		*chain;		/* indices of chains.			*/
+    int		front;		/* next chain for owner.		*/
+    int		back;		/* one past last chain, for thieves.	*/
+    pthread_mutex_t lock;	/* lock for front and back.		*/
+} PACK_DEQUE;
+
+/*	State shared by the packing threads.				*/
+typedef struct _pack_state {
+    MS_PACK_JOB	*jobs;		/* array of jobs.			*/
+    int		*order;		/* job indices, grouped by chain.	*/
+    PACK_CHAIN	*chain;		/* array of chains.			*/
+    PACK_DEQUE	*deque;		/* array of deques, one per thread.	*/
+    int		nthreads;	/* # of threads.			*/
+} PACK_STATE;
+
+/*	Argument for each packing thread.				*/
+typedef struct _pack_arg {
+    PACK_STATE	*ps;		/* ptr to shared state.			*/
+    int		id;		/* thread index.			*/
+} PACK_ARG;
+
+/*	Sort key for grouping jobs into chains.				*/
+typedef struct _pack_key {
+    DATA_HDR	*hdr;		/* channel data hdr.			*/
+    int		index;		/* index of job.			*/
+} PACK_KEY;
+
+/************************************************************************/
+/*  cmp_key:								*/
+/*	Compare jobs by DATA_HDR, then by job index.			*/
+/************************************************************************/
+static int cmp_key
+   (const void	*a,		/* ptr to first PACK_KEY.		*/
+    const void	*b)		/* ptr to second PACK_KEY.		*/
+{
+    const PACK_KEY *ka = (const PACK_KEY *)a;
+    const PACK_KEY *kb = (const PACK_KEY *)b;
+
+    if (ka->hdr != kb->hdr) return ((ka->hdr < kb->hdr) ? -1 : 1);
+    return (ka->index - kb->index);
+}
+
+/************************************************************************/
+/*  cmp_chain:								*/
+/*	Compare chains by cost, largest first.				*/
+/************************************************************************/
+static int cmp_chain
+   (const void	*a,		/* ptr to first PACK_CHAIN.		*/
+    const void	*b)		/* ptr to second PACK_CHAIN.		*/
+{
+    const PACK_CHAIN *ca = (const PACK_CHAIN *)a;
+    const PACK_CHAIN *cb = (const PACK_CHAIN *)b;
+
+    if (ca->cost != cb->cost) return ((ca->cost > cb->cost) ? -1 : 1);
+    return (ca->first - cb->first);
+}
+
+/************************************************************************/
+/*  pack_chain:								*/
+/*	Pack the jobs of a chain in order, passing the MiniSEED records	*/
+/*	of each job to its sink.  If a job fails, the remaining jobs of	*/
+/*	the chain are not packed, since their data would not follow	*/
+/*	the channel's last packed record.				*/
+/************************************************************************/
+static void pack_chain
+   (PACK_STATE	*ps,		/* ptr to shared state.			*/
+    PACK_CHAIN	*c)		/* ptr to chain to pack.		*/
+{
+    MS_PACK_JOB	*job;
+    char	*ms;
+    int		failed = 0;
+    int		status, i;
+
+    for (i=0; i<c->njobs; i++) {
+	job = &ps->jobs[ps->order[c->first+i]];
+	job->n_blocks = job->n_samples = 0;
+	job->errmsg[0] = '\0';
+	if (failed) {
+	    sprintf (job->errmsg, "Error: previous job for channel failed in ms_pack_batch\n");
+	    job->status = MS_ERROR;
+	    continue;
+	}
+	ms = NULL;
+	status = ms_pack2_data (job->hdr, job->init_bs, job->num_samples, job->data, 
+				&job->n_blocks, &job->n_samples, &ms, 0, job->errmsg);
+	job->status = (status < 0) ? status : job->n_samples;
+	if (job->n_blocks > 0 && job->sink != NULL &&
+	    (*job->sink)(job->sink_arg, job, ms) < 0) {
+	    if (job->status >= 0) {
+		sprintf (job->errmsg, "Error: sink failed in ms_pack_batch\n");
+		job->status = MS_ERROR;
+	    }
+	}
+	if (ms) free (ms);
+	/* Advance the channel header past the packed data.		*/
+	if (job->n_samples > 0)
+	    ms_pack2_update_hdr (job->hdr, job->n_blocks, job->n_samples, 
+				 (int *)job->data);
+	if (job->status < 0 || job->n_samples < job->num_samples) failed = 1;
+    }
+}
+
+/************************************************************************/
+/*  next_chain:								*/
+/*	Take the next chain for a thread, from the front of its own	*/
+/*	deque, or from the back of another thread's deque.		*/
+/*  return:	index of chain, or -1 if no work remains.		*/
+/************************************************************************/
+static int next_chain
+   (PACK_STATE	*ps,		/* ptr to shared state.			*/
+    int		id)		/* thread index.			*/
+{
+    PACK_DEQUE	*d;
+    int		c = -1;
+    int		i;
+
+    d = &ps->deque[id];
+    pthread_mutex_lock (&d->lock);
+    if (d->front < d->back) c = d->chain[d->front++];
+    pthread_mutex_unlock (&d->lock);
+
+    for (i=1; c < 0 && i<ps->nthreads; i++) {
+	d = &ps->deque[(id+i)%ps->nthreads];
+	pthread_mutex_lock (&d->lock);
+	if (d->front < d->back) c = d->chain[--d->back];
+	pthread_mutex_unlock (&d->lock);
+    }
+    return (c);
+}
+
+/************************************************************************/
+/*  pack_worker:							*/
+/*	Pack chains until no work remains.				*/
+/************************************************************************/
+static void *pack_worker
+   (void	*arg)		/* ptr to PACK_ARG.			*/
+{
+    PACK_ARG	*pa = (PACK_ARG *)arg;
+    int		c;
+
+    while ((c = next_chain (pa->ps, pa->id)) >= 0) 
+	pack_chain (pa->ps, &pa->ps->chain[c]);
+    return (NULL);
+}
+
+/************************************************************************/
+/*  ms_pack_batch:							*/
+/*	Pack many blocks of data into MiniSEED using multiple threads.	*/
+/*	Jobs with the same DATA_HDR are packed in array order by one	*/
+/*	thread, and the DATA_HDR is updated after each job as with	*/
+/*	ms_pack2_update_hdr.  The records of each job are passed to	*/
+/*	the job's sink function, which may be called concurrently for	*/
+/*	jobs of different channels.					*/
+/*  return:								*/
+/*	# of jobs that failed.						*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_pack_batch
+   (MS_PACK_JOB	*jobs,		/* array of jobs to pack.		*/
+    int		njobs,		/* # of jobs.				*/
+    int		nthreads)	/* # of threads (<= 0 for # of cpus).	*/
+{
+    PACK_STATE	ps;
+    PACK_KEY	*key = NULL;
+    PACK_ARG	*pa = NULL;
+    pthread_t	*tid = NULL;
+    int		nchains = 0;
+    int		nstarted = 0;
+    int		nfailed = 0;
+    int		i;
+
+    if (njobs <= 0) return (0);
+    for (i=0; i<njobs; i++) {
+	if (jobs[i].hdr == NULL) return (MS_ERROR);
+    }
+
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads < 1) nthreads = 1;
+
+    memset ((char *)&ps, 0, sizeof(ps));
+    ps.jobs = jobs;
+    if ((key = (PACK_KEY *)malloc (njobs * sizeof(PACK_KEY))) == NULL ||
+	(ps.order = (int *)malloc (njobs * sizeof(int))) == NULL ||
+	(ps.chain = (PACK_CHAIN *)malloc (njobs * sizeof(PACK_CHAIN))) == NULL) {
+	if (key) free ((char *)key);
+	if (ps.order) free ((char *)ps.order);
+	fprintf (stderr, "Error: unable to malloc chains in ms_pack_batch\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Group the jobs into chains by DATA_HDR, in job order.		*/
+    for (i=0; i<njobs; i++) {
+	key[i].hdr = jobs[i].hdr;
+	key[i].index = i;
+    }
+    qsort ((char *)key, njobs, sizeof(PACK_KEY), cmp_key);
+    for (i=0; i<njobs; i++) {
+	ps.order[i] = key[i].index;
+	if (i == 0 || key[i].hdr != key[i-1].hdr) {
+	    ps.chain[nchains].first = i;
+	    ps.chain[nchains].njobs = 0;
+	    ps.chain[nchains].cost = 0;
+	    ++nchains;
+	}
+	ps.chain[nchains-1].njobs++;
+	ps.chain[nchains-1].cost += jobs[key[i].index].num_samples;
+    }
+    free ((char *)key);
+    qsort ((char *)ps.chain, nchains, sizeof(PACK_CHAIN), cmp_chain);
+
+    /* Deal the chains to the threads' deques, largest first.		*/
+    if (nthreads > nchains) nthreads = nchains;
+    ps.nthreads = nthreads;
+    if ((ps.deque = (PACK_DEQUE *)calloc (nthreads, sizeof(PACK_DEQUE))) == NULL) {
+	free ((char *)ps.order);
+	free ((char *)ps.chain);
+	fprintf (stderr, "Error: unable to malloc deques in ms_pack_batch\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    for (i=0; i<nthreads; i++) {
+	ps.deque[i].chain = (int *)malloc (((nchains+nthreads-1)/nthreads) * sizeof(int));
+	if (ps.deque[i].chain == NULL) break;
+	pthread_mutex_init (&ps.deque[i].lock, NULL);
+    }
+    if (i < nthreads) {
+	while (--i >= 0) {
+	    free ((char *)ps.deque[i].chain);
+	    pthread_mutex_destroy (&ps.deque[i].lock);
+	}
+	free ((char *)ps.deque);
+	free ((char *)ps.order);
+	free ((char *)ps.chain);
+	fprintf (stderr, "Error: unable to malloc deques in ms_pack_batch\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    for (i=0; i<nchains; i++) {
+	PACK_DEQUE *d = &ps.deque[i%nthreads];
+	d->chain[d->back++] = i;
+    }
+
+    /* The calling thread is one of the workers.  If a thread cannot	*/
+    /* be created, its chains are stolen by the other threads.		*/
+    if ((tid = (pthread_t *)malloc (nthreads * sizeof(pthread_t))) != NULL &&
+	(pa = (PACK_ARG *)malloc (nthreads * sizeof(PACK_ARG))) != NULL) {
+	for (i=0; i<nthreads; i++) {
+	    pa[i].ps = &ps;
+	    pa[i].id = i;
+	}
+	for (i=1; i<nthreads; i++) {
+	    if (pthread_create (&tid[nstarted], NULL, pack_worker, &pa[i]) == 0)
+		++nstarted;
+	}
+	pack_worker (&pa[0]);
+    }
+    else {
+	PACK_ARG arg;
+	arg.ps = &ps;
+	arg.id = 0;
+	pack_worker (&arg);
+    }
+    for (i=0; i<nstarted; i++) pthread_join (tid[i], NULL);
+    if (tid) free ((char *)tid);
+    if (pa) free ((char *)pa);
+
+    for (i=0; i<nthreads; i++) {
+	free ((char *)ps.deque[i].chain);
+	pthread_mutex_destroy (&ps.deque[i].lock);
+    }
+    free ((char *)ps.deque);
+    free ((char *)ps.order);
+    free ((char *)ps.chain);
+
+    for (i=0; i<njobs; i++) {
+	if (jobs[i].status < 0) ++nfailed;
+    }
+    return (nfailed);
+}
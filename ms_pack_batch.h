@@ -0,0 +1,86 @@
+/************************************************************************/
+/*  Packing of many MiniSEED channels in parallel.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_pack_batch_h
+#define	__ms_pack_batch_h
+
+#include "data_hdr.h"
+#include "qdefines.h"
+
+struct _ms_pack_job;
+
+/*	Sink function called with the MiniSEED records of a job.	*/
+/*	The sink returns 0 on success, or a negative value on error.	*/
+
+typedef int (*MS_PACK_SINK)
+   (void	*arg,		/* sink argument from job.		*/
+    struct _ms_pack_job *job,	/* ptr to job that was packed.		*/
+    char	*ms);		/* ptr to job->n_blocks MiniSEED records.*/
+
+/*	A block of samples to be packed into MiniSEED.			*/
+/*	Jobs that share a DATA_HDR are consecutive data for the same	*/
+/*	channel, and are packed in order by a single thread.		*/
+
+typedef struct _ms_pack_job {
+    DATA_HDR	*hdr;		/* data hdr for channel.  Updated after	*/
+				/* each job for the channel's next job.	*/
+    BS		*init_bs;	/* ptr to onetime blockettes, or NULL.	*/
+    int		num_samples;	/* # of data samples.			*/
+    void	*data;		/* ptr to data buffer.			*/
+    MS_PACK_SINK sink;		/* sink for the MiniSEED records.	*/
+    void	*sink_arg;	/* argument passed to sink.		*/
+    int		status;		/* # samples packed, or error (returned).*/
+    int		n_blocks;	/* # MiniSEED records (returned).	*/
+    int		n_samples;	/* # data samples packed (returned).	*/
+    char	errmsg[QLIB2_ERRMSG_LEN];/* error message (returned).	*/
+} MS_PACK_JOB;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_pack_batch
+   (MS_PACK_JOB	*jobs,		/* array of jobs to pack.		*/
+    int		njobs,		/* # of jobs.				*/
+    int		nthreads);	/* # of threads (<= 0 for # of cpus).	*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
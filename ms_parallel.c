@@ -0,0 +1,450 @@
+/************************************************************************/
+/*  Routines for decoding MiniSEED files in parallel.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_unpack.h"
+#include "ms_parallel.h"
+
+#define	PAR_BLOCK	64	/* # of records claimed at a time.	*/
+#define	MIN_RECLEN	128	/* smallest valid MiniSEED record.	*/
+#define	PAR_NCHANS	64	/* initial size of channel table.	*/
+
+/*	State shared by the decoding threads.				*/
+typedef struct _par_state {
+    char	*buf;		/* buffer containing MiniSEED records.	*/
+    MS_DECODED	*out;		/* decoded output.			*/
+    int		next;		/* next record to be decoded.		*/
+    pthread_mutex_t lock;	/* lock for next.			*/
+} PAR_STATE;
+
+/************************************************************************/
+/*  is_int_format:							*/
+/*	Determine whether a data format unpacks to integer samples.	*/
+/************************************************************************/
+static int is_int_format
+   (int		format)		/* data format.				*/
+{
+    switch (format) {
+      case STEIM1:
+      case STEIM2:
+      case INT_16:
+      case INT_24:
+      case INT_32:
+	return (1);
+      default:
+	return (0);
+    }
+}
+
+/************************************************************************/
+/*  par_worker:								*/
+/*	Decode blocks of records until all records have been claimed.	*/
+/*	Each record is decoded into its own slot of the output array.	*/
+/************************************************************************/
+static void *par_worker
+   (void	*arg)		/* ptr to PAR_STATE.			*/
+{
+    PAR_STATE	*ps = (PAR_STATE *)arg;
+    MS_DECODED	*out = ps->out;
+    MS_REC_INFO	*r;
+    QLIB2_CTX	ctx;
+    int		first, last, i;
+
+    qlib2_ctx_init (&ctx);
+    for (;;) {
+	pthread_mutex_lock (&ps->lock);
+	first = ps->next;
+	ps->next += PAR_BLOCK;
+	pthread_mutex_unlock (&ps->lock);
+	if (first >= out->nrecords) break;
+	last = first + PAR_BLOCK;
+	if (last > out->nrecords) last = out->nrecords;
+	for (i=first; i<last; i++) {
+	    r = &out->rec[i];
+	    if (r->status < 0) continue;
+	    if (r->nsamples == 0) {
+		r->status = 0;
+		continue;
+	    }
+	    r->status = ms_unpack_ctx (&ctx, r->hdr, r->nsamples,
+				       ps->buf + r->offset,
+				       out->data + r->sample_offset);
+	}
+    }
+    qlib2_ctx_free (&ctx);
+    return (NULL);
+}
+
+/************************************************************************/
+/*  par_scan:								*/
+/*	Parse the header of each record in the buffer, and assign each	*/
+/*	record its slot in the output sample array.			*/
+/*  return:								*/
+/*	# of data records on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+static int par_scan
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    MS_DECODED	*out)		/* decoded output.			*/
+{
+    QLIB2_CTX	ctx;
+    DATA_HDR	*hdr;
+    MS_REC_INFO	*r;
+    int64_t	offset = 0;
+    int		maxrec = 0;
+
+    qlib2_ctx_init (&ctx);
+    while (nbytes - offset >= MIN_RECLEN) {
+	if ((hdr = decode_hdr_sdr_ctx (&ctx, (SDR_HDR *)(buf + offset),
+				       (int)MIN(nbytes - offset, 1<<30))) == NULL) {
+	    fprintf (stderr, "Error: invalid MiniSEED record at offset %lld\n",
+		     (long long)offset);
+	    fflush (stderr);
+	    qlib2_ctx_free (&ctx);
+	    return (MS_ERROR);
+	}
+	if (hdr->blksize < MIN_RECLEN || hdr->blksize > nbytes - offset) {
+	    fprintf (stderr, "Error: invalid blksize %d at offset %lld\n",
+		     hdr->blksize, (long long)offset);
+	    fflush (stderr);
+	    free_data_hdr (hdr);
+	    qlib2_ctx_free (&ctx);
+	    return (MS_ERROR);
+	}
+	if (is_vol_hdr_ind (hdr->record_type)) {
+	    /* Skip volume header records.				*/
+	    offset += hdr->blksize;
+	    free_data_hdr (hdr);
+	    continue;
+	}
+	if (out->nrecords >= maxrec) {
+	    maxrec = (maxrec) ? 2 * maxrec : 1024;
+	    r = (MS_REC_INFO *)realloc (out->rec, maxrec * sizeof(MS_REC_INFO));
+	    if (r == NULL) {
+		fprintf (stderr, "Error: unable to malloc record info\n");
+		fflush (stderr);
+		free_data_hdr (hdr);
+		qlib2_ctx_free (&ctx);
+		if (QLIB2_CLASSIC) exit(1);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	    out->rec = r;
+	}
+	r = &out->rec[out->nrecords++];
+	r->offset = offset;
+	r->blksize = hdr->blksize;
+	r->nsamples = hdr->num_samples;
+	r->sample_offset = out->nsamples;
+	r->status = 0;
+	r->continuity = -1;
+	r->hdr = hdr;
+	if (r->nsamples > 0 && ! is_int_format (hdr->data_type)) {
+	    /* Only integer data can be placed in the output array.	*/
+	    r->nsamples = 0;
+	    r->status = MS_ERROR;
+	}
+	out->nsamples += r->nsamples;
+	offset += hdr->blksize;
+    }
+    qlib2_ctx_free (&ctx);
+    return (out->nrecords);
+}
+
+/************************************************************************/
+/*  sncl_hash:								*/
+/*	Return a hash of the network, station, location and channel	*/
+/*	names of a DATA_HDR.						*/
+/************************************************************************/
+static unsigned int sncl_hash
+   (DATA_HDR	*h)		/* ptr to DATA_HDR.			*/
+{
+    unsigned int v = 2166136261u;
+    char	*name[4];
+    char	*p;
+    int		i;
+
+    name[0] = h->network_id;
+    name[1] = h->station_id;
+    name[2] = h->location_id;
+    name[3] = h->channel_id;
+    for (i=0; i<4; i++) {
+	for (p=name[i]; *p; p++) v = (v ^ (unsigned char)*p) * 16777619u;
+	v = (v ^ '.') * 16777619u;
+    }
+    return (v);
+}
+
+/************************************************************************/
+/*  same_sncl:								*/
+/*	Determine whether two DATA_HDRs are for the same channel.	*/
+/************************************************************************/
+static int same_sncl
+   (DATA_HDR	*a,		/* ptr to first DATA_HDR.		*/
+    DATA_HDR	*b)		/* ptr to second DATA_HDR.		*/
+{
+    return (strcmp(a->station_id, b->station_id) == 0 &&
+	    strcmp(a->network_id, b->network_id) == 0 &&
+	    strcmp(a->channel_id, b->channel_id) == 0 &&
+	    strcmp(a->location_id, b->location_id) == 0);
+}
+
+/************************************************************************/
+/*  par_continuity:							*/
+/*	Verify that the xm1 of each Steim record matches the xn of the	*/
+/*	previous record of the same channel.  Records decoded by	*/
+/*	different threads are checked across the chunk boundaries.	*/
+/*	The last record of each channel is kept in a local hash table	*/
+/*	keyed on the channel names, which grows by doubling.		*/
+/************************************************************************/
+static void par_continuity
+   (MS_DECODED	*out)		/* decoded output.			*/
+{
+    int		*last = NULL;	/* last record index of each channel.	*/
+    int		*q;
+    unsigned int size = 0;	/* # of slots in last (power of 2).	*/
+    unsigned int nsize, k, n;
+    int		nchan = 0;
+    int		i, j;
+    DATA_HDR	*h, *p;
+
+    for (i=0; i<out->nrecords; i++) {
+	h = out->rec[i].hdr;
+	/* Keep the table at most half full.				*/
+	if (2 * (unsigned int)(nchan + 1) > size) {
+	    nsize = (size > 0) ? 2 * size : 2 * PAR_NCHANS;
+	    if ((q = (int *)malloc (nsize * sizeof(int))) == NULL) break;
+	    for (k=0; k<nsize; k++) q[k] = -1;
+	    for (k=0; k<size; k++) {
+		if ((j = last[k]) < 0) continue;
+		for (n = sncl_hash (out->rec[j].hdr) & (nsize-1); q[n] >= 0; 
+		     n = (n+1) & (nsize-1)) ;
+		q[n] = j;
+	    }
+	    if (last) free ((char *)last);
+	    last = q;
+	    size = nsize;
+	}
+	for (k = sncl_hash (h) & (size-1); (j = last[k]) >= 0; k = (k+1) & (size-1)) {
+	    if (same_sncl (h, out->rec[j].hdr)) break;
+	}
+	if (j < 0) {
+	    last[k] = i;
+	    ++nchan;
+	    continue;
+	}
+	p = out->rec[j].hdr;
+	if (out->rec[i].status > 0 && out->rec[j].status > 0 &&
+	    IS_STEIM_COMP(h->data_type) && IS_STEIM_COMP(p->data_type)) {
+	    out->rec[i].continuity = (h->xm1 == p->xn);
+	    if (! out->rec[i].continuity) ++out->ndiscontinuities;
+	}
+	last[k] = i;
+    }
+    if (last) free ((char *)last);
+}
+
+/************************************************************************/
+/*  ms_decode_buf_parallel:						*/
+/*	Decode all MiniSEED records in a buffer using multiple threads.	*/
+/*	The samples of all records are placed in a single integer array	*/
+/*	in record order.  Volume header records are skipped.  Records	*/
+/*	with non-integer data are not decoded, and are counted as	*/
+/*	errors.								*/
+/*  return:								*/
+/*	# of data records on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_decode_buf_parallel
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int		nthreads,	/* # of threads (<= 0 for # of cpus).	*/
+    MS_DECODED	*out)		/* decoded output (returned).		*/
+{
+    PAR_STATE	ps;
+    pthread_t	*tid;
+    int		nstarted = 0;
+    int		status, i;
+
+    memset ((void *)out, 0, sizeof(MS_DECODED));
+    if ((status = par_scan (buf, nbytes, out)) < 0) {
+	ms_decoded_free (out);
+	return (status);
+    }
+
+    out->data = (int *)malloc ((out->nsamples > 0 ? out->nsamples : 1) * sizeof(int));
+    if (out->data == NULL) {
+	fprintf (stderr, "Error: unable to malloc data buffer\n");
+	fflush (stderr);
+	ms_decoded_free (out);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > (out->nrecords + PAR_BLOCK - 1) / PAR_BLOCK)
+	nthreads = (out->nrecords + PAR_BLOCK - 1) / PAR_BLOCK;
+    if (nthreads < 1) nthreads = 1;
+
+    ps.buf = buf;
+    ps.out = out;
+    ps.next = 0;
+    pthread_mutex_init (&ps.lock, NULL);
+
+    /* The calling thread is one of the workers.			*/
+    if ((tid = (pthread_t *)malloc (nthreads * sizeof(pthread_t))) != NULL) {
+	for (i=1; i<nthreads; i++) {
+	    if (pthread_create (&tid[nstarted], NULL, par_worker, &ps) == 0)
+		++nstarted;
+	}
+    }
+    par_worker (&ps);
+    for (i=0; i<nstarted; i++) pthread_join (tid[i], NULL);
+    if (tid) free ((char *)tid);
+    pthread_mutex_destroy (&ps.lock);
+
+    for (i=0; i<out->nrecords; i++) {
+	if (out->rec[i].status < 0) ++out->nerrors;
+    }
+    par_continuity (out);
+    return (out->nrecords);
+}
+
+/************************************************************************/
+/*  ms_decode_file_parallel:						*/
+/*	Decode all MiniSEED records in a file using multiple threads.	*/
+/*	The file is mapped into memory if possible, otherwise read.	*/
+/*  return:								*/
+/*	# of data records on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_decode_file_parallel
+   (char	*filename,	/* name of MiniSEED file.		*/
+    int		nthreads,	/* # of threads (<= 0 for # of cpus).	*/
+    MS_DECODED	*out)		/* decoded output (returned).		*/
+{
+    struct stat	sb;
+    char	*buf;
+    int		mapped = 1;
+    int		fd, status;
+    ssize_t	n;
+    int64_t	nread;
+
+    memset ((void *)out, 0, sizeof(MS_DECODED));
+    if ((fd = open (filename, O_RDONLY)) < 0) {
+	fprintf (stderr, "Error: unable to open %s\n", filename);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    if (fstat (fd, &sb) != 0) {
+	fprintf (stderr, "Error: unable to stat %s\n", filename);
+	fflush (stderr);
+	close (fd);
+	return (MS_ERROR);
+    }
+    if (sb.st_size == 0) {
+	close (fd);
+	return (0);
+    }
+
+    buf = mmap (NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED) {
+	/* Read the file if it cannot be mapped.			*/
+	mapped = 0;
+	if ((buf = (char *)malloc ((size_t)sb.st_size)) == NULL) {
+	    fprintf (stderr, "Error: unable to malloc buffer for %s\n", filename);
+	    fflush (stderr);
+	    close (fd);
+	    if (QLIB2_CLASSIC) exit(1);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	for (nread = 0; nread < sb.st_size; nread += n) {
+	    if ((n = read (fd, buf + nread, (size_t)(sb.st_size - nread))) <= 0) {
+		fprintf (stderr, "Error: unable to read %s\n", filename);
+		fflush (stderr);
+		free (buf);
+		close (fd);
+		return (MS_ERROR);
+	    }
+	}
+    }
+#ifdef	MADV_SEQUENTIAL
+    else madvise (buf, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+    close (fd);
+
+    status = ms_decode_buf_parallel (buf, (int64_t)sb.st_size, nthreads, out);
+
+    if (mapped) munmap (buf, (size_t)sb.st_size);
+    else free (buf);
+    return (status);
+}
+
+/************************************************************************/
+/*  ms_decoded_free:							*/
+/*	Free all storage allocated within an MS_DECODED structure.	*/
+/************************************************************************/
+void ms_decoded_free
+   (MS_DECODED	*out)		/* ptr to MS_DECODED.			*/
+{
+    int i;
+    if (out->rec) {
+	for (i=0; i<out->nrecords; i++) {
+	    if (out->rec[i].hdr) free_data_hdr (out->rec[i].hdr);
+	}
+	free ((char *)out->rec);
+    }
+    if (out->data) free ((char *)out->data);
+    memset ((void *)out, 0, sizeof(MS_DECODED));
+}
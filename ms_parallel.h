@@ -0,0 +1,92 @@
+/************************************************************************/
+/*  Routines for decoding MiniSEED files in parallel.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_parallel_h
+#define	__ms_parallel_h
+
+#include <sys/types.h>
+#include "data_hdr.h"
+
+/*	Information about one record of a parallel decode.		*/
+
+typedef struct _ms_rec_info {
+    int64_t	offset;		/* byte offset of record in input.	*/
+    int		blksize;	/* record size in bytes.		*/
+    int		nsamples;	/* # of samples in record header.	*/
+    int64_t	sample_offset;	/* index of first sample in data array.	*/
+    int		status;		/* # of samples decoded, or error code.	*/
+    int		continuity;	/* 1 if xm1 matches xn of previous	*/
+				/* record of the channel, 0 if not,	*/
+				/* -1 if not checked.			*/
+    DATA_HDR	*hdr;		/* DATA_HDR for record.			*/
+} MS_REC_INFO;
+
+/*	Result of a parallel decode.					*/
+
+typedef struct _ms_decoded {
+    int		nrecords;	/* # of data records.			*/
+    MS_REC_INFO	*rec;		/* array of record information.		*/
+    int		*data;		/* samples of all records, in order.	*/
+    int64_t	nsamples;	/* # of samples in data array.		*/
+    int		nerrors;	/* # of records that failed to decode.	*/
+    int		ndiscontinuities;/* # of records failing xm1 check.	*/
+} MS_DECODED;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_decode_buf_parallel
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int		nthreads,	/* # of threads (<= 0 for # of cpus).	*/
+    MS_DECODED	*out);		/* decoded output (returned).		*/
+
+extern int ms_decode_file_parallel
+   (char	*filename,	/* name of MiniSEED file.		*/
+    int		nthreads,	/* # of threads (<= 0 for # of cpus).	*/
+    MS_DECODED	*out);		/* decoded output (returned).		*/
+
+extern void ms_decoded_free
+   (MS_DECODED	*out);		/* ptr to MS_DECODED.			*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,583 @@
+/************************************************************************/
+/*  Pipelined reading and decoding of MiniSEED records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * The pipeline consists of a reader thread, one or more decoder
+ * threads, and the calling thread, which runs the consumer function.
+ * Each decoder has its own lane of three single-producer/single-consumer
+ * rings:
+ *	in:	reader -> decoder	raw records to be decoded.
+ *	out:	decoder -> consumer	decoded records.
+ *	free:	consumer -> reader	empty slots to be reused.
+ * A fixed set of slots (record buffer, DATA_HDR, blockette list, and
+ * sample buffer) circulates within each lane.  The reader reads the raw
+ * record into the slot and decodes its header into the slot's DATA_HDR
+ * with decode_hdr_sdr_into, so no allocation is done per record once
+ * the sample buffers have grown to the size of the largest record.
+ * The reader deals records to the lanes in round-robin order, and the
+ * consumer collects them in the same order, so records are delivered
+ * to the consumer in file order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_utils.h"
+#include "ms_unpack.h"
+#include "ms_scan.h"
+#include "ms_pipeline.h"
+
+#define	FIXED_DATA_HDR_SIZE 48
+
+#define	PIPE_DEPTH	8	/* default # of slots per lane.		*/
+#define	PIPE_RECLEN	65536	/* size of slot record buffer.		*/
+#define	PIPE_NBS	32	/* max # of blockettes per record.	*/
+#define	PIPE_READLEN	64	/* header read size until blksize known.*/
+#define	PIPE_SPINS	64	/* # of busy polls before yielding.	*/
+#define	PIPE_YIELDS	128	/* # of yields before sleeping.		*/
+#define	PIPE_SLEEP_NS	50000	/* sleep interval when idle.		*/
+#define	CACHE_LINE	64
+
+/* The rings are lock-free when the compiler provides atomic builtins.	*/
+/* Otherwise each ring operation is protected by a mutex.		*/
+#if defined(__GNUC__)
+#define	LOAD_IDX(p)	__atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define	STORE_IDX(p,v)	__atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#define	RING_LOCK(r)
+#define	RING_UNLOCK(r)
+#else
+#define	RING_MUTEX
+#define	LOAD_IDX(p)	(p)
+#define	STORE_IDX(p,v)	((p) = (v))
+#define	RING_LOCK(r)	pthread_mutex_lock(&(r)->lock)
+#define	RING_UNLOCK(r)	pthread_mutex_unlock(&(r)->lock)
+#endif
+
+/*	Single-producer/single-consumer ring of pointers.		*/
+/*	head is written only by the producer, tail only by the		*/
+/*	consumer.  They are kept on separate cache lines.		*/
+typedef struct _pipe_ring {
+    void	**item;		/* ring entries.			*/
+    unsigned int mask;		/* # of entries - 1 (power of 2).	*/
+#ifdef	RING_MUTEX
+    pthread_mutex_t lock;	/* lock for ring operations.		*/
+#endif
+    char	pad1[CACHE_LINE];
+    unsigned int head;		/* next entry to be written.		*/
+    char	pad2[CACHE_LINE];
+    unsigned int tail;		/* next entry to be read.		*/
+    char	pad3[CACHE_LINE];
+} PIPE_RING;
+
+/*	A record in flight through the pipeline.			*/
+typedef struct _pipe_slot {
+    char	*rec;		/* raw MiniSEED record.			*/
+    DATA_HDR	hdr;		/* DATA_HDR for record.			*/
+    BS		bs[PIPE_NBS];	/* blockettes of hdr (point into rec).	*/
+    void	*data;		/* decoded samples.			*/
+    int		data_len;	/* size of data buffer in bytes.	*/
+    int		status;		/* # of samples, or error code.		*/
+} PIPE_SLOT;
+
+struct _pipe_state;
+
+/*	One decoder and its rings.					*/
+typedef struct _pipe_lane {
+    struct _pipe_state *ps;	/* ptr to pipeline state.		*/
+    PIPE_RING	in;		/* reader -> decoder.			*/
+    PIPE_RING	out;		/* decoder -> consumer.			*/
+    PIPE_RING	free;		/* consumer -> reader.			*/
+    PIPE_SLOT	*slot;		/* slots belonging to this lane.	*/
+    pthread_t	tid;		/* decoder thread.			*/
+} PIPE_LANE;
+
+/*	State shared by all stages of the pipeline.			*/
+typedef struct _pipe_state {
+    FILE	*fp;		/* FILE pointer for input file.		*/
+    int		nlanes;		/* # of decoder lanes.			*/
+    int		depth;		/* # of slots per lane.			*/
+    PIPE_LANE	*lane;		/* array of lanes.			*/
+    int		stop;		/* set by consumer to stop the reader.	*/
+    int		status;		/* read status when reader finished.	*/
+    char	errmsg[QLIB2_ERRMSG_LEN];/* reader error message.	*/
+    char	end;		/* end of stream marker (address only).	*/
+} PIPE_STATE;
+
+/************************************************************************/
+/*  ring_init:								*/
+/*	Initialize a ring with room for at least n entries.		*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int ring_init
+   (PIPE_RING	*r,		/* ptr to PIPE_RING.			*/
+    int		n)		/* minimum # of entries.		*/
+{
+    unsigned int size = 1;
+
+    while (size < (unsigned int)n) size <<= 1;
+    memset ((char *)r, 0, sizeof(PIPE_RING));
+    if ((r->item = (void **)malloc (size * sizeof(void *))) == NULL)
+	return (QLIB2_MALLOC_ERROR);
+    r->mask = size - 1;
+#ifdef	RING_MUTEX
+    pthread_mutex_init (&r->lock, NULL);
+#endif
+    return (0);
+}
+
+/************************************************************************/
+/*  ring_free:								*/
+/*	Free the space used by a ring.					*/
+/************************************************************************/
+static void ring_free
+   (PIPE_RING	*r)		/* ptr to PIPE_RING.			*/
+{
+    if (r->item) free ((char *)r->item);
+    r->item = NULL;
+#ifdef	RING_MUTEX
+    pthread_mutex_destroy (&r->lock);
+#endif
+}
+
+/************************************************************************/
+/*  ring_push:								*/
+/*	Add an entry to a ring.  Called only by the producer.		*/
+/*  return:	1 on success, 0 if the ring is full.			*/
+/************************************************************************/
+static int ring_push
+   (PIPE_RING	*r,		/* ptr to PIPE_RING.			*/
+    void	*p)		/* entry to add.			*/
+{
+    unsigned int head;
+
+    RING_LOCK(r);
+    head = r->head;
+    if (head - LOAD_IDX(r->tail) > r->mask) {
+	RING_UNLOCK(r);
+	return (0);
+    }
+    r->item[head & r->mask] = p;
+    STORE_IDX(r->head, head + 1);
+    RING_UNLOCK(r);
+    return (1);
+}
+
+/************************************************************************/
+/*  ring_pop:								*/
+/*	Remove an entry from a ring.  Called only by the consumer.	*/
+/*  return:	entry on success, NULL if the ring is empty.		*/
+/************************************************************************/
+static void *ring_pop
+   (PIPE_RING	*r)		/* ptr to PIPE_RING.			*/
+{
+    unsigned int tail;
+    void *p;
+
+    RING_LOCK(r);
+    tail = r->tail;
+    if (tail == LOAD_IDX(r->head)) {
+	RING_UNLOCK(r);
+	return (NULL);
+    }
+    p = r->item[tail & r->mask];
+    STORE_IDX(r->tail, tail + 1);
+    RING_UNLOCK(r);
+    return (p);
+}
+
+/************************************************************************/
+/*  pipe_wait:								*/
+/*	Back off while waiting on a ring.  Poll briefly, then yield	*/
+/*	the cpu, then sleep, so that an idle stage does not consume	*/
+/*	cpu time needed by the other stages.				*/
+/************************************************************************/
+static void pipe_wait
+   (int		*nwait)		/* # of times we have waited so far.	*/
+{
+    struct timespec ts;
+
+    if (*nwait < PIPE_SPINS) {
+	;
+    }
+    else if (*nwait < PIPE_SPINS + PIPE_YIELDS) {
+	sched_yield ();
+    }
+    else {
+	ts.tv_sec = 0;
+	ts.tv_nsec = PIPE_SLEEP_NS;
+	nanosleep (&ts, NULL);
+    }
+    ++*nwait;
+}
+
+/************************************************************************/
+/*  pipe_get:								*/
+/*	Remove the next entry from a ring, waiting until one is		*/
+/*	available.  If stop is non-NULL, give up when *stop is set.	*/
+/*  return:	entry on success, NULL if stopped.			*/
+/************************************************************************/
+static void *pipe_get
+   (PIPE_RING	*r,		/* ptr to PIPE_RING.			*/
+    int		*stop)		/* ptr to stop flag, or NULL.		*/
+{
+    void *p;
+    int nwait = 0;
+
+    while ((p = ring_pop (r)) == NULL) {
+	if (stop && LOAD_IDX(*stop)) return (NULL);
+	pipe_wait (&nwait);
+    }
+    return (p);
+}
+
+/************************************************************************/
+/*  pipe_put:								*/
+/*	Add an entry to a ring, waiting until there is room.		*/
+/************************************************************************/
+static void pipe_put
+   (PIPE_RING	*r,		/* ptr to PIPE_RING.			*/
+    void	*p)		/* entry to add.			*/
+{
+    int nwait = 0;
+
+    while (ring_push (r, p) == 0) pipe_wait (&nwait);
+}
+
+/************************************************************************/
+/*  pipe_read_record:							*/
+/*	Read the next MiniSEED record into a slot buffer, and decode	*/
+/*	its header into the slot's DATA_HDR.  The header is read in	*/
+/*	small pieces until the blksize is known, then the remainder of	*/
+/*	the record is read.  Since the blksize is a multiple of		*/
+/*	PIPE_READLEN, we never read past the end of the record.		*/
+/*	Volume headers are read and skipped.				*/
+/*  return:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+static int pipe_read_record
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    PIPE_SLOT	*sp,		/* ptr to slot for record.		*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    char	*rec = sp->rec;
+    int		offset, blksize, n;
+
+    while (1) {
+	if ((n = fread (rec, 1, FIXED_DATA_HDR_SIZE, fp)) == 0) return (EOF);
+	if (n != FIXED_DATA_HDR_SIZE) {
+	    qlib2_ctx_error (ctx, "Error: short record in ms_pipeline_run\n");
+	    return (MS_ERROR);
+	}
+	offset = FIXED_DATA_HDR_SIZE;
+	while ((blksize = ms_record_length (rec, offset)) == 0) {
+	    n = PIPE_READLEN - (offset % PIPE_READLEN);
+	    if (offset + n > PIPE_RECLEN || fread (rec+offset, n, 1, fp) != 1) {
+		qlib2_ctx_error (ctx, "Error: unable to read header in ms_pipeline_run\n");
+		return (MS_ERROR);
+	    }
+	    offset += n;
+	}
+	if (blksize < 0) {
+	    qlib2_ctx_error (ctx, "Error: invalid record header in ms_pipeline_run\n");
+	    return (MS_ERROR);
+	}
+	if (blksize > PIPE_RECLEN || blksize < offset) {
+	    qlib2_ctx_error (ctx, "Error: invalid record size in ms_pipeline_run\n");
+	    return (MS_ERROR);
+	}
+	if (blksize > offset &&
+	    fread (rec+offset, blksize-offset, 1, fp) != 1) {
+	    qlib2_ctx_error (ctx, "Error: short record in ms_pipeline_run\n");
+	    return (MS_ERROR);
+	}
+	/* Skip volume headers.						*/
+	if (is_vol_hdr_ind (((SDR_HDR *)rec)->data_hdr_ind)) continue;
+	if (decode_hdr_sdr_into (ctx, (SDR_HDR *)rec, blksize, &sp->hdr, 
+				 sp->bs, PIPE_NBS) == NULL) {
+	    qlib2_ctx_error (ctx, "Error: unable to decode header in ms_pipeline_run\n");
+	    return (MS_ERROR);
+	}
+	return (blksize);
+    }
+}
+
+/************************************************************************/
+/*  pipe_reader:							*/
+/*	Read records from the input file and deal them to the decoder	*/
+/*	lanes in round-robin order.  On EOF, error, or a stop request	*/
+/*	from the consumer, send the end marker down every lane.		*/
+/************************************************************************/
+static void *pipe_reader
+   (void	*arg)		/* ptr to PIPE_STATE.			*/
+{
+    PIPE_STATE	*ps = (PIPE_STATE *)arg;
+    PIPE_LANE	*lp;
+    PIPE_SLOT	*sp = NULL;
+    QLIB2_CTX	ctx;
+    int		status = EOF;
+    int		n, i;
+
+    qlib2_ctx_init (&ctx);
+    for (n=0; ; n=(n+1)%ps->nlanes) {
+	lp = &ps->lane[n];
+	/* The consumer keeps recycling slots after a stop, so check	*/
+	/* for a stop before reading each record.			*/
+	if (LOAD_IDX(ps->stop) ||
+	    (sp = (PIPE_SLOT *)pipe_get (&lp->free, &ps->stop)) == NULL) {
+	    status = EOF;
+	    break;
+	}
+	if ((status = pipe_read_record (&ctx, sp, ps->fp)) < 0) break;
+	pipe_put (&lp->in, sp);
+    }
+    if (status < 0 && status != EOF) strcpy (ps->errmsg, ctx.errmsg);
+    ps->status = status;
+
+    /* The in rings have room for every slot plus the end marker,	*/
+    /* so these never wait.						*/
+    for (i=0; i<ps->nlanes; i++) pipe_put (&ps->lane[i].in, &ps->end);
+    qlib2_ctx_free (&ctx);
+    return (NULL);
+}
+
+/************************************************************************/
+/*  pipe_decoder:							*/
+/*	Decode records from the lane's in ring and pass them to the	*/
+/*	consumer through the lane's out ring.				*/
+/************************************************************************/
+static void *pipe_decoder
+   (void	*arg)		/* ptr to PIPE_LANE.			*/
+{
+    PIPE_LANE	*lp = (PIPE_LANE *)arg;
+    PIPE_SLOT	*sp;
+    QLIB2_CTX	ctx;
+    void	*p;
+    int		len;
+
+    qlib2_ctx_init (&ctx);
+    while ((p = pipe_get (&lp->in, NULL)) != &lp->ps->end) {
+	sp = (PIPE_SLOT *)p;
+	/* Room for the largest sample type.				*/
+	len = sp->hdr.num_samples * sizeof(double);
+	if (len > sp->data_len) {
+	    if ((p = realloc (sp->data, len)) == NULL) {
+		sp->status = QLIB2_MALLOC_ERROR;
+		pipe_put (&lp->out, sp);
+		continue;
+	    }
+	    sp->data = p;
+	    sp->data_len = len;
+	}
+	sp->status = (sp->hdr.num_samples > 0) ?
+	    ms_unpack_ctx (&ctx, &sp->hdr, sp->hdr.num_samples, sp->rec, sp->data) : 0;
+	pipe_put (&lp->out, sp);
+    }
+    pipe_put (&lp->out, p);
+    qlib2_ctx_free (&ctx);
+    return (NULL);
+}
+
+/************************************************************************/
+/*  pipe_free:								*/
+/*	Free the lanes and their slots.					*/
+/************************************************************************/
+static void pipe_free
+   (PIPE_STATE	*ps)		/* ptr to PIPE_STATE.			*/
+{
+    PIPE_LANE	*lp;
+    PIPE_SLOT	*sp;
+    int		i, j;
+
+    for (i=0; i<ps->nlanes; i++) {
+	lp = &ps->lane[i];
+	if (lp->slot) {
+	    for (j=0; j<ps->depth; j++) {
+		sp = &lp->slot[j];
+		if (sp->rec) free (sp->rec);
+		if (sp->data) free (sp->data);
+	    }
+	    free ((char *)lp->slot);
+	}
+	ring_free (&lp->in);
+	ring_free (&lp->out);
+	ring_free (&lp->free);
+    }
+    free ((char *)ps->lane);
+}
+
+/************************************************************************/
+/*  ms_pipeline_run:							*/
+/*	Read and decode all MiniSEED records from a file, overlapping	*/
+/*	reading, decoding, and processing of the records.		*/
+/*	One thread reads records, ndecoders threads decode them, and	*/
+/*	the calling thread passes each decoded record to the consumer	*/
+/*	function fn in file order.  Volume headers are skipped.		*/
+/*  return:								*/
+/*	# of records passed to the consumer on EOF or consumer stop.	*/
+/*	negative QLIB2 error code on read error.			*/
+/************************************************************************/
+int ms_pipeline_run
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    int		ndecoders,	/* # of decoder threads (<= 0 for cpus).*/
+    int		depth,		/* # of records in flight per decoder.	*/
+    MS_PIPELINE_FN fn,		/* consumer function.			*/
+    void	*arg)		/* user argument passed to consumer.	*/
+{
+    PIPE_STATE	ps;
+    PIPE_LANE	*lp;
+    PIPE_SLOT	*sp;
+    pthread_t	reader;
+    void	*p;
+    int		nrecords = 0;
+    int		nstarted = 0;
+    int		stopped = 0;
+    int		status = 0;
+    int		i, j;
+
+    if (ndecoders <= 0) ndecoders = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ndecoders < 1) ndecoders = 1;
+    if (depth <= 0) depth = PIPE_DEPTH;
+
+    memset ((char *)&ps, 0, sizeof(ps));
+    ps.fp = fp;
+    ps.nlanes = ndecoders;
+    ps.depth = depth;
+    if ((ps.lane = (PIPE_LANE *)calloc (ndecoders, sizeof(PIPE_LANE))) == NULL) {
+	fprintf (stderr, "Error: unable to malloc lanes in ms_pipeline_run\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Each ring has room for all of the lane's slots plus the end	*/
+    /* marker, so that the end marker can always be queued.		*/
+    for (i=0; i<ndecoders; i++) {
+	lp = &ps.lane[i];
+	lp->ps = &ps;
+	if (ring_init (&lp->in, depth+1) < 0 ||
+	    ring_init (&lp->out, depth+1) < 0 ||
+	    ring_init (&lp->free, depth+1) < 0 ||
+	    (lp->slot = (PIPE_SLOT *)calloc (depth, sizeof(PIPE_SLOT))) == NULL) {
+	    status = QLIB2_MALLOC_ERROR;
+	    break;
+	}
+	for (j=0; j<depth; j++) {
+	    sp = &lp->slot[j];
+	    if ((sp->rec = (char *)malloc (PIPE_RECLEN)) == NULL) {
+		status = QLIB2_MALLOC_ERROR;
+		break;
+	    }
+	    ring_push (&lp->free, sp);
+	}
+	if (status < 0) break;
+    }
+    if (status < 0) {
+	pipe_free (&ps);
+	fprintf (stderr, "Error: unable to malloc buffers in ms_pipeline_run\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Start the decoders.  If we cannot start all of them, run	*/
+    /* with the lanes whose decoders did start.				*/
+    for (i=0; i<ndecoders; i++) {
+	if (pthread_create (&ps.lane[i].tid, NULL, pipe_decoder, &ps.lane[i]) != 0)
+	    break;
+	++nstarted;
+    }
+    ps.nlanes = nstarted;
+    if (nstarted == 0 || pthread_create (&reader, NULL, pipe_reader, &ps) != 0) {
+	for (i=0; i<nstarted; i++) {
+	    ring_push (&ps.lane[i].in, &ps.end);
+	    pthread_join (ps.lane[i].tid, NULL);
+	}
+	ps.nlanes = ndecoders;
+	pipe_free (&ps);
+	fprintf (stderr, "Error: unable to create threads in ms_pipeline_run\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (MS_ERROR);
+    }
+
+    /* Consume records in the order in which they were dealt.		*/
+    /* After a stop, keep draining until the end marker so that the	*/
+    /* slots are returned to their lanes.				*/
+    for (i=0; ; i=(i+1)%nstarted) {
+	lp = &ps.lane[i];
+	if ((p = pipe_get (&lp->out, NULL)) == &ps.end) break;
+	sp = (PIPE_SLOT *)p;
+	if (! stopped) {
+	    ++nrecords;
+	    if ((*fn)(arg, &sp->hdr, sp->data, sp->status) != 0) {
+		stopped = 1;
+		STORE_IDX(ps.stop, 1);
+	    }
+	}
+	ring_push (&lp->free, sp);
+    }
+
+    pthread_join (reader, NULL);
+    for (i=0; i<nstarted; i++) pthread_join (ps.lane[i].tid, NULL);
+    status = ps.status;
+    ps.nlanes = ndecoders;
+    pipe_free (&ps);
+
+    if (status < 0 && status != EOF) {
+	fprintf (stderr, "%s", ps.errmsg[0] ? ps.errmsg : 
+		 "Error: unable to read record in ms_pipeline_run\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (status);
+    }
+    return (nrecords);
+}
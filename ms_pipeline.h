@@ -0,0 +1,72 @@
+/************************************************************************/
+/*  Pipelined reading and decoding of MiniSEED records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_pipeline_h
+#define	__ms_pipeline_h
+
+#include <stdio.h>
+#include "data_hdr.h"
+
+/*	Consumer function called for each decoded record, in file order.*/
+/*	status is the # of samples decoded, or an error code if the	*/
+/*	record could not be decoded.  The hdr and data are owned by	*/
+/*	the pipeline and are valid only for the duration of the call.	*/
+/*	The consumer returns 0 to continue, or non-zero to stop.	*/
+
+typedef int (*MS_PIPELINE_FN)
+   (void	*arg,		/* user argument.			*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR for record.		*/
+    void	*data,		/* ptr to decoded samples.		*/
+    int		status);	/* # of samples, or error code.		*/
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_pipeline_run
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    int		ndecoders,	/* # of decoder threads (<= 0 for cpus).*/
+    int		depth,		/* # of records in flight per decoder.	*/
+    MS_PIPELINE_FN fn,		/* consumer function.			*/
+    void	*arg);		/* user argument passed to consumer.	*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
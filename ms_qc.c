@@ -0,0 +1,530 @@
+/************************************************************************/
+/*  Routines for quality control of MiniSEED records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "qsteim.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "ms_unpack.h"
+#include "ms_qc.h"
+
+#define	VALS_PER_FRAME	(16-1)		/* # of ints for data per frame.*/
+#define	MAX_FRAME_DIFFS	(7*VALS_PER_FRAME) /* max # of diffs in a frame.*/
+#define	STATS_CHUNK	256		/* # of samples per stats chunk.*/
+
+/************************************************************************/
+/*  steim_frame_diffs:							*/
+/*	Extract the differences of one Steim1 or Steim2 frame, using	*/
+/*	the control word as unpack_steim1/2 do.  The integration	*/
+/*	constants X0 and XN of the first frame are skipped, since their	*/
+/*	control code is 0.						*/
+/*  return:	# of differences in frame, or MS_ERROR for an invalid	*/
+/*		control code.						*/
+/************************************************************************/
+static int steim_frame_diffs
+   (FRAME	*pf,		/* ptr to frame.			*/
+    int		steim2,		/* 1 for Steim2, 0 for Steim1.		*/
+    int		swapflag,	/* 1 if data must be byte swapped.	*/
+    int		*diff,		/* differences (returned).		*/
+    int		*nwide)		/* # of full word diffs (updated).	*/
+{
+    unsigned int ctrl;
+    int		wn, c, dnib, bits, n, m1, m2, i, d;
+    int		nd = 0;
+    int		val;
+    short	hw;
+
+    ctrl = pf->ctrl;
+    if (swapflag) swab4 ((int *)&ctrl);
+    for (wn = 0; wn < VALS_PER_FRAME; wn++) {
+	c = (ctrl >> ((VALS_PER_FRAME-wn-1)*2)) & 0x3;
+	if (c == STEIM1_SPECIAL_MASK) continue;
+	if (c == STEIM1_BYTE_MASK) {
+	    /* 4 1-byte differences in both Steim1 and Steim2.		*/
+	    /* An all-zero word is the common flatline case.		*/
+	    if (pf->w[wn].fw == 0) {
+		diff[nd] = diff[nd+1] = diff[nd+2] = diff[nd+3] = 0;
+		nd += 4;
+		continue;
+	    }
+	    for (i=0; i<4; i++) diff[nd++] = pf->w[wn].byte[i];
+	    continue;
+	}
+	if (! steim2) {
+	    if (c == STEIM1_HALFWORD_MASK) {
+		for (i=0; i<2; i++) {
+		    hw = pf->w[wn].hw[i];
+		    if (swapflag) swab2 (&hw);
+		    diff[nd++] = hw;
+		}
+	    }
+	    else {
+		val = pf->w[wn].fw;
+		if (swapflag) swab4 (&val);
+		(*nwide)++;
+		diff[nd++] = val;
+	    }
+	    continue;
+	}
+	val = pf->w[wn].fw;
+	if (swapflag) swab4 (&val);
+	dnib = val >> 30 & 0x3;
+	if (c == STEIM2_123_MASK) {
+	    switch (dnib) {
+	      case 1: bits = 30; n = 1; break;
+	      case 2: bits = 15; n = 2; break;
+	      case 3: bits = 10; n = 3; break;
+	      default: return (MS_ERROR);
+	    }
+	}
+	else {
+	    switch (dnib) {
+	      case 0: bits = 6; n = 5; break;
+	      case 1: bits = 5; n = 6; break;
+	      case 2: bits = 4; n = 7; break;
+	      default: return (MS_ERROR);
+	    }
+	}
+	if (bits == 30) (*nwide)++;
+	m1 = (1 << bits) - 1;
+	m2 = 1 << (bits - 1);
+	for (i=(n-1)*bits; i>=0; i-=bits) {
+	    d = (val >> i) & m1;
+	    diff[nd++] = (d & m2) ? d | ~m1 : d;
+	}
+    }
+    return (nd);
+}
+
+/************************************************************************/
+/*  qc_diff:								*/
+/*	Add one difference to the QC summary, and track runs of zero	*/
+/*	differences.							*/
+/************************************************************************/
+static void qc_diff
+   (MS_STEIM_QC	*qc,		/* QC summary (updated).		*/
+    int		d,		/* difference.				*/
+    int		*run,		/* length of current zero run (updated).*/
+    int		min_run)	/* min # of zero diffs in a flat run.	*/
+{
+    unsigned int a;
+    int		bits = 0;
+
+    if (d == 0) {
+	qc->nzero++;
+	if (++(*run) == min_run) qc->nflat_runs++;
+	if (*run > qc->longest_run) {
+	    qc->longest_run = *run;
+	    qc->longest_start = qc->ndiffs - *run + 1;
+	}
+	qc->nbits[0]++;
+    }
+    else {
+	*run = 0;
+	a = (d < 0) ? -(unsigned int)d : (unsigned int)d;
+	if (a > (unsigned int)qc->maxabs) qc->maxabs = (a > 0x7fffffff) ?
+	    0x7fffffff : (int)a;
+	while (a) {
+	    bits++;
+	    a >>= 1;
+	}
+	qc->nbits[bits]++;
+    }
+    qc->ndiffs++;
+}
+
+/************************************************************************/
+/*  ms_steim_qc:							*/
+/*	Summarize the differences of a Steim1 or Steim2 record from	*/
+/*	its control words and difference fields, without integrating	*/
+/*	or storing the samples.  The summary reports zero differences,	*/
+/*	runs of at least min_run zero differences (flatlines), whether	*/
+/*	the record is constant, the number of differences that need a	*/
+/*	full word (a spike or clipping indicator), and a histogram of	*/
+/*	difference magnitudes.  Only the first hdr->num_samples		*/
+/*	differences are examined.					*/
+/*  return:	# of differences examined on success, error code on	*/
+/*		error or if the record is not Steim compressed.		*/
+/************************************************************************/
+int ms_steim_qc
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    int		min_run,	/* min # of zero diffs in a flat run.	*/
+    MS_STEIM_QC	*qc)		/* QC summary (returned).		*/
+{
+    FRAME	*pf;
+    int		diff[MAX_FRAME_DIFFS];
+    int		num_samples = hdr->num_samples;
+    int		num_data_frames;
+    int		swapflag;
+    int		fn, n, i;
+    int		x0, xn, run = 0;
+
+    memset ((char *)qc, 0, sizeof(MS_STEIM_QC));
+    if (! IS_STEIM_COMP(hdr->data_type) || hdr->blksize <= hdr->first_data ||
+	num_samples < 0) return (MS_ERROR);
+    if (min_run < 1) min_run = 1;
+    if (my_wordorder < 0) get_my_wordorder();
+    swapflag = (my_wordorder != hdr->data_wordorder);
+    num_data_frames = (hdr->blksize - hdr->first_data) / sizeof(FRAME);
+    pf = (FRAME *)(ms + hdr->first_data);
+    if (num_samples == 0) return (0);
+    if (num_data_frames <= 0) return (MS_ERROR);
+    x0 = pf->w[0].fw;
+    xn = pf->w[1].fw;
+    if (swapflag) {
+	swab4 (&x0);
+	swab4 (&xn);
+    }
+
+    for (fn = 0; fn < num_data_frames && qc->ndiffs < num_samples; fn++) {
+	n = steim_frame_diffs (pf++, hdr->data_type == STEIM2, swapflag,
+			       diff, &qc->nwide);
+	if (n < 0) return (MS_ERROR);
+	for (i=0; i<n && qc->ndiffs<num_samples; i++)
+	    qc_diff (qc, diff[i], &run, min_run);
+    }
+    qc->nframes = fn;
+
+    /* The record is constant if every difference after the first is	*/
+    /* zero.  The first difference depends on the previous record.	*/
+    qc->constant = (x0 == xn && qc->ndiffs == num_samples &&
+		    (num_samples == 1 || qc->longest_run >= num_samples - 1));
+    return (qc->ndiffs);
+}
+
+/************************************************************************/
+/*  stats_add_int:							*/
+/*	Add integer samples to running statistics.  Independent	*/
+/*	partial results are kept for interleaved samples so that the	*/
+/*	loop can be vectorized or pipelined.				*/
+/************************************************************************/
+static void stats_add_int
+   (MS_STATS	*st,		/* running statistics (updated).	*/
+    int		*x,		/* samples.				*/
+    int		n)		/* # of samples.			*/
+{
+    int		mn[4], mx[4];
+    int64_t	s[4];
+    double	q[4];
+    int		i, j;
+
+    if (n <= 0) return;
+    for (j=0; j<4; j++) {
+	mn[j] = mx[j] = x[0];
+	s[j] = 0;
+	q[j] = 0.;
+    }
+    for (i=0; i+4<=n; i+=4) {
+	for (j=0; j<4; j++) {
+	    mn[j] = (x[i+j] < mn[j]) ? x[i+j] : mn[j];
+	    mx[j] = (x[i+j] > mx[j]) ? x[i+j] : mx[j];
+	    s[j] += x[i+j];
+	    q[j] += (double)x[i+j] * x[i+j];
+	}
+    }
+    for (; i<n; i++) {
+	mn[0] = (x[i] < mn[0]) ? x[i] : mn[0];
+	mx[0] = (x[i] > mx[0]) ? x[i] : mx[0];
+	s[0] += x[i];
+	q[0] += (double)x[i] * x[i];
+    }
+    for (j=1; j<4; j++) {
+	if (mn[j] < mn[0]) mn[0] = mn[j];
+	if (mx[j] > mx[0]) mx[0] = mx[j];
+    }
+    if (st->nsamples == 0 || mn[0] < st->min) st->min = mn[0];
+    if (st->nsamples == 0 || mx[0] > st->max) st->max = mx[0];
+    st->sum += (double)(s[0] + s[1] + s[2] + s[3]);
+    st->sumsq += (q[0] + q[1]) + (q[2] + q[3]);
+    st->nsamples += n;
+}
+
+/************************************************************************/
+/*  stats_add_double:							*/
+/*	Add floating point samples to running statistics.		*/
+/************************************************************************/
+static void stats_add_double
+   (MS_STATS	*st,		/* running statistics (updated).	*/
+    double	*x,		/* samples.				*/
+    int		n)		/* # of samples.			*/
+{
+    double	mn[4], mx[4], s[4], q[4];
+    int		i, j;
+
+    if (n <= 0) return;
+    for (j=0; j<4; j++) {
+	mn[j] = mx[j] = x[0];
+	s[j] = q[j] = 0.;
+    }
+    for (i=0; i+4<=n; i+=4) {
+	for (j=0; j<4; j++) {
+	    mn[j] = (x[i+j] < mn[j]) ? x[i+j] : mn[j];
+	    mx[j] = (x[i+j] > mx[j]) ? x[i+j] : mx[j];
+	    s[j] += x[i+j];
+	    q[j] += x[i+j] * x[i+j];
+	}
+    }
+    for (; i<n; i++) {
+	mn[0] = (x[i] < mn[0]) ? x[i] : mn[0];
+	mx[0] = (x[i] > mx[0]) ? x[i] : mx[0];
+	s[0] += x[i];
+	q[0] += x[i] * x[i];
+    }
+    for (j=1; j<4; j++) {
+	if (mn[j] < mn[0]) mn[0] = mn[j];
+	if (mx[j] > mx[0]) mx[0] = mx[j];
+    }
+    if (st->nsamples == 0 || mn[0] < st->min) st->min = mn[0];
+    if (st->nsamples == 0 || mx[0] > st->max) st->max = mx[0];
+    st->sum += (s[0] + s[1]) + (s[2] + s[3]);
+    st->sumsq += (q[0] + q[1]) + (q[2] + q[3]);
+    st->nsamples += n;
+}
+
+/************************************************************************/
+/*  stats_add_float:							*/
+/*	Add single precision samples to running statistics.		*/
+/************************************************************************/
+static void stats_add_float
+   (MS_STATS	*st,		/* running statistics (updated).	*/
+    float	*x,		/* samples.				*/
+    int		n)		/* # of samples.			*/
+{
+    double	buf[STATS_CHUNK];
+    int		i, j, k;
+
+    for (i=0; i<n; i+=k) {
+	k = (n - i < STATS_CHUNK) ? n - i : STATS_CHUNK;
+	for (j=0; j<k; j++) buf[j] = x[i+j];
+	stats_add_double (st, buf, k);
+    }
+}
+
+/************************************************************************/
+/*  stats_finish:							*/
+/*	Compute the mean and RMS from the running statistics.		*/
+/************************************************************************/
+static void stats_finish
+   (MS_STATS	*st)		/* statistics (updated).		*/
+{
+    if (st->nsamples <= 0) return;
+    st->mean = st->sum / st->nsamples;
+    st->rms = sqrt (st->sumsq / st->nsamples);
+}
+
+/************************************************************************/
+/*  ms_unpack_stats:							*/
+/*	Unpack Mini-SEED data into the supplied buffer as ms_unpack	*/
+/*	does, and compute the min, max, mean and RMS of the samples	*/
+/*	returned while they are still in the cache.  If st is NULL,	*/
+/*	this is identical to ms_unpack.					*/
+/*  return:	# of samples on success, error code on error.		*/
+/************************************************************************/
+int ms_unpack_stats
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    int		max_num_points,	/* max # of points to return.		*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    void	*data_buffer,	/* ptr to output data buffer.		*/
+    MS_STATS	*st)		/* statistics of samples (returned).	*/
+{
+    int		n;
+
+    if (st) memset ((char *)st, 0, sizeof(MS_STATS));
+    n = ms_unpack (hdr, max_num_points, ms, data_buffer);
+    if (st == NULL || n <= 0) return (n);
+    switch (hdr->data_type) {
+      case IEEE_FP_SP:
+	stats_add_float (st, (float *)data_buffer, n);
+	break;
+      case IEEE_FP_DP:
+	stats_add_double (st, (double *)data_buffer, n);
+	break;
+      default:
+	stats_add_int (st, (int *)data_buffer, n);
+	break;
+    }
+    stats_finish (st);
+    return (n);
+}
+
+/************************************************************************/
+/*  ms_record_stats:							*/
+/*	Compute the min, max, mean and RMS of the samples of a		*/
+/*	Mini-SEED record without an output buffer.  Steim data is	*/
+/*	integrated one frame at a time and verified against XN, and	*/
+/*	other formats are read directly from the record.		*/
+/*  return:	# of samples on success, error code on error.		*/
+/************************************************************************/
+int ms_record_stats
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    MS_STATS	*st)		/* statistics of samples (returned).	*/
+{
+    FRAME	*pf;
+    char	*p;
+    int		ibuf[STATS_CHUNK];
+    int		diff[MAX_FRAME_DIFFS];
+    double	dbuf[STATS_CHUNK];
+    int		num_samples = hdr->num_samples;
+    int		datasize = hdr->blksize - hdr->first_data;
+    int		swapflag, nwide = 0;
+    int		nd = 0, fn, n, i, k;
+    int		x = 0, x0, xn;
+    short	hw;
+    float	f;
+    unsigned char *b;
+    unsigned int u;
+
+    memset ((char *)st, 0, sizeof(MS_STATS));
+    if (num_samples < 0 || datasize < 0) return (MS_ERROR);
+    if (num_samples == 0) return (0);
+    if (my_wordorder < 0) get_my_wordorder();
+    swapflag = (my_wordorder != hdr->data_wordorder);
+    p = ms + hdr->first_data;
+
+    switch (hdr->data_type) {
+      case STEIM1:
+      case STEIM2:
+	pf = (FRAME *)p;
+	if (datasize < (int)sizeof(FRAME)) return (MS_ERROR);
+	x0 = pf->w[0].fw;
+	xn = pf->w[1].fw;
+	if (swapflag) {
+	    swab4 (&x0);
+	    swab4 (&xn);
+	}
+	for (fn = 0; fn < datasize / (int)sizeof(FRAME) && nd < num_samples;
+	     fn++) {
+	    n = steim_frame_diffs (pf++, hdr->data_type == STEIM2, swapflag,
+				   diff, &nwide);
+	    if (n < 0) return (MS_ERROR);
+	    if (n > num_samples - nd) n = num_samples - nd;
+	    /* Integrate in place, as unpack_steim1/2 do.  The first	*/
+	    /* sample is X0, and its difference is not used.		*/
+	    i = 0;
+	    if (nd == 0 && n > 0) {
+		x = diff[i++] = x0;
+	    }
+	    for (; i<n; i++) x = diff[i] = (int)((unsigned int)x + diff[i]);
+	    stats_add_int (st, diff, n);
+	    nd += n;
+	}
+	if (nd < num_samples || x != xn) {
+	    fprintf (stderr,
+		     "Error: data integrity for %s.%s.%s in ms_record_stats\n",
+		     hdr->station_id, hdr->network_id, hdr->channel_id);
+	    fflush (stderr);
+	    memset ((char *)st, 0, sizeof(MS_STATS));
+	    return (MS_ERROR);
+	}
+	break;
+      case INT_16:
+	if (num_samples > datasize / 2) return (MS_ERROR);
+	for (i=0; i<num_samples; i+=k) {
+	    k = (num_samples - i < STATS_CHUNK) ? num_samples - i : STATS_CHUNK;
+	    for (n=0; n<k; n++) {
+		memcpy ((char *)&hw, p + 2*(i+n), 2);
+		if (swapflag) swab2 (&hw);
+		ibuf[n] = hw;
+	    }
+	    stats_add_int (st, ibuf, k);
+	}
+	break;
+      case INT_24:
+	if (num_samples > datasize / 3) return (MS_ERROR);
+	for (i=0; i<num_samples; i+=k) {
+	    k = (num_samples - i < STATS_CHUNK) ? num_samples - i : STATS_CHUNK;
+	    for (n=0; n<k; n++) {
+		b = (unsigned char *)p + 3*(i+n);
+		if (hdr->data_wordorder == SEED_BIG_ENDIAN)
+		    u = (b[0] << 16) | (b[1] << 8) | b[2];
+		else
+		    u = (b[2] << 16) | (b[1] << 8) | b[0];
+		/* Shift to the top and back to extend the sign.	*/
+		ibuf[n] = (int)(u << 8) >> 8;
+	    }
+	    stats_add_int (st, ibuf, k);
+	}
+	break;
+      case INT_32:
+	if (num_samples > datasize / 4) return (MS_ERROR);
+	for (i=0; i<num_samples; i+=k) {
+	    k = (num_samples - i < STATS_CHUNK) ? num_samples - i : STATS_CHUNK;
+	    memcpy ((char *)ibuf, p + 4*i, 4*k);
+	    if (swapflag) for (n=0; n<k; n++) swab4 (&ibuf[n]);
+	    stats_add_int (st, ibuf, k);
+	}
+	break;
+      case IEEE_FP_SP:
+	if (num_samples > datasize / 4) return (MS_ERROR);
+	for (i=0; i<num_samples; i+=k) {
+	    k = (num_samples - i < STATS_CHUNK) ? num_samples - i : STATS_CHUNK;
+	    for (n=0; n<k; n++) {
+		memcpy ((char *)&f, p + 4*(i+n), 4);
+		if (swapflag) swab4 ((int *)&f);
+		dbuf[n] = f;
+	    }
+	    stats_add_double (st, dbuf, k);
+	}
+	break;
+      case IEEE_FP_DP:
+	if (num_samples > datasize / 8) return (MS_ERROR);
+	for (i=0; i<num_samples; i+=k) {
+	    k = (num_samples - i < STATS_CHUNK) ? num_samples - i : STATS_CHUNK;
+	    memcpy ((char *)dbuf, p + 8*i, 8*k);
+	    if (swapflag) for (n=0; n<k; n++) swab8 (&dbuf[n]);
+	    stats_add_double (st, dbuf, k);
+	}
+	break;
+      default:
+	return (MS_ERROR);
+    }
+    stats_finish (st);
+    return (st->nsamples);
+}
@@ -0,0 +1,105 @@
+/************************************************************************/
+/*  Routines for quality control of MiniSEED records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#ifndef	__ms_qc_h
+#define	__ms_qc_h
+
+#include "data_hdr.h"
+
+/*	Quality control summary of the differences in a Steim record.	*/
+/*	The first difference is relative to the last sample of the	*/
+/*	previous record.						*/
+
+typedef struct _ms_steim_qc {
+    int		nframes;	/* # of frames examined.		*/
+    int		ndiffs;		/* # of differences examined.		*/
+    int		nzero;		/* # of zero differences.		*/
+    int		nflat_runs;	/* # of runs of at least min_run zero	*/
+				/* differences.				*/
+    int		longest_run;	/* # of diffs in longest zero run.	*/
+    int		longest_start;	/* index of first diff of longest run.	*/
+    int		constant;	/* 1 if all samples of the record are	*/
+				/* equal, 0 otherwise.			*/
+    int		nwide;		/* # of differences that need a full	*/
+				/* word: 32 bits in Steim1, 30 bits	*/
+				/* in Steim2.				*/
+    int		maxabs;		/* largest absolute difference.		*/
+    int		nbits[33];	/* # of differences by # of significant	*/
+				/* bits of their absolute value.	*/
+} MS_STEIM_QC;
+
+/*	Summary statistics of the samples of a record.			*/
+
+typedef struct _ms_stats {
+    int		nsamples;	/* # of samples.			*/
+    double	min;		/* minimum sample value.		*/
+    double	max;		/* maximum sample value.		*/
+    double	mean;		/* mean of samples.			*/
+    double	rms;		/* root mean square of samples.		*/
+    double	sum;		/* sum of samples.			*/
+    double	sumsq;		/* sum of squares of samples.		*/
+} MS_STATS;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_steim_qc
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    int		min_run,	/* min # of zero diffs in a flat run.	*/
+    MS_STEIM_QC	*qc);		/* QC summary (returned).		*/
+
+extern int ms_unpack_stats
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    int		max_num_points,	/* max # of points to return.		*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    void	*data_buffer,	/* ptr to output data buffer.		*/
+    MS_STATS	*st);		/* statistics of samples (returned).	*/
+
+extern int ms_record_stats
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    MS_STATS	*st);		/* statistics of samples (returned).	*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
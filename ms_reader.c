@@ -0,0 +1,553 @@
+/************************************************************************/
+/*  Record readers for plain and compressed MiniSEED files.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * An MS_READER returns the MiniSEED records of a file one at a time,
+ * using one of several backends:
+ *	stdio:	the file is read in large blocks with fread.
+ *	mmap:	the file is memory mapped, and records are returned in place.
+ *	gzip:	the file is decompressed with zlib (requires HAVE_ZLIB).
+ *	zstd:	the file is decompressed with zstd (requires HAVE_ZSTD).
+ * For the stdio, gzip and zstd backends, the data can optionally be
+ * read ahead into a ring of large chunks by a helper thread, so that
+ * decompression overlaps with the processing of records.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef	HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef	HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_utils.h"
+#include "ms_scan.h"
+#include "ms_reader.h"
+
+#define	READER_BUFLEN	(1<<20)	/* size of record buffer.		*/
+#define	READER_ZBUFLEN	(1<<18)	/* size of compressed input buffer.	*/
+#define	RA_NCHUNKS	4	/* # of read-ahead chunks.		*/
+#define	RA_CHUNKLEN	(1<<20)	/* size of read-ahead chunk.		*/
+
+/*	A chunk of data read ahead.					*/
+typedef struct _ra_chunk {
+    char	*data;		/* chunk data.				*/
+    int		len;		/* # of bytes, 0 on eof, -1 on error.	*/
+    int		pos;		/* # of bytes consumed.			*/
+} RA_CHUNK;
+
+/*	Read-ahead state.  The helper thread fills chunks at tail, and	*/
+/*	the reader consumes them at head.				*/
+typedef struct _read_ahead {
+    pthread_t	tid;		/* helper thread.			*/
+    pthread_mutex_t lock;	/* lock for ring state.			*/
+    pthread_cond_t cond;	/* signalled when ring state changes.	*/
+    RA_CHUNK	chunk[RA_NCHUNKS];
+    int		head;		/* next chunk to consume.		*/
+    int		tail;		/* next chunk to fill.			*/
+    int		nfull;		/* # of filled chunks.			*/
+    int		stop;		/* set to stop the helper thread.	*/
+} READ_AHEAD;
+
+#ifdef	HAVE_ZSTD
+/*	zstd decompression state.					*/
+typedef struct _zstd_state {
+    ZSTD_DStream *ds;		/* decompression stream.		*/
+    char	*in;		/* compressed input buffer.		*/
+    size_t	inlen;		/* size of input buffer.		*/
+    ZSTD_inBuffer ib;		/* current input.			*/
+    int		ineof;		/* set at end of compressed input.	*/
+    size_t	last;		/* last status from decompressStream.	*/
+} ZSTD_STATE;
+#endif
+
+/************************************************************************/
+/*  reader_read:							*/
+/*	Read the next bytes of data from the backend of a reader.	*/
+/*  return:	# of bytes read, 0 on eof, -1 on error.			*/
+/************************************************************************/
+static int reader_read
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    char	*dst,		/* buffer for data.			*/
+    int		n)		/* max # of bytes to read.		*/
+{
+    int		nread;
+
+    switch (r->type) {
+      case MS_READER_STDIO:
+	nread = fread (dst, 1, n, r->fp);
+	return ((nread == 0 && ferror (r->fp)) ? -1 : nread);
+#ifdef	HAVE_ZLIB
+      case MS_READER_GZIP:
+	return (gzread ((gzFile)r->zs, dst, (unsigned)n));
+#endif
+#ifdef	HAVE_ZSTD
+      case MS_READER_ZSTD: {
+	ZSTD_STATE *z = (ZSTD_STATE *)r->zs;
+	ZSTD_outBuffer ob;
+	size_t before, inpos, ret;
+	ssize_t k;
+
+	ob.dst = dst;
+	ob.size = n;
+	ob.pos = 0;
+	while (ob.pos < ob.size) {
+	    if (z->ib.pos == z->ib.size && ! z->ineof) {
+		if ((k = read (r->fd, z->in, z->inlen)) < 0) return (-1);
+		if (k == 0) z->ineof = 1;
+		z->ib.src = z->in;
+		z->ib.size = k;
+		z->ib.pos = 0;
+	    }
+	    before = ob.pos;
+	    inpos = z->ib.pos;
+	    ret = ZSTD_decompressStream (z->ds, &ob, &z->ib);
+	    if (ZSTD_isError (ret)) {
+		fprintf (stderr, "Error: %s in ms_reader\n", ZSTD_getErrorName (ret));
+		fflush (stderr);
+		return (-1);
+	    }
+	    /* Only remember the status of calls that made progress, so	*/
+	    /* that a call at the end of a complete frame is not	*/
+	    /* mistaken for a truncated frame.				*/
+	    if (z->ib.pos != inpos || ob.pos != before) z->last = ret;
+	    else if (z->ineof) break;
+	}
+	/* A frame that is not complete at eof is an error.		*/
+	if (ob.pos == 0 && z->ineof && z->last != 0) return (-1);
+	return ((int)ob.pos);
+      }
+#endif
+      default:
+	return (-1);
+    }
+}
+
+/************************************************************************/
+/*  ra_thread:								*/
+/*	Helper thread that reads ahead into the chunks of the ring.	*/
+/************************************************************************/
+static void *ra_thread
+   (void	*arg)		/* ptr to MS_READER.			*/
+{
+    MS_READER	*r = (MS_READER *)arg;
+    READ_AHEAD	*ra = (READ_AHEAD *)r->ra;
+    RA_CHUNK	*c;
+    int		n;
+
+    pthread_mutex_lock (&ra->lock);
+    for (;;) {
+	while (ra->nfull == RA_NCHUNKS && ! ra->stop) 
+	    pthread_cond_wait (&ra->cond, &ra->lock);
+	if (ra->stop) break;
+	c = &ra->chunk[ra->tail];
+	pthread_mutex_unlock (&ra->lock);
+	n = reader_read (r, c->data, RA_CHUNKLEN);
+	pthread_mutex_lock (&ra->lock);
+	c->len = n;
+	c->pos = 0;
+	ra->tail = (ra->tail + 1) % RA_NCHUNKS;
+	ra->nfull++;
+	pthread_cond_broadcast (&ra->cond);
+	if (n <= 0) break;
+    }
+    pthread_mutex_unlock (&ra->lock);
+    return (NULL);
+}
+
+/************************************************************************/
+/*  ra_read:								*/
+/*	Copy the next bytes of data read ahead by the helper thread.	*/
+/*  return:	# of bytes read, 0 on eof, -1 on error.			*/
+/************************************************************************/
+static int ra_read
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    char	*dst,		/* buffer for data.			*/
+    int		n)		/* max # of bytes to read.		*/
+{
+    READ_AHEAD	*ra = (READ_AHEAD *)r->ra;
+    RA_CHUNK	*c;
+    int		m;
+
+    pthread_mutex_lock (&ra->lock);
+    while (ra->nfull == 0) pthread_cond_wait (&ra->cond, &ra->lock);
+    c = &ra->chunk[ra->head];
+    pthread_mutex_unlock (&ra->lock);
+    /* The last chunk, with eof or error, is never consumed.		*/
+    if (c->len <= 0) return (c->len);
+    m = c->len - c->pos;
+    if (m > n) m = n;
+    memcpy (dst, c->data + c->pos, m);
+    c->pos += m;
+    if (c->pos == c->len) {
+	pthread_mutex_lock (&ra->lock);
+	ra->head = (ra->head + 1) % RA_NCHUNKS;
+	ra->nfull--;
+	pthread_cond_broadcast (&ra->cond);
+	pthread_mutex_unlock (&ra->lock);
+    }
+    return (m);
+}
+
+/************************************************************************/
+/*  ra_start:								*/
+/*	Start reading ahead on a helper thread.				*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int ra_start
+   (MS_READER	*r)		/* ptr to MS_READER.			*/
+{
+    READ_AHEAD	*ra;
+    int		i;
+
+    if ((ra = (READ_AHEAD *)calloc (1, sizeof(READ_AHEAD))) == NULL) 
+	return (QLIB2_MALLOC_ERROR);
+    for (i=0; i<RA_NCHUNKS; i++) {
+	if ((ra->chunk[i].data = (char *)malloc (RA_CHUNKLEN)) == NULL) {
+	    while (--i >= 0) free (ra->chunk[i].data);
+	    free ((char *)ra);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+    }
+    pthread_mutex_init (&ra->lock, NULL);
+    pthread_cond_init (&ra->cond, NULL);
+    r->ra = ra;
+    if (pthread_create (&ra->tid, NULL, ra_thread, r) != 0) {
+	/* Read synchronously instead.					*/
+	r->ra = NULL;
+	pthread_mutex_destroy (&ra->lock);
+	pthread_cond_destroy (&ra->cond);
+	for (i=0; i<RA_NCHUNKS; i++) free (ra->chunk[i].data);
+	free ((char *)ra);
+    }
+    return (0);
+}
+
+/************************************************************************/
+/*  ra_stop:								*/
+/*	Stop the read-ahead helper thread and free its storage.		*/
+/************************************************************************/
+static void ra_stop
+   (MS_READER	*r)		/* ptr to MS_READER.			*/
+{
+    READ_AHEAD	*ra = (READ_AHEAD *)r->ra;
+    int		i;
+
+    pthread_mutex_lock (&ra->lock);
+    ra->stop = 1;
+    pthread_cond_broadcast (&ra->cond);
+    pthread_mutex_unlock (&ra->lock);
+    pthread_join (ra->tid, NULL);
+    pthread_mutex_destroy (&ra->lock);
+    pthread_cond_destroy (&ra->cond);
+    for (i=0; i<RA_NCHUNKS; i++) free (ra->chunk[i].data);
+    free ((char *)ra);
+    r->ra = NULL;
+}
+
+/************************************************************************/
+/*  ms_reader_open:							*/
+/*	Open a MiniSEED file for reading with the specified backend.	*/
+/*	For MS_READER_AUTO, gzip and zstd compressed files are detected	*/
+/*	from their magic numbers, and other files are memory mapped if	*/
+/*	possible.  The mmap backend falls back to stdio for files that	*/
+/*	cannot be mapped.  If MS_READER_READAHEAD is or'ed into type,	*/
+/*	the stdio, gzip and zstd backends read ahead on a helper	*/
+/*	thread.								*/
+/*  return:								*/
+/*	ptr to MS_READER on success.					*/
+/*	NULL on error.							*/
+/************************************************************************/
+MS_READER *ms_reader_open
+   (char	*filename,	/* name of MiniSEED file.		*/
+    int		type)		/* backend type, with optional flags.	*/
+{
+    MS_READER	*r;
+    struct stat	sb;
+    unsigned char magic[4];
+    int		fd, flags;
+
+    flags = type & MS_READER_READAHEAD;
+    type &= ~MS_READER_READAHEAD;
+    if ((fd = open (filename, O_RDONLY)) < 0) {
+	fprintf (stderr, "Error: unable to open %s in ms_reader_open\n", filename);
+	fflush (stderr);
+	return (NULL);
+    }
+    if (type == MS_READER_AUTO) {
+	memset ((char *)magic, 0, sizeof(magic));
+	if (pread (fd, (char *)magic, sizeof(magic), 0) < 0) magic[0] = 0;
+	if (magic[0] == 0x1f && magic[1] == 0x8b) type = MS_READER_GZIP;
+	else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && 
+		 magic[3] == 0xfd) type = MS_READER_ZSTD;
+	else type = MS_READER_MMAP;
+    }
+    if ((r = (MS_READER *)calloc (1, sizeof(MS_READER))) == NULL) {
+	close (fd);
+	fprintf (stderr, "Error: unable to malloc MS_READER in ms_reader_open\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (NULL);
+    }
+    r->fd = fd;
+    r->type = type;
+    r->flags = flags;
+
+    switch (type) {
+      case MS_READER_MMAP:
+	if (fstat (fd, &sb) == 0 && S_ISREG (sb.st_mode)) {
+	    r->maplen = (int64_t)sb.st_size;
+	    if (r->maplen == 0) return (r);
+	    r->map = (char *)mmap (NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	    if (r->map != (char *)MAP_FAILED) {
+		madvise (r->map, (size_t)sb.st_size, MADV_SEQUENTIAL);
+		return (r);
+	    }
+	}
+	r->map = NULL;
+	r->maplen = 0;
+	r->type = MS_READER_STDIO;
+	/* FALLTHROUGH */
+      case MS_READER_STDIO:
+	if ((r->fp = fdopen (fd, "r")) == NULL) {
+	    ms_reader_close (r);
+	    return (NULL);
+	}
+	break;
+      case MS_READER_GZIP:
+#ifdef	HAVE_ZLIB
+	if ((r->zs = (void *)gzdopen (fd, "rb")) == NULL) {
+	    fprintf (stderr, "Error: unable to open gzip file %s in ms_reader_open\n", 
+		     filename);
+	    fflush (stderr);
+	    ms_reader_close (r);
+	    return (NULL);
+	}
+	gzbuffer ((gzFile)r->zs, READER_ZBUFLEN);
+	break;
+#else
+	fprintf (stderr, "Error: gzip files not supported (HAVE_ZLIB) in ms_reader_open\n");
+	fflush (stderr);
+	ms_reader_close (r);
+	return (NULL);
+#endif
+      case MS_READER_ZSTD:
+#ifdef	HAVE_ZSTD
+	{
+	    ZSTD_STATE *z;
+	    if ((z = (ZSTD_STATE *)calloc (1, sizeof(ZSTD_STATE))) == NULL) {
+		ms_reader_close (r);
+		return (NULL);
+	    }
+	    r->zs = z;
+	    z->inlen = ZSTD_DStreamInSize();
+	    if (z->inlen < READER_ZBUFLEN) z->inlen = READER_ZBUFLEN;
+	    if ((z->in = (char *)malloc (z->inlen)) == NULL ||
+		(z->ds = ZSTD_createDStream()) == NULL ||
+		ZSTD_isError (ZSTD_initDStream (z->ds))) {
+		ms_reader_close (r);
+		return (NULL);
+	    }
+	}
+	break;
+#else
+	fprintf (stderr, "Error: zstd files not supported (HAVE_ZSTD) in ms_reader_open\n");
+	fflush (stderr);
+	ms_reader_close (r);
+	return (NULL);
+#endif
+      default:
+	fprintf (stderr, "Error: invalid reader type %d in ms_reader_open\n", type);
+	fflush (stderr);
+	ms_reader_close (r);
+	return (NULL);
+    }
+
+    if ((r->buf = (char *)malloc (READER_BUFLEN)) == NULL ||
+	((flags & MS_READER_READAHEAD) && ra_start (r) < 0)) {
+	ms_reader_close (r);
+	fprintf (stderr, "Error: unable to malloc buffer in ms_reader_open\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (NULL);
+    }
+    r->buflen = READER_BUFLEN;
+    return (r);
+}
+
+/************************************************************************/
+/*  ms_reader_next:							*/
+/*	Return the next MiniSEED record of a file, including volume	*/
+/*	headers.  For the mmap backend, the record is returned in	*/
+/*	place.  Otherwise, it is returned in the reader's buffer, and	*/
+/*	is valid until the next call.  The offset of the record in the	*/
+/*	(uncompressed) data is returned in r->rec_offset.		*/
+/*  return:								*/
+/*	blksize of record on success.					*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on error, or on a truncated record at eof.		*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int ms_reader_next
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    char	**prec)		/* ptr to record (returned).		*/
+{
+    int64_t	remain;
+    int		avail, n, nread;
+    char	*p;
+
+    *prec = NULL;
+    if (r->map || r->type == MS_READER_MMAP) {
+	if ((remain = r->maplen - r->offset) <= 0) return (EOF);
+	n = ms_record_length (r->map + r->offset, (remain > READER_BUFLEN) ? 
+			      READER_BUFLEN : (int)remain);
+	if (n <= 0 || n > remain) return (MS_ERROR);
+	*prec = r->map + r->offset;
+	r->rec_offset = r->offset;
+	r->offset += n;
+	return (n);
+    }
+
+    for (;;) {
+	avail = r->len - r->pos;
+	if ((n = ms_record_length (r->buf + r->pos, avail)) < 0) return (n);
+	if (n > 0 && avail >= n) {
+	    *prec = r->buf + r->pos;
+	    r->pos += n;
+	    r->rec_offset = r->offset;
+	    r->offset += n;
+	    return (n);
+	}
+	if (r->eof) return ((avail == 0) ? EOF : MS_ERROR);
+
+	/* Move the partial record to the start of the buffer, and	*/
+	/* read more data after it.					*/
+	if (r->pos > 0) {
+	    memmove (r->buf, r->buf + r->pos, avail);
+	    r->len = avail;
+	    r->pos = 0;
+	}
+	if (n > r->buflen) {
+	    if ((p = (char *)realloc (r->buf, n)) == NULL) {
+		fprintf (stderr, "Error: unable to malloc buffer in ms_reader_next\n");
+		fflush (stderr);
+		if (QLIB2_CLASSIC) exit(1);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	    r->buf = p;
+	    r->buflen = n;
+	}
+	nread = (r->ra) ? ra_read (r, r->buf + r->len, r->buflen - r->len) :
+			  reader_read (r, r->buf + r->len, r->buflen - r->len);
+	if (nread < 0) return (MS_ERROR);
+	if (nread == 0) r->eof = 1;
+	r->len += nread;
+    }
+}
+
+/************************************************************************/
+/*  ms_reader_read_ms:							*/
+/*	Read the next MiniSEED data record from a reader, unpack the	*/
+/*	data, and return to the user a data_hdr and the unpacked data,	*/
+/*	as read_ms does.  Volume headers are skipped.			*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int ms_reader_read_ms
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points)	/* max # data points to return.		*/
+{
+    char	*rec;
+    int		n;
+
+    *phdr = NULL;
+    do {
+	if ((n = ms_reader_next (r, &rec)) < 0) return (n);
+    } while (is_vol_hdr_ind (rec[6]));
+    return (parse_ms (rec, n, phdr, data_buffer, max_num_points));
+}
+
+/************************************************************************/
+/*  ms_reader_close:							*/
+/*	Close a reader and free its storage.				*/
+/************************************************************************/
+void ms_reader_close
+   (MS_READER	*r)		/* ptr to MS_READER.			*/
+{
+    if (r->ra) ra_stop (r);
+    if (r->map) munmap (r->map, (size_t)r->maplen);
+    if (r->buf) free (r->buf);
+#ifdef	HAVE_ZLIB
+    if (r->type == MS_READER_GZIP && r->zs) {
+	gzclose ((gzFile)r->zs);
+	r->fd = -1;
+    }
+#endif
+#ifdef	HAVE_ZSTD
+    if (r->type == MS_READER_ZSTD && r->zs) {
+	ZSTD_STATE *z = (ZSTD_STATE *)r->zs;
+	if (z->ds) ZSTD_freeDStream (z->ds);
+	if (z->in) free (z->in);
+	free ((char *)z);
+    }
+#endif
+    if (r->fp) fclose (r->fp);
+    else if (r->fd >= 0) close (r->fd);
+    free ((char *)r);
+}
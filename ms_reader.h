@@ -0,0 +1,103 @@
+/************************************************************************/
+/*  Record readers for plain and compressed MiniSEED files.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_reader_h
+#define	__ms_reader_h
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "data_hdr.h"
+
+/*	Reader backends.  MS_READER_AUTO selects the backend from the	*/
+/*	first bytes of the file.					*/
+
+#define	MS_READER_AUTO		0
+#define	MS_READER_STDIO		1
+#define	MS_READER_MMAP		2
+#define	MS_READER_GZIP		3
+#define	MS_READER_ZSTD		4
+
+/*	Flag to read ahead on a helper thread.				*/
+#define	MS_READER_READAHEAD	0x100
+
+/*	State of a MiniSEED record reader.				*/
+
+typedef struct _ms_reader {
+    int		type;		/* reader backend.			*/
+    int		flags;		/* reader flags.			*/
+    int		fd;		/* file descriptor of file.		*/
+    FILE	*fp;		/* FILE pointer for stdio backend.	*/
+    char	*map;		/* mapped file for mmap backend.	*/
+    int64_t	maplen;		/* size of mapped file.			*/
+    void	*zs;		/* decompression state.			*/
+    void	*ra;		/* read-ahead state.			*/
+    char	*buf;		/* buffer of data read from file.	*/
+    int		buflen;		/* allocated size of buf.		*/
+    int		pos;		/* offset of next record in buf.	*/
+    int		len;		/* # of bytes in buf.			*/
+    int		eof;		/* set when all data has been read.	*/
+    int64_t	offset;		/* offset of next record in data.	*/
+    int64_t	rec_offset;	/* offset of last record in data.	*/
+} MS_READER;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern MS_READER *ms_reader_open
+   (char	*filename,	/* name of MiniSEED file.		*/
+    int		type);		/* backend type, with optional flags.	*/
+
+extern int ms_reader_next
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    char	**prec);	/* ptr to record (returned).		*/
+
+extern int ms_reader_read_ms
+   (MS_READER	*r,		/* ptr to MS_READER.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points);/* max # data points to return.		*/
+
+extern void ms_reader_close
+   (MS_READER	*r);		/* ptr to MS_READER.			*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1030 @@
+/************************************************************************/
+/*  Header-only scanning of MiniSEED records.				*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qtime.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_sncl.h"
+#include "ms_scan.h"
+
+#define	FIXED_DATA_HDR_SIZE 48
+#define	MIN_RECLEN	128	/* smallest valid MiniSEED record.	*/
+#define	MIN_BLKEXP	7	/* smallest valid blksize exponent.	*/
+#define	MAX_BLKEXP	30	/* largest valid blksize exponent.	*/
+#define	SCAN_HDRLEN	4096	/* max header bytes read by ms_scan_record.*/
+#define	SCAN_INCREMENT	1024	/* # of summaries to allocate at a time.*/
+#define	RESYNC_BUFLEN	65536	/* size of blocks searched by ms_resync.*/
+#define	SOA_SNCL_LEN	12	/* # of raw SNCL bytes in fixed header.	*/
+#define	SOA_SNCL_CACHE	64	/* # of channel ids cached per decode.	*/
+
+/************************************************************************/
+/*  get_u16:								*/
+/*	Extract an unsigned 16 bit value, swapping if required.		*/
+/************************************************************************/
+static int get_u16
+   (char	*p,		/* ptr to value.			*/
+    int		swapflag)	/* swap if non-zero.			*/
+{
+    unsigned short int us;
+
+    memcpy ((void *)&us, p, sizeof(us));
+    if (swapflag) swab2 ((short int *)&us);
+    return ((int)us);
+}
+
+/************************************************************************/
+/*  get_i16:								*/
+/*	Extract a signed 16 bit value, swapping if required.		*/
+/************************************************************************/
+static int get_i16
+   (char	*p,		/* ptr to value.			*/
+    int		swapflag)	/* swap if non-zero.			*/
+{
+    short int s;
+
+    memcpy ((void *)&s, p, sizeof(s));
+    if (swapflag) swab2 (&s);
+    return ((int)s);
+}
+
+/************************************************************************/
+/*  get_i32:								*/
+/*	Extract a signed 32 bit value, swapping if required.		*/
+/************************************************************************/
+static int get_i32
+   (char	*p,		/* ptr to value.			*/
+    int		swapflag)	/* swap if non-zero.			*/
+{
+    int i;
+
+    memcpy ((void *)&i, p, sizeof(i));
+    if (swapflag) swab4 (&i);
+    return (i);
+}
+
+/************************************************************************/
+/*  scan_wordorder:							*/
+/*	Determine the word order of a fixed data header from the year	*/
+/*	of its time field, as wordorder_from_time does, but without	*/
+/*	printing an error, since scanning may encounter non-MiniSEED	*/
+/*	data.								*/
+/*  return:	wordorder, or MS_ERROR if it cannot be determined.	*/
+/************************************************************************/
+static int scan_wordorder
+   (unsigned char *p)		/* ptr to fixed data time field.	*/
+{
+    if ((p[0] == 0x07 && p[1] >= 0x08) || (p[0] == 0x08 && p[1] < 0x07))
+	return (SEED_BIG_ENDIAN);
+    if ((p[1] == 0x07 && p[0] >= 0x08) || (p[1] == 0x08 && p[0] < 0x07))
+	return (SEED_LITTLE_ENDIAN);
+    return (MS_ERROR);
+}
+
+/************************************************************************/
+/*  hdr_bytes_needed:							*/
+/*	Determine how many bytes of a record must be read to parse its	*/
+/*	header and blockettes, given its fixed data header.		*/
+/*  return:	# of bytes, or MS_ERROR if not a valid header.		*/
+/************************************************************************/
+static int hdr_bytes_needed
+   (char	*rec)		/* ptr to fixed data header.		*/
+{
+    SDR_HDR	*sh = (SDR_HDR *)rec;
+    int		wo, first_data;
+
+    if (is_vol_hdr_ind (sh->data_hdr_ind)) return (FIXED_DATA_HDR_SIZE);
+    if (! is_data_hdr_ind (sh->data_hdr_ind)) return (MS_ERROR);
+    if ((wo = scan_wordorder ((unsigned char *)&sh->time)) < 0) 
+	return (MS_ERROR);
+    if (my_wordorder < 0) get_my_wordorder();
+    first_data = get_u16 ((char *)&sh->first_data, wo != my_wordorder);
+    /* If there is no data, the blockettes may extend to the end of	*/
+    /* the record, which is at least MIN_RECLEN bytes.			*/
+    if (first_data < MIN_RECLEN) return (MIN_RECLEN);
+    return ((first_data > SCAN_HDRLEN) ? SCAN_HDRLEN : first_data);
+}
+
+/************************************************************************/
+/*  ms_parse_summary:							*/
+/*	Parse the fixed data header and blockettes of a MiniSEED	*/
+/*	record into an MS_SUMMARY, without allocating a DATA_HDR or	*/
+/*	decoding any data.  Only the first nbytes of the record are	*/
+/*	examined.  For a volume header, only the record_type and	*/
+/*	blksize are returned.						*/
+/*  return:								*/
+/*	0 on success.							*/
+/*	MS_ERROR if the record is not a valid MiniSEED record.		*/
+/************************************************************************/
+int ms_parse_summary
+   (char	*rec,		/* ptr to start of MiniSEED record.	*/
+    int		nbytes,		/* # of bytes of record available.	*/
+    MS_SUMMARY	*s)		/* summary of record (returned).	*/
+{
+    SDR_HDR	*sh = (SDR_HDR *)rec;
+    SAMPLE_CLOCK sc;
+    char	tmp[80];
+    char	*pb;
+    float	actual_rate;
+    int		swapflag;
+    int		nblockettes, first_blockette;
+    int		off, next, type, i, wo, exp;
+    int		usec99 = 0;
+
+    if (nbytes < FIXED_DATA_HDR_SIZE) return (MS_ERROR);
+    memset ((char *)s, 0, sizeof(MS_SUMMARY));
+    s->offset = -1;
+    s->record_type = sh->data_hdr_ind;
+    s->seq_no = atoi (charncpy (tmp, sh->seq_no, 6));
+
+    /* Volume headers contain the blksize of the volume.		*/
+    if (is_vol_hdr_ind (sh->data_hdr_ind)) {
+	s->blksize = 4096;
+	pb = rec + 8;
+	switch (atoi (charncpy (tmp, pb, 3))) {
+	  case 5:
+	  case 8:
+	  case 10:
+	    exp = atoi (charncpy (tmp, pb+11, 2));
+	    if (exp < MIN_BLKEXP || exp > MAX_BLKEXP) return (MS_ERROR);
+	    s->blksize = 1 << exp;
+	    break;
+	  default:
+	    break;
+	}
+	return (0);
+    }
+    if (! is_data_hdr_ind (sh->data_hdr_ind)) return (MS_ERROR);
+
+    if ((wo = scan_wordorder ((unsigned char *)&sh->time)) < 0) 
+	return (MS_ERROR);
+    if (my_wordorder < 0) get_my_wordorder();
+    swapflag = (wo != my_wordorder);
+    s->hdr_wordorder = s->data_wordorder = wo;
+    trim (charncpy (s->station_id, sh->station_id, DH_STATION_LEN));
+    trim (charncpy (s->location_id, sh->location_id, DH_LOCATION_LEN));
+    trim (charncpy (s->channel_id, sh->channel_id, DH_CHANNEL_LEN));
+    trim (charncpy (s->network_id, sh->network_id, DH_NETWORK_LEN));
+    s->num_samples = get_u16 ((char *)&sh->num_samples, swapflag);
+    s->sample_rate = get_i16 ((char *)&sh->sample_rate_factor, swapflag);
+    s->sample_rate_mult = get_i16 ((char *)&sh->sample_rate_mult, swapflag);
+    s->first_data = get_u16 ((char *)&sh->first_data, swapflag);
+    s->data_type = UNKNOWN_DATATYPE;
+    nblockettes = (unsigned char)sh->num_blockettes;
+    first_blockette = get_u16 ((char *)&sh->first_blockette, swapflag);
+
+    /* Walk the blockettes within the available bytes.  Only the	*/
+    /* blockettes needed for the summary are examined.			*/
+    off = (nblockettes > 0) ? first_blockette : 0;
+    for (i=0; i<nblockettes && off >= FIXED_DATA_HDR_SIZE; i++) {
+	if (off + 8 > nbytes) break;
+	pb = rec + off;
+	type = get_u16 (pb, swapflag);
+	next = get_u16 (pb+2, swapflag);
+	switch (type) {
+	  case 1000:
+	    s->data_type = pb[4];
+	    s->data_wordorder = pb[5];
+	    if (pb[6] < MIN_BLKEXP || pb[6] > MAX_BLKEXP) return (MS_ERROR);
+	    s->blksize = 1 << pb[6];
+	    break;
+	  case 1001:
+	    usec99 = (signed char)pb[5];
+	    break;
+	  case 100:
+	    memcpy ((void *)&actual_rate, pb+4, sizeof(actual_rate));
+	    if (swapflag) swab4 ((int *)&actual_rate);
+	    s->rate_spsec = actual_rate;
+	    break;
+	  default:
+	    break;
+	}
+	if (next <= off) break;
+	off = next;
+    }
+    /* MiniSEED requires a blockette 1000.				*/
+    if (s->blksize < MIN_RECLEN) return (MS_ERROR);
+
+    /* Compute times as decode_hdr_sdr does.				*/
+    s->begtime = add_time (decode_time_sdr (sh->time, wo), 0, usec99);
+    i = get_i32 ((char *)&sh->num_ticks_correction, swapflag);
+    if (i != 0 && (sh->activity_flags & ACTIVITY_TIME_CORR_APPLIED) == 0)
+	s->begtime = add_dtime (s->begtime, (double)i * USECS_PER_TICK);
+    if (s->rate_spsec == 0 || 
+	init_sample_clock_sps (&sc, s->begtime, s->rate_spsec) != 0)
+	init_sample_clock (&sc, s->begtime, s->sample_rate, s->sample_rate_mult);
+    s->endtime = sample_clock_time (&sc, s->num_samples - 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_record_length:							*/
+/*	Determine the length of the MiniSEED record at the start of a	*/
+/*	buffer from its fixed data header and blockette 1000, using	*/
+/*	only the first nbytes of the record.				*/
+/*  return:								*/
+/*	blksize of the record on success.				*/
+/*	0 if more bytes are needed to determine the blksize.		*/
+/*	MS_ERROR if the buffer does not start with a MiniSEED record.	*/
+/************************************************************************/
+int ms_record_length
+   (char	*rec,		/* ptr to start of MiniSEED record.	*/
+    int		nbytes)		/* # of bytes of record available.	*/
+{
+    SDR_HDR	*sh = (SDR_HDR *)rec;
+    MS_SUMMARY	s;
+    char	*pb;
+    int		swapflag;
+    int		nblockettes, off, next, i, wo;
+
+    if (nbytes < FIXED_DATA_HDR_SIZE) return (0);
+    if (is_vol_hdr_ind (sh->data_hdr_ind)) {
+	if (ms_parse_summary (rec, nbytes, &s) < 0) return (MS_ERROR);
+	return (s.blksize);
+    }
+    if (! is_data_hdr_ind (sh->data_hdr_ind)) return (MS_ERROR);
+    if ((wo = scan_wordorder ((unsigned char *)&sh->time)) < 0) 
+	return (MS_ERROR);
+    if (my_wordorder < 0) get_my_wordorder();
+    swapflag = (wo != my_wordorder);
+    nblockettes = (unsigned char)sh->num_blockettes;
+    off = get_u16 ((char *)&sh->first_blockette, swapflag);
+
+    for (i=0; i<nblockettes && off >= FIXED_DATA_HDR_SIZE; i++) {
+	if (off + 8 > nbytes) return (0);
+	pb = rec + off;
+	if (get_u16 (pb, swapflag) == 1000) {
+	    if (pb[6] < MIN_BLKEXP || pb[6] > MAX_BLKEXP) return (MS_ERROR);
+	    return (1 << pb[6]);
+	}
+	next = get_u16 (pb+2, swapflag);
+	if (next <= off) break;
+	off = next;
+    }
+    /* MiniSEED requires a blockette 1000.				*/
+    return (MS_ERROR);
+}
+
+/************************************************************************/
+/*  ms_scan_record:							*/
+/*	Read the header of the next MiniSEED data record from a file	*/
+/*	and return its summary.  Only the fixed data header and the	*/
+/*	blockettes up to first_data are read.  The rest of the record	*/
+/*	is skipped with fseek, or read and discarded if the file is not	*/
+/*	seekable.  Volume headers are skipped.				*/
+/*  return:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int ms_scan_record
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    MS_SUMMARY	*s)		/* summary of record (returned).	*/
+{
+    char	buf[SCAN_HDRLEN];
+    off_t	offset;
+    int		nread, need, skip, n;
+
+    for (;;) {
+	offset = ftello (fp);
+	if ((nread = fread (buf, 1, FIXED_DATA_HDR_SIZE, fp)) != FIXED_DATA_HDR_SIZE) 
+	    return ((nread == 0) ? EOF : MS_ERROR);
+	if ((need = hdr_bytes_needed (buf)) < 0) return (MS_ERROR);
+	if (need > nread) {
+	    if (fread (buf+nread, need-nread, 1, fp) != 1) return (MS_ERROR);
+	    nread = need;
+	}
+	if (ms_parse_summary (buf, nread, s) < 0) return (MS_ERROR);
+	s->offset = offset;
+	if (s->blksize < nread) return (MS_ERROR);
+
+	/* Skip the remainder of the record.				*/
+	skip = s->blksize - nread;
+	if (skip > 0 && fseeko (fp, (off_t)skip, SEEK_CUR) != 0) {
+	    while (skip > 0) {
+		n = (skip > SCAN_HDRLEN) ? SCAN_HDRLEN : skip;
+		if (fread (buf, n, 1, fp) != 1) return (MS_ERROR);
+		skip -= n;
+	    }
+	}
+	if (! is_vol_hdr_ind (s->record_type)) break;
+    }
+    return (s->blksize);
+}
+
+/************************************************************************/
+/*  ms_scan_buf:							*/
+/*	Return the summary of the next MiniSEED data record in a	*/
+/*	buffer, such as a memory mapped file, and advance *offset past	*/
+/*	the record.  Volume headers are skipped.			*/
+/*  return:								*/
+/*	blksize on success.						*/
+/*	EOF on end of buffer.						*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int ms_scan_buf
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int64_t	*offset,	/* offset of next record (updated).	*/
+    MS_SUMMARY	*s)		/* summary of record (returned).	*/
+{
+    int64_t	remain;
+
+    for (;;) {
+	remain = nbytes - *offset;
+	if (remain <= 0) return (EOF);
+	if (ms_parse_summary (buf + *offset, 
+			      (remain > SCAN_HDRLEN) ? SCAN_HDRLEN : (int)remain, 
+			      s) < 0) 
+	    return (MS_ERROR);
+	if (s->blksize > remain) return (MS_ERROR);
+	s->offset = *offset;
+	*offset += s->blksize;
+	if (! is_vol_hdr_ind (s->record_type)) break;
+    }
+    return (s->blksize);
+}
+
+/************************************************************************/
+/*  ms_scan_file:							*/
+/*	Return the summaries of all MiniSEED data records in a file.	*/
+/*	The file is memory mapped if possible, otherwise it is scanned	*/
+/*	with ms_scan_record.  The caller must free the returned array.	*/
+/*  return:								*/
+/*	# of data records on success.					*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_scan_file
+   (char	*filename,	/* name of MiniSEED file.		*/
+    MS_SUMMARY	**psum)		/* array of summaries (returned).	*/
+{
+    struct stat	sb;
+    MS_SUMMARY	*sum = NULL;
+    MS_SUMMARY	s;
+    FILE	*fp = NULL;
+    char	*buf = NULL;
+    int64_t	offset = 0;
+    int		nalloc = 0;
+    int		n = 0;
+    int		fd, status;
+
+    *psum = NULL;
+    if ((fd = open (filename, O_RDONLY)) < 0) {
+	fprintf (stderr, "Error: unable to open %s in ms_scan_file\n", filename);
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    if (fstat (fd, &sb) != 0) {
+	close (fd);
+	return (MS_ERROR);
+    }
+    if (sb.st_size > 0) {
+	buf = (char *)mmap (NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (buf == (char *)MAP_FAILED) {
+	    buf = NULL;
+	    fp = fdopen (fd, "r");
+	}
+    }
+
+    for (;;) {
+	if (buf) status = ms_scan_buf (buf, (int64_t)sb.st_size, &offset, &s);
+	else if (fp) status = ms_scan_record (fp, &s);
+	else status = EOF;
+	if (status < 0) break;
+	if (n == nalloc) {
+	    MS_SUMMARY *p = (MS_SUMMARY *)realloc (sum, (nalloc + SCAN_INCREMENT) * 
+						   sizeof(MS_SUMMARY));
+	    if (p == NULL) {
+		status = QLIB2_MALLOC_ERROR;
+		break;
+	    }
+	    sum = p;
+	    nalloc += SCAN_INCREMENT;
+	}
+	sum[n++] = s;
+    }
+
+    if (buf) munmap (buf, (size_t)sb.st_size);
+    if (fp) fclose (fp);
+    else close (fd);
+    if (status != EOF) {
+	if (sum) free ((char *)sum);
+	if (status == QLIB2_MALLOC_ERROR) {
+	    fprintf (stderr, "Error: unable to malloc summaries in ms_scan_file\n");
+	    fflush (stderr);
+	    if (QLIB2_CLASSIC) exit(1);
+	}
+	return (status);
+    }
+    *psum = sum;
+    return (n);
+}
+
+/************************************************************************/
+/*  time_cmp:								*/
+/*	Compare two INT_TIMEs.						*/
+/*  return:	<0, 0, >0 if a is before, equal to, or after b.		*/
+/************************************************************************/
+static int time_cmp
+   (INT_TIME	a,		/* first time.				*/
+    INT_TIME	b)		/* second time.				*/
+{
+    if (a.year != b.year) return ((a.year < b.year) ? -1 : 1);
+    if (a.second != b.second) return ((a.second < b.second) ? -1 : 1);
+    if (a.usec != b.usec) return ((a.usec < b.usec) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  read_summary_at:							*/
+/*	Read the header of the record at the specified offset of a	*/
+/*	file and return its summary.  The file is read with fseeko and	*/
+/*	fread if fp is not NULL, otherwise with pread on fd.		*/
+/*  return:								*/
+/*	0 on success.							*/
+/*	EOF if offset is at or past the end of the file.		*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+static int read_summary_at
+   (FILE	*fp,		/* FILE pointer for input file, or NULL.*/
+    int		fd,		/* file descriptor if fp is NULL.	*/
+    int64_t	offset,		/* offset of record.			*/
+    MS_SUMMARY	*s)		/* summary of record (returned).	*/
+{
+    char	buf[SCAN_HDRLEN];
+    int		nread, need;
+
+    if (fp) {
+	if (fseeko (fp, (off_t)offset, SEEK_SET) != 0) return (MS_ERROR);
+	nread = fread (buf, 1, FIXED_DATA_HDR_SIZE, fp);
+    }
+    else nread = pread (fd, buf, FIXED_DATA_HDR_SIZE, (off_t)offset);
+    if (nread != FIXED_DATA_HDR_SIZE) return ((nread == 0) ? EOF : MS_ERROR);
+    if ((need = hdr_bytes_needed (buf)) < 0) return (MS_ERROR);
+    if (need > nread) {
+	if (fp) nread += fread (buf+nread, 1, need-nread, fp);
+	else nread += pread (fd, buf+nread, need-nread, (off_t)(offset+nread));
+	if (nread != need) return (MS_ERROR);
+    }
+    if (ms_parse_summary (buf, nread, s) < 0) return (MS_ERROR);
+    s->offset = offset;
+    return (0);
+}
+
+/************************************************************************/
+/*  seek_time_linear:							*/
+/*	Find the first data record in a file with samples at or after	*/
+/*	the specified time by reading every record header.		*/
+/*  return:								*/
+/*	offset of record on success.					*/
+/*	EOF if no record has samples at or after the time.		*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+static int64_t seek_time_linear
+   (FILE	*fp,		/* FILE pointer for input file, or NULL.*/
+    int		fd,		/* file descriptor if fp is NULL.	*/
+    INT_TIME	t)		/* time to find.			*/
+{
+    MS_SUMMARY	s;
+    int64_t	offset = 0;
+    int		status;
+
+    while ((status = read_summary_at (fp, fd, offset, &s)) == 0) {
+	if (! is_vol_hdr_ind (s.record_type) && s.num_samples > 0 &&
+	    time_cmp (s.endtime, t) >= 0) return (offset);
+	offset += s.blksize;
+    }
+    return (status);
+}
+
+/************************************************************************/
+/*  same_stream:							*/
+/*	Determine whether a record is a data record of the same channel	*/
+/*	and blksize as the first record.				*/
+/************************************************************************/
+static int same_stream
+   (MS_SUMMARY	*s0,		/* summary of first record.		*/
+    MS_SUMMARY	*s)		/* summary of record.			*/
+{
+    return (is_data_hdr_ind (s->record_type) && s->blksize == s0->blksize &&
+	    strcmp (s->station_id, s0->station_id) == 0 &&
+	    strcmp (s->network_id, s0->network_id) == 0 &&
+	    strcmp (s->channel_id, s0->channel_id) == 0 &&
+	    strcmp (s->location_id, s0->location_id) == 0);
+}
+
+/************************************************************************/
+/*  seek_time:								*/
+/*	Find the first data record in a file with samples at or after	*/
+/*	the specified time.  If the file is a regular file whose size	*/
+/*	is a multiple of the blksize of the first record, the records	*/
+/*	are assumed to be of one channel in time order, and the record	*/
+/*	is found by bisection on the record begin times.  If any	*/
+/*	record examined contradicts that assumption, the file is	*/
+/*	scanned linearly instead.					*/
+/*  return:								*/
+/*	offset of record on success.					*/
+/*	EOF if no record has samples at or after the time.		*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+static int64_t seek_time
+   (FILE	*fp,		/* FILE pointer for input file, or NULL.*/
+    int		fd,		/* file descriptor if fp is NULL.	*/
+    INT_TIME	t)		/* time to find.			*/
+{
+    struct stat	sb;
+    MS_SUMMARY	s0, slo, shi, s;
+    int64_t	nrecs, lo, hi, mid;
+    int		blksize, status;
+
+    if (fstat ((fp) ? fileno (fp) : fd, &sb) != 0 || ! S_ISREG (sb.st_mode))
+	return (seek_time_linear (fp, fd, t));
+    if ((status = read_summary_at (fp, fd, 0, &s0)) < 0) return (status);
+    blksize = s0.blksize;
+    if (! is_data_hdr_ind (s0.record_type) || sb.st_size % blksize != 0)
+	return (seek_time_linear (fp, fd, t));
+    if (time_cmp (t, s0.begtime) <= 0) return (0);
+
+    /* Bisect to find the last record with begtime <= t.		*/
+    nrecs = sb.st_size / blksize;
+    lo = 0;
+    slo = s0;
+    hi = nrecs - 1;
+    if (read_summary_at (fp, fd, hi * blksize, &shi) < 0 || 
+	! same_stream (&s0, &shi) || time_cmp (shi.begtime, s0.begtime) < 0)
+	return (seek_time_linear (fp, fd, t));
+    if (time_cmp (shi.begtime, t) <= 0) {
+	lo = hi;
+	slo = shi;
+    }
+    while (hi - lo > 1) {
+	mid = lo + (hi - lo) / 2;
+	if (read_summary_at (fp, fd, mid * blksize, &s) < 0 || 
+	    ! same_stream (&s0, &s) || time_cmp (s.begtime, slo.begtime) < 0 ||
+	    time_cmp (s.begtime, shi.begtime) > 0)
+	    return (seek_time_linear (fp, fd, t));
+	if (time_cmp (s.begtime, t) <= 0) {
+	    lo = mid;
+	    slo = s;
+	}
+	else {
+	    hi = mid;
+	    shi = s;
+	}
+    }
+
+    /* The record at lo starts at or before t.  If it ends before t,	*/
+    /* the next record is the first one with samples at or after t.	*/
+    if (slo.num_samples > 0 && time_cmp (slo.endtime, t) >= 0) 
+	return (lo * blksize);
+    return ((lo + 1 < nrecs) ? (lo + 1) * blksize : EOF);
+}
+
+/************************************************************************/
+/*  ms_seek_time:							*/
+/*	Position a MiniSEED file at the first data record with samples	*/
+/*	at or after the specified time.  For a file of one channel in	*/
+/*	time order with a uniform blksize, the record is found by	*/
+/*	bisection, reading O(log n) record headers.  Otherwise, the	*/
+/*	file is scanned from the beginning.  If there is no such	*/
+/*	record, the file is positioned at its end.			*/
+/*  return:								*/
+/*	offset of record on success.					*/
+/*	EOF if no record has samples at or after the time.		*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int64_t ms_seek_time
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    INT_TIME	t)		/* time to find.			*/
+{
+    int64_t	offset;
+
+    offset = seek_time (fp, -1, t);
+    if (offset >= 0) {
+	if (fseeko (fp, (off_t)offset, SEEK_SET) != 0) return (MS_ERROR);
+    }
+    else if (offset == EOF) {
+	if (fseeko (fp, (off_t)0, SEEK_END) != 0) return (MS_ERROR);
+    }
+    return (offset);
+}
+
+/************************************************************************/
+/*  ms_seek_time_fd:							*/
+/*	Position a MiniSEED file descriptor at the first data record	*/
+/*	with samples at or after the specified time, as ms_seek_time.	*/
+/*	The record headers are read with pread.				*/
+/*  return:								*/
+/*	offset of record on success.					*/
+/*	EOF if no record has samples at or after the time.		*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int64_t ms_seek_time_fd
+   (int		fd,		/* file descriptor for input file.	*/
+    INT_TIME	t)		/* time to find.			*/
+{
+    int64_t	offset;
+
+    offset = seek_time (NULL, fd, t);
+    if (offset >= 0) {
+	if (lseek (fd, (off_t)offset, SEEK_SET) < 0) return (MS_ERROR);
+    }
+    else if (offset == EOF) {
+	if (lseek (fd, (off_t)0, SEEK_END) < 0) return (MS_ERROR);
+    }
+    return (offset);
+}
+
+/************************************************************************/
+/*  resync_check:							*/
+/*	Determine whether a buffer position holds a plausible MiniSEED	*/
+/*	fixed data header: six ASCII digits for the sequence number, a	*/
+/*	valid data header indicator, a valid time with a plausible	*/
+/*	year, consistent blockette offsets with a blockette 1000, and	*/
+/*	a first_data offset within the record.				*/
+/*  return:								*/
+/*	1 if the header is plausible.					*/
+/*	0 if it is not.							*/
+/*	-1 if more bytes are needed to decide.				*/
+/************************************************************************/
+static int resync_check
+   (char	*rec,		/* ptr to candidate record.		*/
+    int64_t	avail)		/* # of bytes available at rec.		*/
+{
+    SDR_HDR	*sh = (SDR_HDR *)rec;
+    unsigned char *t;
+    int		i, wo, swapflag, day, ticks, first_data, blksize;
+
+    for (i=0; i<6 && i<avail; i++) {
+	if (rec[i] < '0' || rec[i] > '9') return (0);
+    }
+    if (avail < FIXED_DATA_HDR_SIZE) return (-1);
+    if (! is_data_hdr_ind (sh->data_hdr_ind)) return (0);
+    t = (unsigned char *)&sh->time;
+    if ((wo = scan_wordorder (t)) < 0) return (0);
+    if (my_wordorder < 0) get_my_wordorder();
+    swapflag = (wo != my_wordorder);
+    day = get_u16 ((char *)t+2, swapflag);
+    ticks = get_u16 ((char *)t+8, swapflag);
+    if (day < 1 || day > 366 || t[4] > 23 || t[5] > 59 || t[6] > 60 || 
+	ticks > 9999) return (0);
+
+    blksize = ms_record_length (rec, (avail > SCAN_HDRLEN) ? SCAN_HDRLEN : (int)avail);
+    if (blksize < 0) return (0);
+    if (blksize == 0) return ((avail >= SCAN_HDRLEN) ? 0 : -1);
+    first_data = get_u16 ((char *)&sh->first_data, swapflag);
+    if (first_data != 0 && (first_data < FIXED_DATA_HDR_SIZE || first_data >= blksize))
+	return (0);
+    return (1);
+}
+
+/************************************************************************/
+/*  ms_resync_buf:							*/
+/*	Search a buffer for the next plausible MiniSEED fixed data	*/
+/*	header at or after the specified offset, for recovery from	*/
+/*	corrupt or misaligned data.  Candidates are found by searching	*/
+/*	for the data header indicator bytes with memchr, and each	*/
+/*	candidate is checked with resync_check.  If pincomplete is not	*/
+/*	NULL, the search stops at the first candidate that runs past	*/
+/*	the end of the buffer and sets *pincomplete to 1.  Otherwise	*/
+/*	such candidates are rejected.					*/
+/*  return:								*/
+/*	offset of header on success.					*/
+/*	EOF if there is no plausible header.				*/
+/************************************************************************/
+int64_t ms_resync_buf
+   (char	*buf,		/* buffer to search.			*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int64_t	offset,		/* offset at which to start search.	*/
+    int		*pincomplete)	/* set if candidate is incomplete.	*/
+{
+    static char	ind[] = "DRQM";
+    int64_t	next[4];	/* next offset of each indicator.	*/
+    int64_t	pos, m;
+    char	*p;
+    int		i, status;
+
+    if (pincomplete) *pincomplete = 0;
+    for (i=0; i<4; i++) next[i] = -1;
+
+    /* The indicator is at offset 6 of the header.			*/
+    for (pos = offset + 6; pos < nbytes; pos = m + 1) {
+	m = nbytes;
+	for (i=0; i<4; i++) {
+	    if (next[i] < pos) {
+		p = (char *)memchr (buf + pos, ind[i], (size_t)(nbytes - pos));
+		next[i] = (p) ? p - buf : nbytes;
+	    }
+	    if (next[i] < m) m = next[i];
+	}
+	if (m >= nbytes) break;
+	status = resync_check (buf + m - 6, nbytes - (m - 6));
+	if (status > 0) return (m - 6);
+	if (status < 0 && pincomplete) {
+	    *pincomplete = 1;
+	    return (m - 6);
+	}
+    }
+    return (EOF);
+}
+
+/************************************************************************/
+/*  ms_resync:								*/
+/*	Position a MiniSEED file at the next plausible fixed data	*/
+/*	header after the specified offset, for recovery after		*/
+/*	read_ms_hdr or read_ms returns MS_ERROR for the record at that	*/
+/*	offset.  The search starts at the following byte, since the	*/
+/*	failed read may have consumed the start of the next record.	*/
+/*	The file is read in large blocks and searched with		*/
+/*	ms_resync_buf, and is then positioned with fseeko, so it must	*/
+/*	be seekable.							*/
+/*  return:								*/
+/*	offset of header on success.					*/
+/*	EOF if there is no plausible header.				*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int64_t ms_resync
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    int64_t	offset)		/* offset of the bad record.		*/
+{
+    char	*buf;
+    int64_t	base, k;
+    int		nbuf = 0;
+    int		nread, incomplete, keep;
+
+    if (fseeko (fp, (off_t)(offset + 1), SEEK_SET) != 0) return (MS_ERROR);
+    if ((buf = (char *)malloc (RESYNC_BUFLEN)) == NULL) {
+	fprintf (stderr, "Error: unable to malloc buffer in ms_resync\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    base = offset + 1;
+    for (;;) {
+	nread = fread (buf + nbuf, 1, RESYNC_BUFLEN - nbuf, fp);
+	nbuf += nread;
+	k = ms_resync_buf (buf, nbuf, 0, (nread > 0) ? &incomplete : NULL);
+	if (k >= 0 && ! (nread > 0 && incomplete)) break;
+	if (nread == 0) break;
+	/* Keep the incomplete candidate, which is shorter than		*/
+	/* SCAN_HDRLEN, or the bytes that may begin a header whose	*/
+	/* indicator has not been read yet.				*/
+	if (k >= 0) keep = nbuf - (int)k;
+	else keep = (nbuf > 6) ? 6 : nbuf;
+	memmove (buf, buf + nbuf - keep, keep);
+	base += nbuf - keep;
+	nbuf = keep;
+    }
+    free (buf);
+    if (k < 0) return (EOF);
+    if (fseeko (fp, (off_t)(base + k), SEEK_SET) != 0) return (MS_ERROR);
+    return (base + k);
+}
+
+/************************************************************************/
+/*  ms_hdr_soa_init:							*/
+/*	Initialize an MS_HDR_SOA.					*/
+/************************************************************************/
+void ms_hdr_soa_init
+   (MS_HDR_SOA	*out)		/* ptr to MS_HDR_SOA.			*/
+{
+    memset ((char *)out, 0, sizeof(MS_HDR_SOA));
+}
+
+/************************************************************************/
+/*  ms_hdr_soa_free:							*/
+/*	Free the arrays of an MS_HDR_SOA.				*/
+/************************************************************************/
+void ms_hdr_soa_free
+   (MS_HDR_SOA	*out)		/* ptr to MS_HDR_SOA.			*/
+{
+    if (out->begtime) free ((char *)out->begtime);
+    if (out->nsamples) free ((char *)out->nsamples);
+    if (out->rate) free ((char *)out->rate);
+    if (out->sncl_id) free ((char *)out->sncl_id);
+    if (out->data_type) free ((char *)out->data_type);
+    if (out->timing_quality) free ((char *)out->timing_quality);
+    if (out->offset) free ((char *)out->offset);
+    ms_hdr_soa_init (out);
+}
+
+/************************************************************************/
+/*  soa_reserve:							*/
+/*	Ensure that the arrays of an MS_HDR_SOA hold n records.		*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int soa_reserve
+   (MS_HDR_SOA	*out,		/* ptr to MS_HDR_SOA.			*/
+    int		n)		/* # of records required.		*/
+{
+    void	*p;
+
+    if (n <= out->maxrecords) return (0);
+#define	SOA_GROW(field,type) \
+    if ((p = realloc (out->field, n * sizeof(type))) == NULL) \
+	return (QLIB2_MALLOC_ERROR); \
+    out->field = (type *)p;
+    SOA_GROW(begtime, int64_t)
+    SOA_GROW(nsamples, int)
+    SOA_GROW(rate, double)
+    SOA_GROW(sncl_id, int)
+    SOA_GROW(data_type, signed char)
+    SOA_GROW(timing_quality, signed char)
+    SOA_GROW(offset, int64_t)
+#undef	SOA_GROW
+    out->maxrecords = n;
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_decode_headers_soa:						*/
+/*	Decode the headers of n_records consecutive records of blksize	*/
+/*	bytes in a buffer into the parallel arrays of an MS_HDR_SOA.	*/
+/*	Only the fixed data header and blockettes 100, 1000 and 1001	*/
+/*	are examined, and no DATA_HDR or other per-record storage is	*/
+/*	allocated.  The arrays are grown if they are too small, so an	*/
+/*	MS_HDR_SOA can be reused for many buffers without allocation.	*/
+/*	Volume headers are skipped, and records that are not valid	*/
+/*	data records are skipped and counted in out->nerrors.  Offsets	*/
+/*	are relative to the start of buf.				*/
+/*  return:								*/
+/*	# of data records decoded on success.				*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_decode_headers_soa
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int		n_records,	/* # of records in buffer.		*/
+    int		blksize,	/* size of each record in bytes.	*/
+    MS_HDR_SOA	*out)		/* decoded headers (returned).		*/
+{
+    /* Channel names seen recently, so that ms_sncl_id is only called	*/
+    /* when the raw SNCL bytes of a record are new.			*/
+    char	ckey[SOA_SNCL_CACHE][SOA_SNCL_LEN];
+    int		cid[SOA_SNCL_CACHE];
+    SDR_HDR	*sh;
+    INT_TIME	t, ys;
+    char	station[DH_STATION_LEN+1], location[DH_LOCATION_LEN+1];
+    char	channel[DH_CHANNEL_LEN+1], network[DH_NETWORK_LEN+1];
+    char	*rec, *pb;
+    float	actual_rate;
+    double	rate;
+    int64_t	ystart = 0;	/* true epoch usecs of start of year.	*/
+    unsigned int h;
+    int		year = 0;
+    int		swapflag, wo, nblockettes, off, next, type;
+    int		data_type, tq, usec99, corr, id, i, j, n;
+
+    out->nrecords = out->nerrors = 0;
+    if (n_records <= 0) return (0);
+    if (blksize < MIN_RECLEN) return (MS_ERROR);
+    if (soa_reserve (out, n_records) != 0) {
+	fprintf (stderr, "Error: unable to malloc arrays in ms_decode_headers_soa\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    if (my_wordorder < 0) get_my_wordorder();
+    for (i=0; i<SOA_SNCL_CACHE; i++) cid[i] = MS_SNCL_NONE;
+    ys.second = ys.usec = 0;
+
+    for (n=0, i=0; i<n_records; i++) {
+	rec = buf + (int64_t)i * blksize;
+	sh = (SDR_HDR *)rec;
+	if (is_vol_hdr_ind (sh->data_hdr_ind)) continue;
+	if (! is_data_hdr_ind (sh->data_hdr_ind) ||
+	    (wo = scan_wordorder ((unsigned char *)&sh->time)) < 0) {
+	    out->nerrors++;
+	    continue;
+	}
+	swapflag = (wo != my_wordorder);
+
+	/* Walk the blockettes within the record.			*/
+	data_type = UNKNOWN_DATATYPE;
+	tq = -1;
+	usec99 = 0;
+	rate = 0.;
+	nblockettes = (unsigned char)sh->num_blockettes;
+	off = (nblockettes > 0) ? 
+	    get_u16 ((char *)&sh->first_blockette, swapflag) : 0;
+	for (j=0; j<nblockettes && off >= FIXED_DATA_HDR_SIZE; j++) {
+	    if (off + 8 > blksize) break;
+	    pb = rec + off;
+	    type = get_u16 (pb, swapflag);
+	    next = get_u16 (pb+2, swapflag);
+	    switch (type) {
+	      case 1000:
+		data_type = pb[4];
+		break;
+	      case 1001:
+		tq = (unsigned char)pb[4];
+		usec99 = (signed char)pb[5];
+		break;
+	      case 100:
+		memcpy ((void *)&actual_rate, pb+4, sizeof(actual_rate));
+		if (swapflag) swab4 ((int *)&actual_rate);
+		rate = actual_rate;
+		break;
+	      default:
+		break;
+	    }
+	    if (next <= off) break;
+	    off = next;
+	}
+
+	/* Find the channel id, first in the cache of raw names.	*/
+	pb = (char *)sh->station_id;
+	for (h=2166136261u, j=0; j<SOA_SNCL_LEN; j++) 
+	    h = (h ^ (unsigned char)pb[j]) * 16777619u;
+	h %= SOA_SNCL_CACHE;
+	if (cid[h] >= 0 && memcmp (ckey[h], pb, SOA_SNCL_LEN) == 0) id = cid[h];
+	else {
+	    trim (charncpy (station, sh->station_id, DH_STATION_LEN));
+	    trim (charncpy (location, sh->location_id, DH_LOCATION_LEN));
+	    trim (charncpy (channel, sh->channel_id, DH_CHANNEL_LEN));
+	    trim (charncpy (network, sh->network_id, DH_NETWORK_LEN));
+	    if ((id = ms_sncl_id (network, station, location, channel)) < 0) {
+		fprintf (stderr, "Error: unable to malloc SNCL in ms_decode_headers_soa\n");
+		fflush (stderr);
+		if (QLIB2_CLASSIC) exit(1);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	    memcpy (ckey[h], pb, SOA_SNCL_LEN);
+	    cid[h] = id;
+	}
+
+	/* Compute the begtime as decode_hdr_sdr does, and convert it	*/
+	/* to true epoch usecs from the start of its year.		*/
+	t = decode_time_sdr (sh->time, wo);
+	if (usec99) t = add_time (t, 0, usec99);
+	corr = get_i32 ((char *)&sh->num_ticks_correction, swapflag);
+	if (corr != 0 && (sh->activity_flags & ACTIVITY_TIME_CORR_APPLIED) == 0)
+	    t = add_dtime (t, (double)corr * USECS_PER_TICK);
+	if (t.year != year) {
+	    year = ys.year = t.year;
+	    ystart = (int64_t)int_to_tepoch (ys) * USECS_PER_SEC;
+	}
+
+	if (rate == 0.) 
+	    rate = sps_rate (get_i16 ((char *)&sh->sample_rate_factor, 
+				      swapflag),
+			     get_i16 ((char *)&sh->sample_rate_mult, swapflag));
+	out->begtime[n] = ystart + (int64_t)t.second * USECS_PER_SEC + t.usec;
+	out->nsamples[n] = get_u16 ((char *)&sh->num_samples, swapflag);
+	out->rate[n] = rate;
+	out->sncl_id[n] = id;
+	out->data_type[n] = (signed char)data_type;
+	out->timing_quality[n] = (signed char)tq;
+	out->offset[n] = (int64_t)i * blksize;
+	n++;
+    }
+    out->nrecords = n;
+    return (n);
+}
@@ -0,0 +1,151 @@
+/************************************************************************/
+/*  Header-only scanning of MiniSEED records.				*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_scan_h
+#define	__ms_scan_h
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "timedef.h"
+#include "data_hdr.h"
+
+/*	Summary of a MiniSEED record, from its header and blockettes.	*/
+
+typedef struct _ms_summary {
+    char	station_id[DH_STATION_LEN+1];	/* station name		*/
+    char	location_id[DH_LOCATION_LEN+1];	/* location id		*/
+    char	channel_id[DH_CHANNEL_LEN+1];	/* channel name		*/
+    char	network_id[DH_NETWORK_LEN+1];	/* network id		*/
+    char	record_type;	/* record type indicator.		*/
+    int		seq_no;		/* sequence number.			*/
+    INT_TIME	begtime;	/* time of first sample (corrected).	*/
+    INT_TIME	endtime;	/* time of last sample.			*/
+    int		num_samples;	/* # of samples in record.		*/
+    int		sample_rate;	/* nominal rate in qlib convention.	*/
+    int		sample_rate_mult;/* rate_mult in qlib convention.	*/
+    double	rate_spsec;	/* actual rate from blockette 100,	*/
+				/* or 0 if none.			*/
+    int		data_type;	/* data format from blockette 1000.	*/
+    int		hdr_wordorder;	/* wordorder of header.			*/
+    int		data_wordorder;	/* wordorder of data.			*/
+    int		blksize;	/* record size in bytes.		*/
+    int		first_data;	/* offset of data in record.		*/
+    int64_t	offset;		/* byte offset of record in input,	*/
+				/* or -1 if unknown.			*/
+} MS_SUMMARY;
+
+/*	Headers of many records, decoded into parallel arrays.		*/
+
+typedef struct _ms_hdr_soa {
+    int		nrecords;	/* # of records decoded.		*/
+    int		maxrecords;	/* # of records allocated.		*/
+    int		nerrors;	/* # of invalid records skipped.	*/
+    int64_t	*begtime;	/* time of first sample (corrected),	*/
+				/* in usecs from the true epoch.	*/
+    int		*nsamples;	/* # of samples in record.		*/
+    double	*rate;		/* samples per second, from blockette	*/
+				/* 100 if present.			*/
+    int		*sncl_id;	/* SNCL id of channel.			*/
+    signed char	*data_type;	/* data format from blockette 1000.	*/
+    signed char	*timing_quality;/* timing quality from blockette 1001,	*/
+				/* or -1 if none.			*/
+    int64_t	*offset;	/* byte offset of record in buffer.	*/
+} MS_HDR_SOA;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_parse_summary
+   (char	*rec,		/* ptr to start of MiniSEED record.	*/
+    int		nbytes,		/* # of bytes of record available.	*/
+    MS_SUMMARY	*s);		/* summary of record (returned).	*/
+
+extern int ms_record_length
+   (char	*rec,		/* ptr to start of MiniSEED record.	*/
+    int		nbytes);	/* # of bytes of record available.	*/
+
+extern int ms_scan_record
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    MS_SUMMARY	*s);		/* summary of record (returned).	*/
+
+extern int ms_scan_buf
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int64_t	*offset,	/* offset of next record (updated).	*/
+    MS_SUMMARY	*s);		/* summary of record (returned).	*/
+
+extern int ms_scan_file
+   (char	*filename,	/* name of MiniSEED file.		*/
+    MS_SUMMARY	**psum);	/* array of summaries (returned).	*/
+
+extern int64_t ms_resync_buf
+   (char	*buf,		/* buffer to search.			*/
+    int64_t	nbytes,		/* # of bytes in buffer.		*/
+    int64_t	offset,		/* offset at which to start search.	*/
+    int		*pincomplete);	/* set if candidate is incomplete.	*/
+
+extern int64_t ms_resync
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    int64_t	offset);	/* offset of the bad record.		*/
+
+extern int64_t ms_seek_time
+   (FILE	*fp,		/* FILE pointer for input file.		*/
+    INT_TIME	t);		/* time to find.			*/
+
+extern int64_t ms_seek_time_fd
+   (int		fd,		/* file descriptor for input file.	*/
+    INT_TIME	t);		/* time to find.			*/
+
+extern void ms_hdr_soa_init
+   (MS_HDR_SOA	*out);		/* ptr to MS_HDR_SOA.			*/
+
+extern void ms_hdr_soa_free
+   (MS_HDR_SOA	*out);		/* ptr to MS_HDR_SOA.			*/
+
+extern int ms_decode_headers_soa
+   (char	*buf,		/* buffer containing MiniSEED records.	*/
+    int		n_records,	/* # of records in buffer.		*/
+    int		blksize,	/* size of each record in bytes.	*/
+    MS_HDR_SOA	*out);		/* decoded headers (returned).		*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,276 @@
+/************************************************************************/
+/*  Routines for interning SNCL channel names as integer ids.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * The SNCL table assigns dense integer ids, starting at 0, to channel
+ * names in order of first use, so that channels can be grouped and
+ * compared as integers and used to index arrays.  The table is shared
+ * by all threads until it is released by ms_sncl_free.  Forward lookups
+ * use an open addressing hash table under a read-write lock, so that
+ * lookups of known names by many threads do not serialize, and only the
+ * first use of a name takes the write lock.  Names are kept in fixed
+ * blocks that never move, so the reverse lookup of an id does not lock.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "qdefines.h"
+#include "data_hdr.h"
+#include "ms_sncl.h"
+
+#define	SNCL_BLOCKLEN	1024	/* # of names per block.		*/
+#define	SNCL_MAXBLOCKS	16384	/* max # of blocks.			*/
+#define	SNCL_HASHSIZE	1024	/* initial # of hash table entries.	*/
+
+static pthread_rwlock_t sncl_lock = PTHREAD_RWLOCK_INITIALIZER;
+static MS_SNCL	*sncl_block[SNCL_MAXBLOCKS];	/* names by id.		*/
+static int	sncl_count;			/* # of ids assigned.	*/
+static int	*sncl_hash;			/* ids by hash, or -1.	*/
+static int	sncl_hashsize;			/* # of hash entries.	*/
+
+#define	SNCL_NAME(id)	(&sncl_block[(id)/SNCL_BLOCKLEN][(id)%SNCL_BLOCKLEN])
+
+/************************************************************************/
+/*  sncl_key:								*/
+/*	Build the NUL padded MS_SNCL of a channel name.			*/
+/************************************************************************/
+static void sncl_key
+   (MS_SNCL	*k,		/* ptr to MS_SNCL (returned).		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    memset ((char *)k, 0, sizeof(MS_SNCL));
+    strncpy (k->network_id, network, DH_NETWORK_LEN);
+    strncpy (k->station_id, station, DH_STATION_LEN);
+    strncpy (k->location_id, location, DH_LOCATION_LEN);
+    strncpy (k->channel_id, channel, DH_CHANNEL_LEN);
+}
+
+/************************************************************************/
+/*  sncl_hashval:							*/
+/*	Compute the FNV-1a hash of an MS_SNCL.				*/
+/************************************************************************/
+static unsigned int sncl_hashval
+   (MS_SNCL	*k)		/* ptr to MS_SNCL.			*/
+{
+    unsigned char *p = (unsigned char *)k;
+    unsigned int h = 2166136261u;
+    int		i;
+
+    for (i=0; i<(int)sizeof(MS_SNCL); i++) h = (h ^ p[i]) * 16777619u;
+    return (h);
+}
+
+/************************************************************************/
+/*  sncl_slot:								*/
+/*	Find the hash table slot of an MS_SNCL.  Must be called with	*/
+/*	sncl_lock held for reading or writing.				*/
+/*  return:	index of the slot holding its id, or of an empty slot.	*/
+/************************************************************************/
+static int sncl_slot
+   (MS_SNCL	*k)		/* ptr to MS_SNCL.			*/
+{
+    int		i, id;
+
+    i = sncl_hashval (k) & (sncl_hashsize - 1);
+    while ((id = sncl_hash[i]) >= 0 && 
+	   memcmp ((char *)SNCL_NAME(id), (char *)k, sizeof(MS_SNCL)) != 0)
+	i = (i + 1) & (sncl_hashsize - 1);
+    return (i);
+}
+
+/************************************************************************/
+/*  sncl_grow:								*/
+/*	Double the size of the hash table.  Must be called with		*/
+/*	sncl_lock held for writing.					*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int sncl_grow (void)
+{
+    int		*old = sncl_hash;
+    int		oldsize = sncl_hashsize;
+    int		i;
+
+    sncl_hashsize = (oldsize > 0) ? 2 * oldsize : SNCL_HASHSIZE;
+    if ((sncl_hash = (int *)malloc (sncl_hashsize * sizeof(int))) == NULL) {
+	sncl_hash = old;
+	sncl_hashsize = oldsize;
+	return (QLIB2_MALLOC_ERROR);
+    }
+    for (i=0; i<sncl_hashsize; i++) sncl_hash[i] = -1;
+    for (i=0; i<sncl_count; i++) sncl_hash[sncl_slot (SNCL_NAME(i))] = i;
+    if (old) free ((char *)old);
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_sncl_id:								*/
+/*	Return the id of a channel name, assigning the next id if the	*/
+/*	name has not been seen before.  Names are truncated to the	*/
+/*	width of the SEED header fields.				*/
+/*  return:	id on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+int ms_sncl_id
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    MS_SNCL	k;
+    int		i, id = -1;
+
+    sncl_key (&k, network, station, location, channel);
+
+    /* Most names have been seen before, and need only a read lock.	*/
+    pthread_rwlock_rdlock (&sncl_lock);
+    if (sncl_hashsize > 0) id = sncl_hash[sncl_slot (&k)];
+    pthread_rwlock_unlock (&sncl_lock);
+    if (id >= 0) return (id);
+
+    /* Look again with the write lock, since another thread may have	*/
+    /* added the name.  Keep the hash table at most half full, and	*/
+    /* grow it before inserting so that sncl_slot always finds an	*/
+    /* empty slot.							*/
+    pthread_rwlock_wrlock (&sncl_lock);
+    if (sncl_hashsize == 0 && sncl_grow () < 0) {
+	pthread_rwlock_unlock (&sncl_lock);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    i = sncl_slot (&k);
+    if ((id = sncl_hash[i]) < 0) {
+	if (2 * (sncl_count + 1) > sncl_hashsize) {
+	    if (sncl_grow () < 0) {
+		pthread_rwlock_unlock (&sncl_lock);
+		return (QLIB2_MALLOC_ERROR);
+	    }
+	    i = sncl_slot (&k);
+	}
+	id = sncl_count;
+	if (id >= SNCL_BLOCKLEN * SNCL_MAXBLOCKS ||
+	    (id % SNCL_BLOCKLEN == 0 && 
+	     (sncl_block[id/SNCL_BLOCKLEN] = (MS_SNCL *)malloc 
+		(SNCL_BLOCKLEN * sizeof(MS_SNCL))) == NULL)) {
+	    pthread_rwlock_unlock (&sncl_lock);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	*SNCL_NAME(id) = k;
+	sncl_hash[i] = id;
+	++sncl_count;
+    }
+    pthread_rwlock_unlock (&sncl_lock);
+    return (id);
+}
+
+/************************************************************************/
+/*  ms_sncl_find:							*/
+/*	Return the id of a channel name, without assigning one.		*/
+/*  return:	id, or MS_SNCL_NONE if the name has no id.		*/
+/************************************************************************/
+int ms_sncl_find
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    MS_SNCL	k;
+    int		id = MS_SNCL_NONE;
+
+    sncl_key (&k, network, station, location, channel);
+    pthread_rwlock_rdlock (&sncl_lock);
+    if (sncl_hashsize > 0) id = sncl_hash[sncl_slot (&k)];
+    pthread_rwlock_unlock (&sncl_lock);
+    return ((id >= 0) ? id : MS_SNCL_NONE);
+}
+
+/************************************************************************/
+/*  ms_sncl_name:							*/
+/*	Return the channel name of an id.  The id must have been	*/
+/*	returned by ms_sncl_id.						*/
+/*  return:	ptr to MS_SNCL, or NULL if the id is invalid.		*/
+/************************************************************************/
+MS_SNCL *ms_sncl_name
+   (int		id)		/* SNCL id.				*/
+{
+    MS_SNCL	*b;
+
+    if (id < 0 || id >= SNCL_BLOCKLEN * SNCL_MAXBLOCKS) return (NULL);
+    if ((b = sncl_block[id/SNCL_BLOCKLEN]) == NULL) return (NULL);
+    return (&b[id%SNCL_BLOCKLEN]);
+}
+
+/************************************************************************/
+/*  ms_sncl_count:							*/
+/*	Return the number of ids assigned.  Valid ids are 0 through	*/
+/*	ms_sncl_count() - 1.						*/
+/************************************************************************/
+int ms_sncl_count (void)
+{
+    int		n;
+
+    pthread_rwlock_rdlock (&sncl_lock);
+    n = sncl_count;
+    pthread_rwlock_unlock (&sncl_lock);
+    return (n);
+}
+
+/************************************************************************/
+/*  ms_sncl_free:							*/
+/*	Release the SNCL table.  All ids and MS_SNCL pointers become	*/
+/*	invalid, and ids are assigned from 0 again.  Must not be called	*/
+/*	while other threads use the table, or while any structure that	*/
+/*	holds ids, such as an MS_DEMUX or MS_TRACE_LIST, is in use.	*/
+/************************************************************************/
+void ms_sncl_free (void)
+{
+    int		i;
+
+    pthread_rwlock_wrlock (&sncl_lock);
+    for (i=0; i<SNCL_MAXBLOCKS && sncl_block[i]; i++) {
+	free ((char *)sncl_block[i]);
+	sncl_block[i] = NULL;
+    }
+    if (sncl_hash) free ((char *)sncl_hash);
+    sncl_hash = NULL;
+    sncl_hashsize = 0;
+    sncl_count = 0;
+    pthread_rwlock_unlock (&sncl_lock);
+}
@@ -0,0 +1,83 @@
+/************************************************************************/
+/*  Routines for interning SNCL channel names as integer ids.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_sncl_h
+#define	__ms_sncl_h
+
+#include "data_hdr.h"
+
+#define	MS_SNCL_NONE	(-1)	/* id of a header without an SNCL.	*/
+
+/*	Channel name of an interned SNCL id.  The names are NUL padded	*/
+/*	to the full width of each field.				*/
+
+typedef struct _ms_sncl {
+    char	network_id[DH_NETWORK_LEN+1];	/* network id.		*/
+    char	station_id[DH_STATION_LEN+1];	/* station name.	*/
+    char	location_id[DH_LOCATION_LEN+1];	/* location id.		*/
+    char	channel_id[DH_CHANNEL_LEN+1];	/* channel name.	*/
+} MS_SNCL;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_sncl_id
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel);	/* channel name.			*/
+
+extern int ms_sncl_find
+   (char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel);	/* channel name.			*/
+
+extern MS_SNCL *ms_sncl_name
+   (int		id);		/* SNCL id.				*/
+
+extern int ms_sncl_count (void);
+
+extern void ms_sncl_free (void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
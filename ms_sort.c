@@ -0,0 +1,633 @@
+/************************************************************************/
+/*  Routines for sorting and deduplicating MiniSEED records.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * ms_sort_files orders the records of a set of MiniSEED files by
+ * channel, begtime and sequence number, and drops exact duplicates,
+ * using a bounded amount of memory.  Records are read into an arena
+ * until the memory limit is reached, and the sorted arena is spilled
+ * to a temporary run file.  The runs are then merged with a heap, up
+ * to SORT_MAXMERGE runs at a time.  Records are never decoded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_scan.h"
+#include "ms_reader.h"
+#include "ms_sort.h"
+
+#define	SORT_MAXMEM	((int64_t)64<<20) /* default memory limit.	*/
+#define	SORT_MINMEM	((int64_t)1<<20)  /* minimum memory limit.	*/
+#define	SORT_MAXMERGE	64	/* max # of runs merged at once.	*/
+#define	SORT_INCREMENT	4096	/* # of keys to allocate at a time.	*/
+#define	SORT_ARENA_INIT	((int64_t)1<<20)  /* initial size of arena.	*/
+#define	SORT_IOBUF	(1<<20)	/* max size of run file buffer.		*/
+#define	SORT_MINIOBUF	(1<<16)	/* min size of run file buffer.		*/
+
+/*	Sort key of a record.						*/
+typedef struct _sort_key {
+    char	sncl[12];	/* network, station, location and	*/
+				/* channel, NUL padded.			*/
+    INT_TIME	begtime;	/* time of first sample.		*/
+    int		seq_no;		/* sequence number.			*/
+    int		blksize;	/* record size in bytes.		*/
+    int		first_data;	/* offset of data in record.		*/
+    int64_t	pos;		/* offset of record in arena.		*/
+} SORT_KEY;
+
+/*	Data sections of the records written with the current channel	*/
+/*	and begtime, for duplicate detection.				*/
+typedef struct _sort_group {
+    SORT_KEY	key;		/* key of the group.			*/
+    int		n;		/* # of records in the group.		*/
+    int		max;		/* # of slots allocated.		*/
+    char	**data;		/* copies of data sections.		*/
+    int		*len;		/* length of each data section.		*/
+    int		*cap;		/* allocated size of each copy.		*/
+} SORT_GROUP;
+
+/*	A run file being merged.					*/
+typedef struct _merge_src {
+    FILE	*fp;		/* FILE pointer for run.		*/
+    SORT_KEY	key;		/* key of current record.		*/
+    char	*rec;		/* current record.			*/
+    int		reclen;		/* allocated size of rec.		*/
+    int		index;		/* index of run, to order ties.		*/
+} MERGE_SRC;
+
+/*	State of a sort.						*/
+typedef struct _sort_state {
+    int64_t	maxmem;		/* memory limit.			*/
+    char	*tmpdir;	/* directory for run files.		*/
+    char	*arena;		/* records of the current chunk.	*/
+    int64_t	arenalen;	/* allocated size of arena.		*/
+    int64_t	used;		/* # of bytes used in arena.		*/
+    SORT_KEY	*key;		/* keys of the current chunk.		*/
+    int		nkeys;		/* # of keys.				*/
+    int		maxkeys;	/* # of keys allocated.			*/
+    int		*run;		/* file descriptors of run files.	*/
+    int		nruns;		/* # of run files.			*/
+    int		maxruns;	/* # of run files allocated.		*/
+    SORT_GROUP	group;		/* duplicate detection group.		*/
+    MS_SORT_STATS *stats;	/* statistics.				*/
+} SORT_STATE;
+
+/************************************************************************/
+/*  time_cmp:								*/
+/*	Compare two INT_TIMEs.						*/
+/*  return:	<0, 0, >0 if a is before, equal to, or after b.		*/
+/************************************************************************/
+static int time_cmp
+   (INT_TIME	a,		/* first time.				*/
+    INT_TIME	b)		/* second time.				*/
+{
+    if (a.year != b.year) return ((a.year < b.year) ? -1 : 1);
+    if (a.second != b.second) return ((a.second < b.second) ? -1 : 1);
+    if (a.usec != b.usec) return ((a.usec < b.usec) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  key_cmp:								*/
+/*	Compare records by channel, begtime and sequence number.	*/
+/************************************************************************/
+static int key_cmp
+   (SORT_KEY	*a,		/* ptr to first key.			*/
+    SORT_KEY	*b)		/* ptr to second key.			*/
+{
+    int c;
+
+    if ((c = memcmp (a->sncl, b->sncl, sizeof(a->sncl))) != 0) return (c);
+    if ((c = time_cmp (a->begtime, b->begtime)) != 0) return (c);
+    if (a->seq_no != b->seq_no) return ((a->seq_no < b->seq_no) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  arena_cmp:								*/
+/*	Compare records of the arena by key, then by input order.	*/
+/************************************************************************/
+static int arena_cmp
+   (const void	*pa,		/* ptr to first SORT_KEY.		*/
+    const void	*pb)		/* ptr to second SORT_KEY.		*/
+{
+    SORT_KEY *a = (SORT_KEY *)pa;
+    SORT_KEY *b = (SORT_KEY *)pb;
+    int c;
+
+    if ((c = key_cmp (a, b)) != 0) return (c);
+    return ((a->pos < b->pos) ? -1 : (a->pos > b->pos));
+}
+
+/************************************************************************/
+/*  make_key:								*/
+/*	Build the sort key of a record from its summary.		*/
+/************************************************************************/
+static void make_key
+   (SORT_KEY	*k,		/* ptr to key (returned).		*/
+    MS_SUMMARY	*s)		/* ptr to record summary.		*/
+{
+    memset ((char *)k, 0, sizeof(SORT_KEY));
+    strncpy (k->sncl, s->network_id, DH_NETWORK_LEN);
+    strncpy (k->sncl+2, s->station_id, DH_STATION_LEN);
+    strncpy (k->sncl+7, s->location_id, DH_LOCATION_LEN);
+    strncpy (k->sncl+9, s->channel_id, DH_CHANNEL_LEN);
+    k->begtime = s->begtime;
+    k->seq_no = s->seq_no;
+    k->blksize = s->blksize;
+    k->first_data = (s->first_data > 0 && s->first_data < s->blksize) ? 
+		    s->first_data : s->blksize;
+}
+
+/************************************************************************/
+/*  is_duplicate:							*/
+/*	Determine whether a record has the same channel, begtime and	*/
+/*	data section as a record already written.  Records must be	*/
+/*	presented in key order.  A record that is not a duplicate is	*/
+/*	added to the group.						*/
+/*  return:	1 if duplicate, 0 if not, QLIB2_MALLOC_ERROR on error.	*/
+/************************************************************************/
+static int is_duplicate
+   (SORT_GROUP	*g,		/* ptr to duplicate detection group.	*/
+    SORT_KEY	*k,		/* ptr to key of record.		*/
+    char	*rec)		/* ptr to record.			*/
+{
+    char	*data = rec + k->first_data;
+    int		len = k->blksize - k->first_data;
+    int		i;
+    void	*p;
+
+    if (g->n > 0 && (memcmp (g->key.sncl, k->sncl, sizeof(k->sncl)) != 0 ||
+		     time_cmp (g->key.begtime, k->begtime) != 0)) g->n = 0;
+    for (i=0; i<g->n; i++) {
+	if (g->len[i] == len && memcmp (g->data[i], data, len) == 0) return (1);
+    }
+    if (g->n == g->max) {
+	if ((p = realloc (g->data, (g->max + 4) * sizeof(char *))) == NULL)
+	    return (QLIB2_MALLOC_ERROR);
+	g->data = (char **)p;
+	if ((p = realloc (g->len, (g->max + 4) * sizeof(int))) == NULL)
+	    return (QLIB2_MALLOC_ERROR);
+	g->len = (int *)p;
+	if ((p = realloc (g->cap, (g->max + 4) * sizeof(int))) == NULL)
+	    return (QLIB2_MALLOC_ERROR);
+	g->cap = (int *)p;
+	for (i=g->max; i<g->max+4; i++) {
+	    g->data[i] = NULL;
+	    g->cap[i] = 0;
+	}
+	g->max += 4;
+    }
+    if (g->cap[g->n] < len) {
+	if ((p = realloc (g->data[g->n], len)) == NULL) return (QLIB2_MALLOC_ERROR);
+	g->data[g->n] = (char *)p;
+	g->cap[g->n] = len;
+    }
+    memcpy (g->data[g->n], data, len);
+    g->len[g->n++] = len;
+    g->key = *k;
+    return (0);
+}
+
+/************************************************************************/
+/*  emit:								*/
+/*	Write a record with its key to a run file, or the record alone	*/
+/*	to the output, unless it is a duplicate.			*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int emit
+   (SORT_STATE	*ss,		/* ptr to sort state.			*/
+    FILE	*fp,		/* FILE pointer for run or output.	*/
+    int		with_key,	/* 1 to write the key.			*/
+    SORT_KEY	*k,		/* ptr to key of record.		*/
+    char	*rec)		/* ptr to record.			*/
+{
+    int		status;
+
+    if ((status = is_duplicate (&ss->group, k, rec)) < 0) return (status);
+    if (status) {
+	ss->stats->nduplicates++;
+	return (0);
+    }
+    if (with_key && fwrite ((char *)k, sizeof(SORT_KEY), 1, fp) != 1) 
+	return (MS_ERROR);
+    if (fwrite (rec, k->blksize, 1, fp) != 1) return (MS_ERROR);
+    if (! with_key) ss->stats->nwritten++;
+    return (0);
+}
+
+/************************************************************************/
+/*  run_create:								*/
+/*	Create an unlinked temporary run file, and append it to the	*/
+/*	list of runs.							*/
+/*  return:	file descriptor, or negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int run_create
+   (SORT_STATE	*ss)		/* ptr to sort state.			*/
+{
+    char	*path;
+    int		fd;
+    void	*p;
+
+    if (ss->nruns == ss->maxruns) {
+	if ((p = realloc (ss->run, (ss->maxruns + SORT_MAXMERGE) * sizeof(int))) == NULL)
+	    return (QLIB2_MALLOC_ERROR);
+	ss->run = (int *)p;
+	ss->maxruns += SORT_MAXMERGE;
+    }
+    if ((path = (char *)malloc (strlen(ss->tmpdir) + 32)) == NULL) 
+	return (QLIB2_MALLOC_ERROR);
+    sprintf (path, "%s/ms_sort.XXXXXX", ss->tmpdir);
+    if ((fd = mkstemp (path)) < 0) {
+	fprintf (stderr, "Error: unable to create %s in ms_sort_files\n", path);
+	fflush (stderr);
+	free (path);
+	return (MS_ERROR);
+    }
+    unlink (path);
+    free (path);
+    ss->run[ss->nruns++] = fd;
+    ss->stats->nruns++;
+    return (fd);
+}
+
+/************************************************************************/
+/*  run_open:								*/
+/*	Open a stdio stream on a duplicate of a run file descriptor,	*/
+/*	with a buffer of the specified size.				*/
+/*  return:	FILE pointer, or NULL on error.				*/
+/************************************************************************/
+static FILE *run_open
+   (int		fd,		/* run file descriptor.			*/
+    char	*mode,		/* fopen mode.				*/
+    int		bufsize)	/* size of stdio buffer.		*/
+{
+    FILE	*fp;
+    int		fd2;
+
+    if ((fd2 = dup (fd)) < 0) return (NULL);
+    if ((fp = fdopen (fd2, mode)) == NULL) {
+	close (fd2);
+	return (NULL);
+    }
+    setvbuf (fp, NULL, _IOFBF, bufsize);
+    return (fp);
+}
+
+/************************************************************************/
+/*  flush_chunk:							*/
+/*	Sort the records in the arena, and write them to the output,	*/
+/*	or to a new run file.						*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int flush_chunk
+   (SORT_STATE	*ss,		/* ptr to sort state.			*/
+    FILE	*out)		/* output FILE, or NULL for a run.	*/
+{
+    FILE	*fp = out;
+    int		status = 0, fd, i;
+
+    qsort ((char *)ss->key, ss->nkeys, sizeof(SORT_KEY), arena_cmp);
+    if (out == NULL) {
+	if ((fd = run_create (ss)) < 0) return (fd);
+	if ((fp = run_open (fd, "w", SORT_IOBUF)) == NULL) return (MS_ERROR);
+    }
+    ss->group.n = 0;
+    for (i=0; status == 0 && i<ss->nkeys; i++) 
+	status = emit (ss, fp, (out == NULL), &ss->key[i], ss->arena + ss->key[i].pos);
+    if (out == NULL && fclose (fp) != 0 && status == 0) status = MS_ERROR;
+    ss->nkeys = 0;
+    ss->used = 0;
+    return (status);
+}
+
+/************************************************************************/
+/*  add_record:								*/
+/*	Add a record to the arena, first spilling the arena to a run	*/
+/*	file if the memory limit would be exceeded.			*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int add_record
+   (SORT_STATE	*ss,		/* ptr to sort state.			*/
+    char	*rec,		/* ptr to record.			*/
+    int		blksize)	/* size of record.			*/
+{
+    MS_SUMMARY	s;
+    SORT_KEY	*k;
+    int64_t	len;
+    int		status, n;
+    void	*p;
+
+    if (ms_parse_summary (rec, blksize, &s) < 0) return (MS_ERROR);
+    if (ss->nkeys > 0 && ss->used + blksize + 
+	(int64_t)(ss->nkeys + 1) * (int64_t)sizeof(SORT_KEY) > ss->maxmem &&
+	(status = flush_chunk (ss, NULL)) < 0) return (status);
+    if (ss->used + blksize > ss->arenalen) {
+	/* Grow the arena geometrically, up to the memory limit.	*/
+	len = (ss->arenalen > 0) ? 2 * ss->arenalen : SORT_ARENA_INIT;
+	if (len > ss->maxmem) len = ss->maxmem;
+	if (len < ss->used + blksize) len = ss->used + blksize;
+	if ((p = realloc (ss->arena, len)) == NULL) 
+	    return (QLIB2_MALLOC_ERROR);
+	ss->arena = (char *)p;
+	ss->arenalen = len;
+    }
+    if (ss->nkeys == ss->maxkeys) {
+	n = (ss->maxkeys > 0) ? 2 * ss->maxkeys : SORT_INCREMENT;
+	if ((p = realloc (ss->key, n * sizeof(SORT_KEY))) == NULL) 
+	    return (QLIB2_MALLOC_ERROR);
+	ss->key = (SORT_KEY *)p;
+	ss->maxkeys = n;
+    }
+    k = &ss->key[ss->nkeys++];
+    make_key (k, &s);
+    k->pos = ss->used;
+    memcpy (ss->arena + ss->used, rec, blksize);
+    ss->used += blksize;
+    return (0);
+}
+
+/************************************************************************/
+/*  src_next:								*/
+/*	Read the next record of a run file.				*/
+/*  return:	1 on success, 0 at end of run, negative on error.	*/
+/************************************************************************/
+static int src_next
+   (MERGE_SRC	*src)		/* ptr to run being merged.		*/
+{
+    void	*p;
+
+    if (fread ((char *)&src->key, sizeof(SORT_KEY), 1, src->fp) != 1) 
+	return (ferror (src->fp) ? MS_ERROR : 0);
+    if (src->key.blksize > src->reclen) {
+	if ((p = realloc (src->rec, src->key.blksize)) == NULL) 
+	    return (QLIB2_MALLOC_ERROR);
+	src->rec = (char *)p;
+	src->reclen = src->key.blksize;
+    }
+    if (fread (src->rec, src->key.blksize, 1, src->fp) != 1) return (MS_ERROR);
+    return (1);
+}
+
+/************************************************************************/
+/*  src_less:								*/
+/*	Determine whether the current record of run a sorts before	*/
+/*	that of run b.							*/
+/************************************************************************/
+static int src_less
+   (MERGE_SRC	*a,		/* ptr to first run.			*/
+    MERGE_SRC	*b)		/* ptr to second run.			*/
+{
+    int c = key_cmp (&a->key, &b->key);
+    return (c < 0 || (c == 0 && a->index < b->index));
+}
+
+/************************************************************************/
+/*  merge_runs:								*/
+/*	Merge the first n run files into the output, or into a new run	*/
+/*	file, and remove them from the list of runs.			*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int merge_runs
+   (SORT_STATE	*ss,		/* ptr to sort state.			*/
+    int		n,		/* # of runs to merge.			*/
+    FILE	*out)		/* output FILE, or NULL for a run.	*/
+{
+    MERGE_SRC	*src, **heap, *t;
+    FILE	*fp = out;
+    int		bufsize, nh = 0, status = 0, fd, i, j, c;
+
+    bufsize = (int)((ss->maxmem / (n + 1) < SORT_IOBUF) ? 
+		    ss->maxmem / (n + 1) : SORT_IOBUF);
+    if (bufsize < SORT_MINIOBUF) bufsize = SORT_MINIOBUF;
+    if ((src = (MERGE_SRC *)calloc (n, sizeof(MERGE_SRC))) == NULL) 
+	return (QLIB2_MALLOC_ERROR);
+    if ((heap = (MERGE_SRC **)calloc (n, sizeof(MERGE_SRC *))) == NULL) {
+	free ((char *)src);
+	return (QLIB2_MALLOC_ERROR);
+    }
+
+    /* Open the runs, and build a heap of their first records.		*/
+    for (i=0; status == 0 && i<n; i++) {
+	src[i].index = i;
+	lseek (ss->run[i], 0, SEEK_SET);
+	if ((src[i].fp = run_open (ss->run[i], "r", bufsize)) == NULL) {
+	    status = MS_ERROR;
+	    break;
+	}
+	if ((c = src_next (&src[i])) <= 0) {
+	    status = c;
+	    continue;
+	}
+	for (j=nh++; j>0 && src_less (&src[i], heap[(j-1)/2]); j=(j-1)/2) 
+	    heap[j] = heap[(j-1)/2];
+	heap[j] = &src[i];
+    }
+    if (status == 0 && out == NULL) {
+	if ((fd = run_create (ss)) < 0) status = fd;
+	else if ((fp = run_open (fd, "w", SORT_IOBUF)) == NULL) status = MS_ERROR;
+    }
+
+    /* Write the smallest record, replace it with the next record of	*/
+    /* its run, and restore the heap.					*/
+    ss->group.n = 0;
+    while (status == 0 && nh > 0) {
+	t = heap[0];
+	if ((status = emit (ss, fp, (out == NULL), &t->key, t->rec)) < 0) break;
+	if ((c = src_next (t)) < 0) {
+	    status = c;
+	    break;
+	}
+	if (c == 0) t = heap[--nh];
+	for (j=0; (i = 2*j+1) < nh; j=i) {
+	    if (i + 1 < nh && src_less (heap[i+1], heap[i])) i++;
+	    if (! src_less (heap[i], t)) break;
+	    heap[j] = heap[i];
+	}
+	if (nh > 0) heap[j] = t;
+    }
+
+    if (out == NULL && fp && fclose (fp) != 0 && status == 0) status = MS_ERROR;
+    for (i=0; i<n; i++) {
+	if (src[i].fp) fclose (src[i].fp);
+	if (src[i].rec) free (src[i].rec);
+	close (ss->run[i]);
+    }
+    memmove ((char *)ss->run, (char *)(ss->run + n), (ss->nruns - n) * sizeof(int));
+    ss->nruns -= n;
+    free ((char *)src);
+    free ((char *)heap);
+    return (status);
+}
+
+/************************************************************************/
+/*  sort_done:								*/
+/*	Free the storage of a sort, and close any remaining runs.	*/
+/************************************************************************/
+static void sort_done
+   (SORT_STATE	*ss)		/* ptr to sort state.			*/
+{
+    int		i;
+
+    for (i=0; i<ss->nruns; i++) close (ss->run[i]);
+    for (i=0; i<ss->group.max; i++) 
+	if (ss->group.data[i]) free (ss->group.data[i]);
+    if (ss->group.data) free ((char *)ss->group.data);
+    if (ss->group.len) free ((char *)ss->group.len);
+    if (ss->group.cap) free ((char *)ss->group.cap);
+    if (ss->run) free ((char *)ss->run);
+    if (ss->arena) free (ss->arena);
+    if (ss->key) free ((char *)ss->key);
+}
+
+/************************************************************************/
+/*  ms_sort_files:							*/
+/*	Sort the records of one or more plain or compressed MiniSEED	*/
+/*	files by network, station, location, channel, begtime and	*/
+/*	sequence number, drop exact duplicates, and write the records	*/
+/*	unchanged to the output file.  A duplicate has the same		*/
+/*	channel and begtime as a record already written, and an		*/
+/*	identical data section.  At most about maxmem bytes of records	*/
+/*	are kept in memory, and larger inputs are spilled to sorted	*/
+/*	run files in tmpdir (default $TMPDIR or /tmp) which are then	*/
+/*	merged.  The output is written to a temporary file which is	*/
+/*	renamed, so the output may replace an input file.  Volume	*/
+/*	headers are dropped.						*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+int ms_sort_files
+   (char	**paths,	/* MiniSEED input files.		*/
+    int		npaths,		/* # of input files.			*/
+    char	*outfile,	/* name of output file.			*/
+    int64_t	maxmem,		/* memory limit in bytes (<= 0 for	*/
+				/* the default).			*/
+    char	*tmpdir,	/* directory for spill files, or NULL.	*/
+    MS_SORT_STATS *stats)	/* statistics (returned), or NULL.	*/
+{
+    SORT_STATE	ss;
+    MS_SORT_STATS st;
+    MS_READER	*r;
+    FILE	*out = NULL;
+    char	*tmpfile = NULL;
+    char	*rec;
+    int		status = 0, i, n;
+
+    memset ((char *)&ss, 0, sizeof(ss));
+    ss.stats = (stats) ? stats : &st;
+    memset ((char *)ss.stats, 0, sizeof(MS_SORT_STATS));
+    ss.maxmem = (maxmem > 0) ? maxmem : SORT_MAXMEM;
+    if (ss.maxmem < SORT_MINMEM) ss.maxmem = SORT_MINMEM;
+    if ((ss.tmpdir = tmpdir) == NULL && (ss.tmpdir = getenv ("TMPDIR")) == NULL)
+	ss.tmpdir = "/tmp";
+
+    /* Read the records, spilling sorted runs as the arena fills.	*/
+    for (i=0; status == 0 && i<npaths; i++) {
+	if ((r = ms_reader_open (paths[i], MS_READER_AUTO)) == NULL) {
+	    status = MS_ERROR;
+	    break;
+	}
+	while ((n = ms_reader_next (r, &rec)) > 0) {
+	    if (is_vol_hdr_ind (rec[6])) {
+		ss.stats->nskipped++;
+		continue;
+	    }
+	    if ((status = add_record (&ss, rec, n)) < 0) break;
+	    ss.stats->nrecords++;
+	}
+	if (status == 0 && n != EOF) status = n;
+	if (status == MS_ERROR) {
+	    fprintf (stderr, "Error: invalid MiniSEED record at offset %lld of %s %s\n",
+		     (long long)((n < 0) ? r->offset : r->rec_offset), paths[i], 
+		     "in ms_sort_files");
+	    fflush (stderr);
+	}
+	ms_reader_close (r);
+    }
+
+    /* Write the last chunk directly if nothing was spilled, else	*/
+    /* spill it and merge the runs.					*/
+    if (status == 0) {
+	if ((tmpfile = (char *)malloc (strlen(outfile) + 5)) == NULL) 
+	    status = QLIB2_MALLOC_ERROR;
+	else {
+	    sprintf (tmpfile, "%s.tmp", outfile);
+	    if ((out = fopen (tmpfile, "w")) == NULL) {
+		fprintf (stderr, "Error: unable to create %s in ms_sort_files\n", tmpfile);
+		fflush (stderr);
+		status = MS_ERROR;
+	    }
+	}
+    }
+    if (status == 0 && ss.nruns == 0) status = flush_chunk (&ss, out);
+    else if (status == 0) {
+	if (ss.nkeys > 0) status = flush_chunk (&ss, NULL);
+	free (ss.arena);
+	ss.arena = NULL;
+	while (status == 0 && ss.nruns > SORT_MAXMERGE) 
+	    status = merge_runs (&ss, SORT_MAXMERGE, NULL);
+	if (status == 0) status = merge_runs (&ss, ss.nruns, out);
+    }
+    if (out) {
+	if (fclose (out) != 0 && status == 0) status = MS_ERROR;
+	if (status == 0 && rename (tmpfile, outfile) != 0) status = MS_ERROR;
+	if (status < 0) {
+	    fprintf (stderr, "Error: unable to write %s in ms_sort_files\n", outfile);
+	    fflush (stderr);
+	    unlink (tmpfile);
+	}
+    }
+    if (tmpfile) free (tmpfile);
+    sort_done (&ss);
+    if (status == QLIB2_MALLOC_ERROR) {
+	fprintf (stderr, "Error: unable to malloc data in ms_sort_files\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+    }
+    return (status);
+}
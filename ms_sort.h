@@ -0,0 +1,71 @@
+/************************************************************************/
+/*  Routines for sorting and deduplicating MiniSEED records.		*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_sort_h
+#define	__ms_sort_h
+
+#include <sys/types.h>
+
+/*	Statistics of a sort.						*/
+
+typedef struct _ms_sort_stats {
+    int64_t	nrecords;	/* # of data records read.		*/
+    int64_t	nwritten;	/* # of records written.		*/
+    int64_t	nduplicates;	/* # of duplicate records dropped.	*/
+    int64_t	nskipped;	/* # of volume headers skipped.		*/
+    int		nruns;		/* # of sorted runs spilled to disk.	*/
+} MS_SORT_STATS;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern int ms_sort_files
+   (char	**paths,	/* MiniSEED input files.		*/
+    int		npaths,		/* # of input files.			*/
+    char	*outfile,	/* name of output file.			*/
+    int64_t	maxmem,		/* memory limit in bytes (<= 0 for	*/
+				/* the default).			*/
+    char	*tmpdir,	/* directory for spill files, or NULL.	*/
+    MS_SORT_STATS *stats);	/* statistics (returned), or NULL.	*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
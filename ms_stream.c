@@ -0,0 +1,281 @@
+/************************************************************************/
+/*  Splitting of MiniSEED byte streams into records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "qutils.h"
+#include "ms_scan.h"
+#include "ms_stream.h"
+
+#define	STREAM_BUFLEN	4096	/* initial size of partial record buf.	*/
+#define	STREAM_PROBE	64	/* # of bytes added when the blksize	*/
+				/* of a partial record is unknown.	*/
+#define	STREAM_MAXLEN	0x7fffffff /* max # of bytes examined at once.	*/
+
+/************************************************************************/
+/*  ms_stream_init:							*/
+/*	Initialize an MS_STREAM to split a byte stream into MiniSEED	*/
+/*	records.							*/
+/************************************************************************/
+void ms_stream_init
+   (MS_STREAM	*st)		/* ptr to MS_STREAM.			*/
+{
+    memset ((char *)st, 0, sizeof(MS_STREAM));
+}
+
+/************************************************************************/
+/*  ms_stream_free:							*/
+/*	Free all storage in an MS_STREAM.				*/
+/************************************************************************/
+void ms_stream_free
+   (MS_STREAM	*st)		/* ptr to MS_STREAM.			*/
+{
+    if (st->buf) free (st->buf);
+    memset ((char *)st, 0, sizeof(MS_STREAM));
+}
+
+/************************************************************************/
+/*  ms_stream_reset:							*/
+/*	Discard any partial record and the rest of the current input,	*/
+/*	for example after an error.  The stream offset is advanced past	*/
+/*	the discarded data.						*/
+/************************************************************************/
+void ms_stream_reset
+   (MS_STREAM	*st)		/* ptr to MS_STREAM.			*/
+{
+    st->offset += (st->nbuf - st->used) + (st->inlen - st->inpos);
+    st->nbuf = st->used = 0;
+    st->inpos = st->inlen;
+}
+
+/************************************************************************/
+/*  stream_append:							*/
+/*	Append data to the partial record buffer.			*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int stream_append
+   (MS_STREAM	*st,		/* ptr to MS_STREAM.			*/
+    char	*data,		/* ptr to data.				*/
+    size_t	len)		/* # of bytes of data.			*/
+{
+    char	*p;
+    size_t	n;
+
+    if (st->nbuf + len > (size_t)st->buflen) {
+	n = (st->buflen > 0) ? st->buflen : STREAM_BUFLEN;
+	while (n < st->nbuf + len) n *= 2;
+	if (n > STREAM_MAXLEN || (p = (char *)realloc (st->buf, n)) == NULL) {
+	    fprintf (stderr, "Error: unable to malloc buffer in ms_stream\n");
+	    fflush (stderr);
+	    if (QLIB2_CLASSIC) exit(1);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	st->buf = p;
+	st->buflen = (int)n;
+    }
+    memcpy (st->buf + st->nbuf, data, len);
+    st->nbuf += (int)len;
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_stream_push:							*/
+/*	Provide the next block of data of the stream, such as the data	*/
+/*	returned by a read from a socket.  The data is not copied, and	*/
+/*	must remain valid until ms_stream_next returns 0 or the next	*/
+/*	call to ms_stream_push.  Any input of the previous block not	*/
+/*	yet split into records is saved first.				*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+int ms_stream_push
+   (MS_STREAM	*st,		/* ptr to MS_STREAM.			*/
+    char	*data,		/* ptr to input data.			*/
+    size_t	len)		/* # of bytes of input data.		*/
+{
+    int		status = 0;
+
+    if (st->used > 0) {
+	memmove (st->buf, st->buf + st->used, st->nbuf - st->used);
+	st->nbuf -= st->used;
+	st->used = 0;
+    }
+    if (st->inpos < st->inlen)
+	status = stream_append (st, st->in + st->inpos, st->inlen - st->inpos);
+    st->in = data;
+    st->inlen = len;
+    st->inpos = 0;
+    return (status);
+}
+
+/************************************************************************/
+/*  ms_stream_next:							*/
+/*	Return the next complete MiniSEED record of the stream.  The	*/
+/*	record length is determined from the blockette 1000.  A record	*/
+/*	that lies entirely within the current input is returned in	*/
+/*	place, without copying.  Only a record that spans input blocks	*/
+/*	is assembled in an internal buffer, which is valid until the	*/
+/*	next call to ms_stream_next or ms_stream_push.  The stream	*/
+/*	offset of the record is returned in st->rec_offset.		*/
+/*	After an error, the caller may call ms_stream_resync to skip	*/
+/*	to the next plausible record, or ms_stream_reset to discard the	*/
+/*	remaining data and continue with the next input.		*/
+/*  return:								*/
+/*	blksize of record on success.					*/
+/*	0 if more input is needed.					*/
+/*	MS_ERROR if the stream is not at a MiniSEED record.		*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int ms_stream_next
+   (MS_STREAM	*st,		/* ptr to MS_STREAM.			*/
+    char	**prec)		/* ptr to record (returned).		*/
+{
+    size_t	avail, want;
+    int		n, status;
+
+    *prec = NULL;
+    if (st->used > 0) {
+	memmove (st->buf, st->buf + st->used, st->nbuf - st->used);
+	st->nbuf -= st->used;
+	st->used = 0;
+    }
+
+    /* Complete a partial record from the current input.  Copy only	*/
+    /* the bytes of this record, so that the following records can be	*/
+    /* returned from the input in place.				*/
+    while (st->nbuf > 0) {
+	if ((n = ms_record_length (st->buf, st->nbuf)) < 0) return (n);
+	if (n > 0 && st->nbuf >= n) {
+	    *prec = st->buf;
+	    st->used = n;
+	    st->rec_offset = st->offset;
+	    st->offset += n;
+	    return (n);
+	}
+	if ((avail = st->inlen - st->inpos) == 0) return (0);
+	want = (n > 0) ? (size_t)(n - st->nbuf) : STREAM_PROBE;
+	if (want > avail) want = avail;
+	if ((status = stream_append (st, st->in + st->inpos, want)) < 0) 
+	    return (status);
+	st->inpos += want;
+    }
+
+    /* Return the next record of the input in place if it is complete.	*/
+    /* Otherwise, save the partial record.				*/
+    if ((avail = st->inlen - st->inpos) == 0) return (0);
+    n = ms_record_length (st->in + st->inpos, 
+			  (avail > STREAM_MAXLEN) ? STREAM_MAXLEN : (int)avail);
+    if (n < 0) return (n);
+    if (n > 0 && avail >= (size_t)n) {
+	*prec = st->in + st->inpos;
+	st->inpos += n;
+	st->rec_offset = st->offset;
+	st->offset += n;
+	return (n);
+    }
+    if ((status = stream_append (st, st->in + st->inpos, avail)) < 0) 
+	return (status);
+    st->inpos = st->inlen;
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_stream_resync:							*/
+/*	Skip to the next plausible MiniSEED record header of the	*/
+/*	stream after ms_stream_next returns MS_ERROR, using		*/
+/*	ms_resync_buf.  At least one byte is skipped.  If no header is	*/
+/*	found in the data so far, only the last few bytes, which may	*/
+/*	begin a header, are kept.  The stream offset is advanced past	*/
+/*	the skipped data.						*/
+/*  return:								*/
+/*	# of bytes skipped on success.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int64_t ms_stream_resync
+   (MS_STREAM	*st)		/* ptr to MS_STREAM.			*/
+{
+    int64_t	k, avail, skip;
+    size_t	inpos;
+    int		nold, incomplete, status;
+
+    if (st->used > 0) {
+	memmove (st->buf, st->buf + st->used, st->nbuf - st->used);
+	st->nbuf -= st->used;
+	st->used = 0;
+    }
+
+    if (st->nbuf > 0) {
+	/* Search the partial record and the rest of the input.  If	*/
+	/* the header is in the input, it is used in place.		*/
+	nold = st->nbuf;
+	inpos = st->inpos;
+	if ((status = stream_append (st, st->in + st->inpos, st->inlen - st->inpos)) < 0)
+	    return (status);
+	st->inpos = st->inlen;
+	k = ms_resync_buf (st->buf, st->nbuf, 1, &incomplete);
+	if (k >= nold) {
+	    st->inpos = inpos + (size_t)(k - nold);
+	    st->nbuf = 0;
+	    st->offset += k;
+	    return (k);
+	}
+	skip = (k >= 0) ? k : ((st->nbuf > 7) ? st->nbuf - 6 : 1);
+	memmove (st->buf, st->buf + skip, st->nbuf - skip);
+	st->nbuf -= (int)skip;
+	st->offset += skip;
+	return (skip);
+    }
+
+    if ((avail = st->inlen - st->inpos) == 0) return (0);
+    k = ms_resync_buf (st->in + st->inpos, avail, 1, &incomplete);
+    if (k >= 0 && ! incomplete) {
+	st->inpos += k;
+	st->offset += k;
+	return (k);
+    }
+    skip = (k >= 0) ? k : ((avail > 7) ? avail - 6 : 1);
+    st->inpos += skip;
+    st->offset += skip;
+    if ((status = stream_append (st, st->in + st->inpos, st->inlen - st->inpos)) < 0)
+	return (status);
+    st->inpos = st->inlen;
+    return (skip);
+}
@@ -0,0 +1,87 @@
+/************************************************************************/
+/*  Splitting of MiniSEED byte streams into records.			*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_stream_h
+#define	__ms_stream_h
+
+#include <sys/types.h>
+
+/*	State of a MiniSEED stream splitter.				*/
+
+typedef struct _ms_stream {
+    char	*in;		/* current input data.			*/
+    size_t	inlen;		/* # of bytes of input data.		*/
+    size_t	inpos;		/* offset of next unused input byte.	*/
+    char	*buf;		/* buffer for a partial record.		*/
+    int		buflen;		/* allocated size of buf.		*/
+    int		nbuf;		/* # of bytes in buf.			*/
+    int		used;		/* # of bytes of buf returned.		*/
+    int64_t	offset;		/* stream offset of next record.	*/
+    int64_t	rec_offset;	/* stream offset of last record.	*/
+} MS_STREAM;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern void ms_stream_init
+   (MS_STREAM	*st);		/* ptr to MS_STREAM.			*/
+
+extern void ms_stream_free
+   (MS_STREAM	*st);		/* ptr to MS_STREAM.			*/
+
+extern void ms_stream_reset
+   (MS_STREAM	*st);		/* ptr to MS_STREAM.			*/
+
+extern int ms_stream_push
+   (MS_STREAM	*st,		/* ptr to MS_STREAM.			*/
+    char	*data,		/* ptr to input data.			*/
+    size_t	len);		/* # of bytes of input data.		*/
+
+extern int64_t ms_stream_resync
+   (MS_STREAM	*st);		/* ptr to MS_STREAM.			*/
+
+extern int ms_stream_next
+   (MS_STREAM	*st,		/* ptr to MS_STREAM.			*/
+    char	**prec);	/* ptr to record (returned).		*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,462 @@
+/************************************************************************/
+/*  Routines for assembling MiniSEED records into continuous traces.	*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "qdefines.h"
+#include "msdatatypes.h"
+#include "timedef.h"
+#include "sdr.h"
+#include "data_hdr.h"
+#include "qtime.h"
+#include "qutils.h"
+#include "sdr_utils.h"
+#include "ms_scan.h"
+#include "ms_sncl.h"
+#include "ms_trace.h"
+
+#define	TRACE_TOLERANCE	0.5	/* default tolerance in samples.	*/
+#define	TRACE_INCREMENT	16	/* # of traces or segments to allocate.	*/
+#define	TRACE_MINDATA	1024	/* initial # of samples to allocate.	*/
+
+/************************************************************************/
+/*  time_cmp:								*/
+/*	Compare two INT_TIMEs.						*/
+/*  return:	<0, 0, >0 if a is before, equal to, or after b.		*/
+/************************************************************************/
+static int time_cmp
+   (INT_TIME	a,		/* first time.				*/
+    INT_TIME	b)		/* second time.				*/
+{
+    if (a.year != b.year) return ((a.year < b.year) ? -1 : 1);
+    if (a.second != b.second) return ((a.second < b.second) ? -1 : 1);
+    if (a.usec != b.usec) return ((a.usec < b.usec) ? -1 : 1);
+    return (0);
+}
+
+/************************************************************************/
+/*  find_trace:								*/
+/*	Find the trace with the specified SNCL id, and optionally	*/
+/*	create it with the names of that id if it does not exist.	*/
+/*  return:	ptr to trace, or NULL if not found or on malloc error.	*/
+/************************************************************************/
+static MS_TRACE *find_trace
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    int		sncl_id,	/* SNCL id of trace.			*/
+    int		create)		/* create trace if not found.		*/
+{
+    MS_TRACE	*t;
+    MS_SNCL	*name;
+    void	*p;
+    int		n, i;
+
+    if (sncl_id < 0) return (NULL);
+    if (sncl_id < list->nbyid && list->byid[sncl_id]) 
+	return (list->byid[sncl_id]);
+    if (! create) return (NULL);
+    if (sncl_id >= list->nbyid) {
+	n = (list->nbyid > 0) ? 2 * list->nbyid : TRACE_INCREMENT;
+	while (n <= sncl_id) n *= 2;
+	if ((p = realloc (list->byid, n * sizeof(MS_TRACE *))) == NULL)
+	    return (NULL);
+	list->byid = (MS_TRACE **)p;
+	for (i=list->nbyid; i<n; i++) list->byid[i] = NULL;
+	list->nbyid = n;
+    }
+    if (list->ntraces % TRACE_INCREMENT == 0) {
+	if ((p = realloc (list->trace, (list->ntraces + TRACE_INCREMENT) * 
+			  sizeof(MS_TRACE *))) == NULL) return (NULL);
+	list->trace = (MS_TRACE **)p;
+    }
+    if ((t = (MS_TRACE *)calloc (1, sizeof(MS_TRACE))) == NULL) return (NULL);
+    name = ms_sncl_name (sncl_id);
+    strcpy (t->station_id, name->station_id);
+    strcpy (t->location_id, name->location_id);
+    strcpy (t->channel_id, name->channel_id);
+    strcpy (t->network_id, name->network_id);
+    t->sncl_id = sncl_id;
+    list->byid[sncl_id] = t;
+    list->trace[list->ntraces++] = t;
+    return (t);
+}
+
+/************************************************************************/
+/*  seg_reserve:							*/
+/*	Make room for the specified # of samples in a segment.		*/
+/*  return:	0 on success, QLIB2_MALLOC_ERROR on error.		*/
+/************************************************************************/
+static int seg_reserve
+   (MS_TRACE_SEG *seg,		/* ptr to segment.			*/
+    int64_t	n)		/* # of samples required.		*/
+{
+    int64_t	k;
+    void	*p;
+
+    if (n <= seg->maxsamples) return (0);
+    k = (seg->maxsamples > 0) ? 2 * seg->maxsamples : TRACE_MINDATA;
+    while (k < n) k *= 2;
+    if ((p = realloc (seg->data, k * sizeof(int))) == NULL) 
+	return (QLIB2_MALLOC_ERROR);
+    seg->data = (int *)p;
+    seg->maxsamples = k;
+    return (0);
+}
+
+/************************************************************************/
+/*  continues:								*/
+/*	Determine whether data starting at time t with the specified	*/
+/*	rate continues a segment.					*/
+/************************************************************************/
+static int continues
+   (MS_TRACE_SEG *seg,		/* ptr to segment.			*/
+    INT_TIME	t,		/* time of first sample.		*/
+    int		rate,		/* sample rate in qlib convention.	*/
+    int		rate_mult,	/* rate_mult in qlib convention.	*/
+    double	tol)		/* tolerance in usecs.			*/
+{
+    double	d;
+
+    if (seg->sample_rate != rate || seg->sample_rate_mult != rate_mult) 
+	return (0);
+    d = tdiff (t, seg->next);
+    return (d >= -tol && d <= tol);
+}
+
+/************************************************************************/
+/*  trace_add:								*/
+/*	Add the samples of a record to the segments of its trace.  The	*/
+/*	record is appended to a segment that it continues, prepended	*/
+/*	to a segment that continues it, or both, joining the two	*/
+/*	segments.  Otherwise it starts a new segment.  Segments are	*/
+/*	kept in order of begtime.					*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+static int trace_add
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    int		sncl_id,	/* SNCL id of record.			*/
+    SAMPLE_CLOCK *sc,		/* sample clock of the record.		*/
+    int		rate,		/* sample rate in qlib convention.	*/
+    int		rate_mult,	/* rate_mult in qlib convention.	*/
+    int		n,		/* # of samples in the record.		*/
+    int		*data)		/* samples, or NULL.			*/
+{
+    MS_TRACE	*t;
+    MS_TRACE_SEG *seg, rseg;
+    INT_TIME	begtime = sc->anchor;
+    double	tol;
+    void	*p;
+    int		i, j, k;
+
+    if (list->with_data < 0) list->with_data = (data != NULL);
+    if (list->with_data != (data != NULL)) {
+	fprintf (stderr, "Error: unable to mix records with and without samples in ms_trace\n");
+	fflush (stderr);
+	return (MS_ERROR);
+    }
+    if ((t = find_trace (list, sncl_id, 1)) == NULL)
+	return (QLIB2_MALLOC_ERROR);
+    tol = list->tolerance * USECS_PER_SEC * (double)sc->den / (double)sc->num;
+
+    /* The record is inserted before segment i.  Find a segment j	*/
+    /* that it continues, and a segment k that continues it.		*/
+    for (i=t->nsegs; i>0 && time_cmp (t->seg[i-1].begtime, begtime) > 0; i--) ;
+    for (j=i-1; j>=0 && ! continues (&t->seg[j], begtime, rate, rate_mult, tol); j--) ;
+    memset ((char *)&rseg, 0, sizeof(MS_TRACE_SEG));
+    rseg.next = sample_clock_time (sc, n);
+    for (k=i; k<t->nsegs; k++) {
+	if (tdiff (t->seg[k].begtime, rseg.next) > tol) { k = t->nsegs; break; }
+	if (t->seg[k].sample_rate == rate && t->seg[k].sample_rate_mult == rate_mult &&
+	    tdiff (t->seg[k].begtime, rseg.next) >= -tol) break;
+    }
+    if (k == t->nsegs) k = -1;
+
+    if (j >= 0) {
+	/* Append the record to segment j.				*/
+	seg = &t->seg[j];
+	if (data) {
+	    if (seg_reserve (seg, seg->nsamples + n) < 0) return (QLIB2_MALLOC_ERROR);
+	    memcpy ((char *)(seg->data + seg->nsamples), (char *)data, n * sizeof(int));
+	}
+	seg->nsamples += n;
+	seg->nrecords++;
+	seg->endtime = sample_clock_time (sc, n - 1);
+	seg->next = rseg.next;
+	if (k < 0) return (0);
+
+	/* Join segment k to segment j, and remove it.			*/
+	if (data) {
+	    if (seg_reserve (seg, seg->nsamples + t->seg[k].nsamples) < 0) 
+		return (QLIB2_MALLOC_ERROR);
+	    memcpy ((char *)(seg->data + seg->nsamples), (char *)t->seg[k].data, 
+		    t->seg[k].nsamples * sizeof(int));
+	    free ((char *)t->seg[k].data);
+	}
+	seg->nsamples += t->seg[k].nsamples;
+	seg->nrecords += t->seg[k].nrecords;
+	seg->endtime = t->seg[k].endtime;
+	seg->next = t->seg[k].next;
+	memmove ((char *)&t->seg[k], (char *)&t->seg[k+1], 
+		 (t->nsegs - k - 1) * sizeof(MS_TRACE_SEG));
+	t->nsegs--;
+	return (0);
+    }
+
+    if (k >= 0) {
+	/* Prepend the record to segment k, which then moves to i.	*/
+	rseg = t->seg[k];
+	if (data) {
+	    if (seg_reserve (&rseg, rseg.nsamples + n) < 0) return (QLIB2_MALLOC_ERROR);
+	    memmove ((char *)(rseg.data + n), (char *)rseg.data, rseg.nsamples * sizeof(int));
+	    memcpy ((char *)rseg.data, (char *)data, n * sizeof(int));
+	}
+	rseg.begtime = begtime;
+	rseg.nsamples += n;
+	rseg.nrecords++;
+	memmove ((char *)&t->seg[i+1], (char *)&t->seg[i], (k - i) * sizeof(MS_TRACE_SEG));
+	t->seg[i] = rseg;
+	return (0);
+    }
+
+    /* Start a new segment at i.					*/
+    rseg.begtime = begtime;
+    rseg.endtime = sample_clock_time (sc, n - 1);
+    rseg.sample_rate = rate;
+    rseg.sample_rate_mult = rate_mult;
+    rseg.nsamples = n;
+    rseg.nrecords = 1;
+    if (data) {
+	if (seg_reserve (&rseg, n) < 0) return (QLIB2_MALLOC_ERROR);
+	memcpy ((char *)rseg.data, (char *)data, n * sizeof(int));
+    }
+    if (t->nsegs >= t->maxsegs) {
+	if ((p = realloc (t->seg, (t->maxsegs + TRACE_INCREMENT) * 
+			  sizeof(MS_TRACE_SEG))) == NULL) {
+	    if (rseg.data) free ((char *)rseg.data);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	t->seg = (MS_TRACE_SEG *)p;
+	t->maxsegs += TRACE_INCREMENT;
+    }
+    memmove ((char *)&t->seg[i+1], (char *)&t->seg[i], 
+	     (t->nsegs - i) * sizeof(MS_TRACE_SEG));
+    t->seg[i] = rseg;
+    t->nsegs++;
+    return (0);
+}
+
+/************************************************************************/
+/*  ms_trace_init:							*/
+/*	Initialize a trace list.  Records are continuous if their first	*/
+/*	sample is within tolerance samples of the time expected from	*/
+/*	the previous record.						*/
+/************************************************************************/
+void ms_trace_init
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    double	tolerance)	/* tolerance as a fraction of a sample,	*/
+				/* or <= 0 for the default of 0.5.	*/
+{
+    memset ((char *)list, 0, sizeof(MS_TRACE_LIST));
+    list->tolerance = (tolerance > 0) ? tolerance : TRACE_TOLERANCE;
+    list->with_data = -1;
+}
+
+/************************************************************************/
+/*  ms_trace_free:							*/
+/*	Free the storage in a trace list.				*/
+/************************************************************************/
+void ms_trace_free
+   (MS_TRACE_LIST *list)	/* ptr to MS_TRACE_LIST.		*/
+{
+    MS_TRACE	*t;
+    int		i, j;
+
+    for (i=0; i<list->ntraces; i++) {
+	t = list->trace[i];
+	for (j=0; j<t->nsegs; j++) 
+	    if (t->seg[j].data) free ((char *)t->seg[j].data);
+	if (t->seg) free ((char *)t->seg);
+	free ((char *)t);
+    }
+    if (list->trace) free ((char *)list->trace);
+    if (list->byid) free ((char *)list->byid);
+    if (list->gap) free ((char *)list->gap);
+    ms_trace_init (list, list->tolerance);
+}
+
+/************************************************************************/
+/*  ms_trace_add_hdr:							*/
+/*	Add a record to a trace list from its DATA_HDR.  If data is	*/
+/*	not NULL, it contains the hdr->num_samples integer samples of	*/
+/*	the record, which are kept in the segments.  Otherwise only the	*/
+/*	times are kept.  All records of a list must be added the same	*/
+/*	way.  Records without samples or sample rate are ignored.	*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+int ms_trace_add_hdr
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR of record.		*/
+    int		*data)		/* decoded samples, or NULL.		*/
+{
+    SAMPLE_CLOCK sc;
+    int		id = hdr->sncl_id;
+
+    if (hdr->num_samples <= 0 || init_sample_clock_hdr (&sc, hdr) != 0) 
+	return (0);
+    /* The SNCL id is assigned here, since decoding does not.		*/
+    if (id < 0 && (id = ms_sncl_id (hdr->network_id, hdr->station_id,
+				    hdr->location_id, hdr->channel_id)) < 0) 
+	return (id);
+    hdr->sncl_id = id;
+    return (trace_add (list, id, &sc, hdr->sample_rate,
+		       hdr->sample_rate_mult, hdr->num_samples, data));
+}
+
+/************************************************************************/
+/*  ms_trace_add_summary:						*/
+/*	Add a record to a trace list from its MS_SUMMARY.  Only the	*/
+/*	times are kept.							*/
+/*  return:	0 on success, negative QLIB2 error code on error.	*/
+/************************************************************************/
+int ms_trace_add_summary
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    MS_SUMMARY	*s)		/* ptr to record summary.		*/
+{
+    SAMPLE_CLOCK sc;
+    int		id;
+
+    if (s->num_samples <= 0) return (0);
+    if (! (s->rate_spsec > 0 && 
+	   init_sample_clock_sps (&sc, s->begtime, s->rate_spsec) == 0) &&
+	init_sample_clock (&sc, s->begtime, s->sample_rate, s->sample_rate_mult) != 0)
+	return (0);
+    if ((id = ms_sncl_id (s->network_id, s->station_id, s->location_id,
+			  s->channel_id)) < 0) return (id);
+    return (trace_add (list, id, &sc, s->sample_rate, s->sample_rate_mult,
+		       s->num_samples, NULL));
+}
+
+/************************************************************************/
+/*  ms_trace_scan_file:							*/
+/*	Add the records of a MiniSEED file to a trace list, from their	*/
+/*	headers only.  No samples are decoded.				*/
+/*  return:								*/
+/*	# of traces on success.						*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int ms_trace_scan_file
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    MS_SUMMARY	s;
+    int		status;
+
+    while ((status = ms_scan_record (fp, &s)) > 0) {
+	if ((status = ms_trace_add_summary (list, &s)) < 0) break;
+    }
+    if (status == QLIB2_MALLOC_ERROR) {
+	fprintf (stderr, "Error: unable to malloc segment in ms_trace_scan_file\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+    }
+    return ((status == EOF) ? list->ntraces : status);
+}
+
+/************************************************************************/
+/*  ms_trace_find:							*/
+/*	Find a trace by name.  A location of "--" matches a blank	*/
+/*	location.							*/
+/*  return:	ptr to trace, or NULL if not found.			*/
+/************************************************************************/
+MS_TRACE *ms_trace_find
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel)	/* channel name.			*/
+{
+    if (strcmp (location, "--") == 0) location = "";
+    return (find_trace (list, ms_sncl_find (network, station, location,
+					    channel), 0));
+}
+
+/************************************************************************/
+/*  ms_trace_gaps:							*/
+/*	Build the list of gaps and overlaps between the segments of	*/
+/*	each trace in list->gap.  The gap before a segment is measured	*/
+/*	from the latest expected next sample of the earlier segments.	*/
+/*  return:	# of gaps and overlaps, or QLIB2_MALLOC_ERROR.		*/
+/************************************************************************/
+int ms_trace_gaps
+   (MS_TRACE_LIST *list)	/* ptr to MS_TRACE_LIST.		*/
+{
+    MS_TRACE	*t;
+    MS_TRACE_GAP *g;
+    INT_TIME	reach;
+    int		i, j, n = 0;
+
+    for (i=0; i<list->ntraces; i++) 
+	if (list->trace[i]->nsegs > 1) n += list->trace[i]->nsegs - 1;
+    if (list->gap) free ((char *)list->gap);
+    list->gap = NULL;
+    list->ngaps = 0;
+    if (n == 0) return (0);
+    if ((list->gap = (MS_TRACE_GAP *)malloc (n * sizeof(MS_TRACE_GAP))) == NULL) {
+	fprintf (stderr, "Error: unable to malloc gaps in ms_trace_gaps\n");
+	fflush (stderr);
+	if (QLIB2_CLASSIC) exit(1);
+	return (QLIB2_MALLOC_ERROR);
+    }
+    for (i=0; i<list->ntraces; i++) {
+	t = list->trace[i];
+	if (t->nsegs == 0) continue;
+	reach = t->seg[0].next;
+	for (j=1; j<t->nsegs; j++) {
+	    g = &list->gap[list->ngaps++];
+	    g->trace = i;
+	    g->seg = j;
+	    g->expected = reach;
+	    g->actual = t->seg[j].begtime;
+	    g->gap = tdiff (g->actual, g->expected);
+	    if (time_cmp (t->seg[j].next, reach) > 0) reach = t->seg[j].next;
+	}
+    }
+    return (list->ngaps);
+}
@@ -0,0 +1,141 @@
+/************************************************************************/
+/*  Routines for assembling MiniSEED records into continuous traces.	*/
+/*									*/
+/*	Douglas Neuhauser						*/
+/*	Seismological Laboratory					*/
+/*	University of California, Berkeley				*/
+/*	doug@seismo.berkeley.edu					*/
+/*									*/
+/************************************************************************/
+
+/*
+ * Copyright (c) 2026 The Regents of the University of California.
+ * All Rights Reserved.
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for educational, research and non-profit purposes,
+ * without fee, and without a written agreement is hereby granted,
+ * provided that the above copyright notice, this paragraph and the
+ * following three paragraphs appear in all copies.
+ *
+ * Permission to incorporate this software into commercial products may
+ * be obtained from the Office of Technology Licensing, 2150 Shattuck
+ * Avenue, Suite 510, Berkeley, CA  94704.
+ *
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY
+ * FOR DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * INCLUDING LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND
+ * ITS DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE
+ * PROVIDED HEREUNDER IS ON AN "AS IS" BASIS, AND THE UNIVERSITY OF
+ * CALIFORNIA HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE, SUPPORT,
+ * UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef	__ms_trace_h
+#define	__ms_trace_h
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "timedef.h"
+#include "data_hdr.h"
+#include "ms_scan.h"
+
+/*	A continuous segment of a trace.				*/
+
+typedef struct _ms_trace_seg {
+    INT_TIME	begtime;	/* time of first sample.		*/
+    INT_TIME	endtime;	/* time of last sample.			*/
+    INT_TIME	next;		/* expected time of next sample.	*/
+    int		sample_rate;	/* sample rate in qlib convention.	*/
+    int		sample_rate_mult;/* rate_mult in qlib convention.	*/
+    int64_t	nsamples;	/* # of samples.			*/
+    int		nrecords;	/* # of records.			*/
+    int		*data;		/* samples, or NULL for a trace		*/
+				/* assembled from headers only.		*/
+    int64_t	maxsamples;	/* # of samples allocated for data.	*/
+} MS_TRACE_SEG;
+
+/*	The segments of one channel, in order of begtime.		*/
+
+typedef struct _ms_trace {
+    char	station_id[DH_STATION_LEN+1];	/* station name.	*/
+    char	location_id[DH_LOCATION_LEN+1];	/* location id.		*/
+    char	channel_id[DH_CHANNEL_LEN+1];	/* channel name.	*/
+    char	network_id[DH_NETWORK_LEN+1];	/* network id.		*/
+    int		sncl_id;	/* SNCL id of channel.			*/
+    int		nsegs;		/* # of segments.			*/
+    int		maxsegs;	/* # of segments allocated.		*/
+    MS_TRACE_SEG *seg;		/* segments.				*/
+} MS_TRACE;
+
+/*	A gap or overlap between consecutive segments of a trace.	*/
+
+typedef struct _ms_trace_gap {
+    int		trace;		/* index of trace in list->trace.	*/
+    int		seg;		/* index of segment after the gap.	*/
+    INT_TIME	expected;	/* expected time of the next sample.	*/
+    INT_TIME	actual;		/* begtime of the segment.		*/
+    double	gap;		/* usecs from expected to actual time,	*/
+				/* negative for an overlap.		*/
+} MS_TRACE_GAP;
+
+/*	A list of traces.						*/
+
+typedef struct _ms_trace_list {
+    int		ntraces;	/* # of traces.				*/
+    MS_TRACE	**trace;	/* traces, in order of appearance.	*/
+    double	tolerance;	/* max time error of a continuous	*/
+				/* record, as a fraction of a sample.	*/
+    int		with_data;	/* 1 if samples are kept, 0 if not,	*/
+				/* -1 if no records have been added.	*/
+    MS_TRACE	**byid;		/* traces indexed by SNCL id.		*/
+    int		nbyid;		/* # of entries in byid.		*/
+    int		ngaps;		/* # of gaps and overlaps.		*/
+    MS_TRACE_GAP *gap;		/* gaps and overlaps.			*/
+} MS_TRACE_LIST;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+extern void ms_trace_init
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    double	tolerance);	/* tolerance as a fraction of a sample,	*/
+				/* or <= 0 for the default of 0.5.	*/
+
+extern void ms_trace_free
+   (MS_TRACE_LIST *list);	/* ptr to MS_TRACE_LIST.		*/
+
+extern int ms_trace_add_hdr
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR of record.		*/
+    int		*data);		/* decoded samples, or NULL.		*/
+
+extern int ms_trace_add_summary
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    MS_SUMMARY	*s);		/* ptr to record summary.		*/
+
+extern int ms_trace_scan_file
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    FILE	*fp);		/* FILE pointer for input file.		*/
+
+extern MS_TRACE *ms_trace_find
+   (MS_TRACE_LIST *list,	/* ptr to MS_TRACE_LIST.		*/
+    char	*network,	/* network name.			*/
+    char	*station,	/* station name.			*/
+    char	*location,	/* location name.			*/
+    char	*channel);	/* channel name.			*/
+
+extern int ms_trace_gaps
+   (MS_TRACE_LIST *list);	/* ptr to MS_TRACE_LIST.		*/
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
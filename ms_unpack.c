@@ -56,12 +56,17 @@
 #include "unpack.h"
 
 /************************************************************************/
-/*  ms_unpack:								*/
+/*  ms_unpack_x:							*/
 /*	Unpack Mini-SEED data and place in supplied buffer.		*/
+/*	If ctx is NULL, use the global qlib2 settings, allocate a	*/
+/*	temporary difference buffer, and print errors on stderr.	*/
+/*	Otherwise use the QLIB2_CTX for settings, the difference	*/
+/*	buffer, and error messages.					*/
 /*  Return:	# of samples on success, error code on error.		*/
 /************************************************************************/
-int ms_unpack 
-   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+static int ms_unpack_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
     int		max_num_points,	/* max # of points to return.		*/
     char	*ms,		/* ptr to Mini-SEED record.		*/
     void	*data_buffer)	/* ptr to output data buffer.		*/
@@ -74,6 +79,8 @@ int ms_unpack
     int nsamples;
     char *dbuf;
     int *diffbuff;
+    char *errmsg = (ctx) ? ctx->errmsg : NULL;
+    char msg[QLIB2_ERRMSG_LEN];
 
     /* Determine blocksize and data format from the blockette 1000.	*/
     /* If we don't have one, it is an error.				*/
@@ -95,28 +102,24 @@ int ms_unpack
     /* Decide if this is a format that we can decode.			*/
     switch (format) {
       case STEIM1:
-	if ((diffbuff = (int *)malloc(hdr->num_samples * sizeof(int))) == NULL) {
-	    fprintf (stderr, "Error: unable to malloc diff buffer in ms_read\n");
-	    if (QLIB2_CLASSIC) exit(1);
-	    return (QLIB2_MALLOC_ERROR);
-	}
-	nsamples = unpack_steim1 ((FRAME *)dbuf, datasize, hdr->num_samples,
-				  max_num_points, (int *)data_buffer, diffbuff, 
-				  &hdr->x0, &hdr->xn, hdr->data_wordorder, NULL);
-	if (nsamples > 0) hdr->xm1 = hdr->x0 - diffbuff[0];
-	free ((char *)diffbuff);
-	break;
       case STEIM2:
-	if ((diffbuff = (int *)malloc(hdr->num_samples * sizeof(int))) == NULL) {
-	    fprintf (stderr, "Error: unable to malloc diff buffer in ms_read\n");
-	    if (QLIB2_CLASSIC) exit(1);
+	if (ctx) diffbuff = qlib2_ctx_diffbuf (ctx, hdr->num_samples);
+	else diffbuff = (int *)malloc(hdr->num_samples * sizeof(int));
+	if (diffbuff == NULL) {
+	    qlib2_ctx_error (ctx, "Error: unable to malloc diff buffer in ms_read\n");
+	    if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
 	    return (QLIB2_MALLOC_ERROR);
 	}
-	nsamples = unpack_steim2 ((FRAME *)dbuf, datasize, hdr->num_samples,
-				  max_num_points, (int *)data_buffer, diffbuff, 
-				  &hdr->x0, &hdr->xn, hdr->data_wordorder, NULL);
+	if (format == STEIM1) 
+	    nsamples = unpack_steim1_r ((FRAME *)dbuf, datasize, hdr->num_samples,
+					max_num_points, (int *)data_buffer, diffbuff, 
+					&hdr->x0, &hdr->xn, hdr->data_wordorder, errmsg);
+	else
+	    nsamples = unpack_steim2_r ((FRAME *)dbuf, datasize, hdr->num_samples,
+					max_num_points, (int *)data_buffer, diffbuff, 
+					&hdr->x0, &hdr->xn, hdr->data_wordorder, errmsg);
 	if (nsamples > 0) hdr->xm1 = hdr->x0 - diffbuff[0];
-	free ((char *)diffbuff);
+	if (! ctx) free ((char *)diffbuff);
 	break;
       case INT_16:
 	nsamples = unpack_int_16 ((short *)dbuf, datasize, hdr->num_samples,
@@ -144,9 +147,10 @@ int ms_unpack
 				  hdr->data_wordorder, NULL);
 	break;
      default:
-	fprintf (stderr, "Error: Currently unable to read format %d for %s.%s.%s\n", format,
+	sprintf (msg, "Error: Currently unable to read format %d for %s.%s.%s\n", format,
 		 hdr->station_id, hdr->network_id, hdr->channel_id);
-	if (QLIB2_CLASSIC) exit(1);
+	qlib2_ctx_error (ctx, msg);
+	if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
 	return (MS_ERROR);
     }
     if (nsamples > 0 || hdr->num_samples == 0) {
@@ -154,3 +158,34 @@ int ms_unpack
     }
     return (MS_ERROR);
 }
+
+/************************************************************************/
+/*  ms_unpack:								*/
+/*	Unpack Mini-SEED data and place in supplied buffer.		*/
+/*  Return:	# of samples on success, error code on error.		*/
+/************************************************************************/
+int ms_unpack 
+   (DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    int		max_num_points,	/* max # of points to return.		*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    void	*data_buffer)	/* ptr to output data buffer.		*/
+{
+    return (ms_unpack_x (NULL, hdr, max_num_points, ms, data_buffer));
+}
+
+/************************************************************************/
+/*  ms_unpack_ctx:							*/
+/*	Reentrant version of ms_unpack.  The difference buffer for	*/
+/*	Steim data is kept in the QLIB2_CTX and reused, and error	*/
+/*	messages are returned in the QLIB2_CTX errmsg.			*/
+/*  Return:	# of samples on success, error code on error.		*/
+/************************************************************************/
+int ms_unpack_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    int		max_num_points,	/* max # of points to return.		*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    void	*data_buffer)	/* ptr to output data buffer.		*/
+{
+    return (ms_unpack_x (ctx, hdr, max_num_points, ms, data_buffer));
+}
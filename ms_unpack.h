@@ -42,6 +42,7 @@
 #define	__ms_unpack_h
 
 #include "data_hdr.h"
+#include "qutils.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -53,6 +54,13 @@ extern int ms_unpack
     char	*ms,		/* ptr to Mini-SEED record.		*/
     void	*data_buffer);	/* ptr to output data buffer.		*/
 
+extern int ms_unpack_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	*hdr,		/* ptr to DATA_HDR for Mini-SEED record.*/
+    int		max_num_points,	/* max # of points to return.		*/
+    char	*ms,		/* ptr to Mini-SEED record.		*/
+    void	*data_buffer);	/* ptr to output data buffer.		*/
+
 #ifdef	__cplusplus
 }
 #endif
@@ -41,6 +41,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
 
 #include "qdefines.h"
 #include "msdatatypes.h"
@@ -52,10 +55,13 @@
 #include "qutils.h"
 #include "sdr_utils.h"
 #include "ms_unpack.h"
+#include "ms_scan.h"
 #include "ms_utils.h"
 
 #define MAXBLKSIZE	32768
 #define	FIXED_DATA_HDR_SIZE 48
+#define	MS_READ_STEP	64	/* header read size until blksize known.*/
+#define	MAX_PARSE_LEN	(1<<30)	/* max buffer size for decode_hdr_sdr.	*/
 
 typedef struct data_format_table {
     int format;
@@ -75,18 +81,25 @@ static FORMAT_ENTRY data_format_table[] =
     {UNKNOWN_DATATYPE,	NULL,},
 };
 
+static int read_ms_record_x (QLIB2_CTX *ctx, DATA_HDR **phdr, char **pbuf, 
+			     FILE *fp);
+static int read_ms_hdr_x (QLIB2_CTX *ctx, DATA_HDR **phdr, char **pbuf, 
+			  FILE *fp);
+
 /************************************************************************/
-/*  read_ms:								*/
+/*  read_ms_x:								*/
 /*	Read a MiniSEED record, unpack the data, and return to the user	*/
 /*	a data_hdr and the unpacked data.				*/
+/*	If ctx is NULL, use the global qlib2 settings.			*/
 /*  returns:								*/
 /*	number of data samples on success.				*/
 /*	EOF on eof.							*/
 /*	MS_ERROR on MiniSEED error.					*/
 /*	QLIB2_MALLOC_ERROR on malloc error.				*/
 /************************************************************************/
-int read_ms 
-   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+static int read_ms_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
     void	*data_buffer,	/* pointer to output data buffer.	*/
     int		max_num_points,	/* max # data points to return.		*/
     FILE	*fp)		/* FILE pointer for input file.		*/
@@ -98,17 +111,56 @@ int read_ms
 
     if (max_num_points < 0) return (MS_ERROR);
     if (max_num_points == 0) return (0);
-    status = blksize = read_ms_record (phdr, &pbuf, fp);
+    status = blksize = read_ms_record_x (ctx, phdr, &pbuf, fp);
     if (blksize > 0) {
-	status = nsamples = ms_unpack (*phdr, max_num_points,
-				      pbuf, data_buffer);
+	status = nsamples = (ctx) ?
+	    ms_unpack_ctx (ctx, *phdr, max_num_points, pbuf, data_buffer) :
+	    ms_unpack (*phdr, max_num_points, pbuf, data_buffer);
     }
     if (pbuf) free (pbuf);
     return (status);
 }
 
 /************************************************************************/
-/*  read_ms_record:							*/
+/*  read_ms:								*/
+/*	Read a MiniSEED record, unpack the data, and return to the user	*/
+/*	a data_hdr and the unpacked data.				*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int read_ms 
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_x (NULL, phdr, data_buffer, max_num_points, fp));
+}
+
+/************************************************************************/
+/*  read_ms_ctx:							*/
+/*	Reentrant version of read_ms, using the specified QLIB2_CTX.	*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int read_ms_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_x (ctx, phdr, data_buffer, max_num_points, fp));
+}
+
+/************************************************************************/
+/*  read_ms_record_x:						*/
 /*	Read a MiniSEED record, returning to the user a data_hdr and	*/
 /*	the raw record.							*/
 /*	If *pbuf == NULL, allocated space for the record.		*/
@@ -119,8 +171,9 @@ int read_ms
 /*	EOF on eof.							*/
 /*	QLIB2 error code on error.					*/
 /************************************************************************/
-int read_ms_record 
-   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+static int read_ms_record_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
     char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
     FILE	*fp)		/* FILE pointer for input file.		*/
 {
@@ -128,7 +181,7 @@ int read_ms_record
     int offset;			/* offset to data in MiniSEED record.	*/
     int blksize;		/* blksize of MiniSEED record.		*/
 
-    status = offset = read_ms_hdr (phdr, pbuf, fp);
+    status = offset = read_ms_hdr_x (ctx, phdr, pbuf, fp);
     if (offset > 0 && ! is_vol_hdr_ind((*phdr)->record_type)) {
 	status = blksize = read_ms_data (*phdr, *pbuf, offset, fp);
     }
@@ -136,7 +189,45 @@ int read_ms_record
 }
 
 /************************************************************************/
-/*  read_ms_hdr:							*/
+/*  read_ms_record:							*/
+/*	Read a MiniSEED record, returning to the user a data_hdr and	*/
+/*	the raw record.							*/
+/*	If *pbuf == NULL, allocated space for the record.		*/
+/*	Otherwise, assume that it points to a valid buffer to use.	*/
+/*	If we allocate space for the buffer, caller must free space.	*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_record 
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_record_x (NULL, phdr, pbuf, fp));
+}
+
+/************************************************************************/
+/*  read_ms_record_ctx:							*/
+/*	Reentrant version of read_ms_record, using the specified	*/
+/*	QLIB2_CTX.							*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_record_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_record_x (ctx, phdr, pbuf, fp));
+}
+
+/************************************************************************/
+/*  read_ms_hdr_x:							*/
 /*	Routine to read MiniSEED Fixed Data Header and blockettes.	*/
 /*	Parses header into data_hdr structure, and writes raw header	*/
 /*	and blockettes into user-supplied buffer.			*/
@@ -145,8 +236,9 @@ int read_ms_record
 /*	EOF on eof.							*/
 /*	QLIB2 error code on error.					*/
 /************************************************************************/
-int read_ms_hdr 
-   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+static int read_ms_hdr_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
     char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
     FILE	*fp)		/* FILE pointer for input file.		*/
 {
@@ -163,9 +255,8 @@ int read_ms_hdr
     /* Otherwise, allocate a buffer.					*/
     if (*pbuf == NULL) {
 	if ((buf = malloc (MAXBLKSIZE * sizeof(char))) == NULL) {
-	    fprintf (stderr, "Error: Unable to allocate buffer in read_ms_hdr\n");
-	    fflush (stderr);
-	    if (QLIB2_CLASSIC) exit(1);
+	    qlib2_ctx_error (ctx, "Error: Unable to allocate buffer in read_ms_hdr\n");
+	    if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
 	    return (QLIB2_MALLOC_ERROR);
 	}
 	++alloc_buf;
@@ -189,7 +280,8 @@ int read_ms_hdr
 
     if (is_vol_hdr_ind(hdr->record_type)) {
 	/* Read the rest of the header for full parsing.		*/
-	if (fread(buf+offset, hdr->blksize-offset, 1, fp) != 1) {
+	if (hdr->blksize > MAXBLKSIZE ||
+	    fread(buf+offset, hdr->blksize-offset, 1, fp) != 1) {
 	    if (alloc_buf) free(buf);
 	    free_data_hdr(hdr);
 	    return (MS_ERROR);
@@ -200,7 +292,8 @@ int read_ms_hdr
     else {
 	/* Read blockettes.  MiniSEED should have at least blockette 1000. */
 	if (hdr->num_blockettes > 0) {
-	    if (hdr->first_blockette < offset) {
+	    if (hdr->first_blockette < offset || 
+		hdr->first_blockette > MAXBLKSIZE - (int)sizeof(BLOCKETTE_HDR)) {
 		if (alloc_buf) free(buf);
 		free_data_hdr(hdr);
 		return (MS_ERROR);
@@ -235,7 +328,9 @@ int read_ms_hdr
     /*  a.  blocksize and data_type from blockette 1000.		*/
     /*  b.  extended time info and frame count from blockette 1001.	*/
     free_data_hdr (hdr);
-    if ((hdr = decode_hdr_sdr((SDR_HDR *)buf,offset)) == NULL) {
+    hdr = (ctx) ? decode_hdr_sdr_ctx(ctx, (SDR_HDR *)buf, offset) :
+		  decode_hdr_sdr((SDR_HDR *)buf, offset);
+    if (hdr == NULL) {
 	if (alloc_buf) free(buf);
 	return (MS_ERROR);
     }
@@ -247,9 +342,8 @@ int read_ms_hdr
 	/* to hold the full record.					*/
 	if (alloc_buf && hdr->blksize > MAXBLKSIZE) {
 	    if ((buf = realloc(buf, hdr->blksize * sizeof(char))) == NULL) {
-		fprintf (stderr, "Error: Unable to allocate buffer in read_ms_hdr\n");
-		fflush (stderr);
-		if (QLIB2_CLASSIC) exit(1);
+		qlib2_ctx_error (ctx, "Error: Unable to allocate buffer in read_ms_hdr\n");
+		if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
 		if (alloc_buf) free(buf);
 		free_data_hdr(hdr);
 		return (QLIB2_MALLOC_ERROR);
@@ -258,7 +352,7 @@ int read_ms_hdr
 
 	/* Skip over space between blockettes (if any) and data.		*/
 	bl_limit = (hdr->first_data) ? hdr->first_data : hdr->blksize;
-	if (bl_limit < offset) {
+	if (bl_limit < offset || bl_limit > hdr->blksize) {
 	    if (alloc_buf) free(buf);
 	    free_data_hdr(hdr);
 	    return(MS_ERROR);
@@ -279,6 +373,41 @@ int read_ms_hdr
     return (offset);		/* Header successfully read.		*/
 }
 
+/************************************************************************/
+/*  read_ms_hdr:							*/
+/*	Routine to read MiniSEED Fixed Data Header and blockettes.	*/
+/*	Parses header into data_hdr structure, and writes raw header	*/
+/*	and blockettes into user-supplied buffer.			*/
+/*  returns:								*/
+/*	# of bytes in header and blockettes (up to first_data).		*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_hdr 
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_hdr_x (NULL, phdr, pbuf, fp));
+}
+
+/************************************************************************/
+/*  read_ms_hdr_ctx:							*/
+/*	Reentrant version of read_ms_hdr, using the specified QLIB2_CTX.*/
+/*  returns:								*/
+/*	# of bytes in header and blockettes (up to first_data).		*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_hdr_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    FILE	*fp)		/* FILE pointer for input file.		*/
+{
+    return (read_ms_hdr_x (ctx, phdr, pbuf, fp));
+}
+
 /************************************************************************/
 /*  read_ms_bkt:							*/
 /*	Read binary blockettes that follow the SEED fixed data header.	*/
@@ -323,11 +452,17 @@ int read_ms_bkt
 	    return (QLIB2_MALLOC_ERROR);
 	}
 	bs->next = (BS *)NULL;
+	bs->pb = NULL;
+	bs->type = bs->len = 0;
 	if (i == 0) hdr->pblockettes = bs;
 	else pbs->next = bs;
 	pbs = bs;
 
 	/*  Read blockette header.					*/
+	if (offset + bh_len + 2 > MAXBLKSIZE) {
+	    fprintf (stderr, "Error: invalid blockette offset %d\n", offset);
+	    return (MS_ERROR);
+	}
 	if (fread (buf+offset, bh_len, 1, fp) != 1) 
 	    return (EOF);
 	preread = 0;
@@ -418,6 +553,12 @@ int read_ms_bkt
 	    bl_len = bl_limit - offset;
 	}
 
+	/* Ensure that the blockette is within the record buffer.	*/
+	if ((int)bl_len < bh_len + preread || offset + (int)bl_len > MAXBLKSIZE) {
+	    fprintf (stderr, "Error: invalid blockette %d at offset=%d len=%d\n",
+		     bl_type, offset, bl_len);
+	    return (MS_ERROR);
+	}
 	if ((bs->pb = (char *)malloc(bl_len))==NULL) {
 	    fprintf (stderr, "unable to malloc blockettd\n");
 	    return (-1);
@@ -489,6 +630,406 @@ int read_ms_data
     return (blksize);
 }
 
+/************************************************************************/
+/*  pread_full:								*/
+/*	Read the specified # of bytes at an offset of a file with	*/
+/*	pread, retrying on short reads and interrupts.			*/
+/*  return:	# of bytes read (less than nbytes only at eof), or -1.	*/
+/************************************************************************/
+static int pread_full
+   (int		fd,		/* file descriptor for input file.	*/
+    char	*buf,		/* buffer for data.			*/
+    int		nbytes,		/* # of bytes to read.			*/
+    int64_t	offset)		/* offset in file.			*/
+{
+    int nread = 0;
+    ssize_t n;
+
+    while (nread < nbytes) {
+	n = pread (fd, buf+nread, nbytes-nread, (off_t)(offset+nread));
+	if (n < 0 && errno == EINTR) continue;
+	if (n < 0) return (-1);
+	if (n == 0) break;
+	nread += n;
+    }
+    return (nread);
+}
+
+/************************************************************************/
+/*  read_ms_record_at_x:						*/
+/*	Read the MiniSEED record at the specified offset of a file	*/
+/*	descriptor with pread, returning to the user a data_hdr and	*/
+/*	the raw record.  The file position is not used or changed.	*/
+/*	If *pbuf == NULL, allocated space for the record.		*/
+/*	Otherwise, assume that it points to a valid buffer to use.	*/
+/*	If ctx is NULL, use the global qlib2 settings.			*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+static int read_ms_record_at_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    char *buf;			/* buffer for MiniSEED record.		*/
+    DATA_HDR *hdr;		/* pointer to DATA_HDR.			*/
+    int alloc_buf = 0;
+    int nread, need, blksize;
+
+    /* If user supplies a buffer for the raw MiniSEED, use it.		*/
+    /* Otherwise, allocate a buffer.					*/
+    if (*pbuf == NULL) {
+	if ((buf = malloc (MAXBLKSIZE * sizeof(char))) == NULL) {
+	    qlib2_ctx_error (ctx, "Error: Unable to allocate buffer in read_ms_record_at\n");
+	    if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	++alloc_buf;
+    }
+    else {
+	buf = *pbuf;
+    }
+
+    /* Read the SEED Fixed Data Header, then read the blockettes in	*/
+    /* small pieces until the blksize is known.  Since the blksize	*/
+    /* is a multiple of MS_READ_STEP, we never read past the record.	*/
+    *phdr = (DATA_HDR *)NULL;
+    if ((nread = pread_full (fd, buf, FIXED_DATA_HDR_SIZE, offset)) != FIXED_DATA_HDR_SIZE) {
+	if (alloc_buf) free(buf);
+	return ((nread == 0) ? EOF : MS_ERROR);
+    }
+    while ((blksize = ms_record_length (buf, nread)) == 0) {
+	need = nread + MS_READ_STEP - (nread % MS_READ_STEP);
+	if (need > MAXBLKSIZE || 
+	    pread_full (fd, buf+nread, need-nread, offset+nread) != need-nread) {
+	    qlib2_ctx_error (ctx, "Error: unable to read header in read_ms_record_at\n");
+	    if (alloc_buf) free(buf);
+	    return (MS_ERROR);
+	}
+	nread = need;
+    }
+    if (blksize < 0 || blksize < nread) {
+	qlib2_ctx_error (ctx, "Error: invalid MiniSEED header in read_ms_record_at\n");
+	if (alloc_buf) free(buf);
+	return (MS_ERROR);
+    }
+
+    /* If we allocated the buffer, ensure that it is large enough	*/
+    /* to hold the full record.						*/
+    if (alloc_buf && blksize > MAXBLKSIZE) {
+	char *p;
+	if ((p = realloc(buf, blksize * sizeof(char))) == NULL) {
+	    qlib2_ctx_error (ctx, "Error: Unable to allocate buffer in read_ms_record_at\n");
+	    if (QLIB2_CTX_CLASSIC(ctx)) exit(1);
+	    free(buf);
+	    return (QLIB2_MALLOC_ERROR);
+	}
+	buf = p;
+    }
+
+    /* Read the rest of the record.					*/
+    if (blksize > nread &&
+	pread_full (fd, buf+nread, blksize-nread, offset+nread) != blksize-nread) {
+	qlib2_ctx_error (ctx, "Error: short record in read_ms_record_at\n");
+	if (alloc_buf) free(buf);
+	return (MS_ERROR);
+    }
+
+    /* Parse the header with all of the blockettes.			*/
+    hdr = (ctx) ? decode_hdr_sdr_ctx(ctx, (SDR_HDR *)buf, blksize) :
+		  decode_hdr_sdr((SDR_HDR *)buf, blksize);
+    if (hdr == NULL) {
+	if (alloc_buf) free(buf);
+	return (MS_ERROR);
+    }
+
+    if (alloc_buf) *pbuf = buf;
+    *phdr = hdr;
+    return (blksize);
+}
+
+/************************************************************************/
+/*  read_ms_record_at:							*/
+/*	Read the MiniSEED record at the specified offset of a file	*/
+/*	descriptor with pread, returning to the user a data_hdr and	*/
+/*	the raw record.  The file position is not used or changed, so	*/
+/*	several threads may read records from one file descriptor.	*/
+/*	If *pbuf == NULL, allocated space for the record.		*/
+/*	Otherwise, assume that it points to a valid buffer to use.	*/
+/*	If we allocate space for the buffer, caller must free space.	*/
+/*	The next record of the file is at offset + blksize.		*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_record_at
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    return (read_ms_record_at_x (NULL, phdr, pbuf, fd, offset));
+}
+
+/************************************************************************/
+/*  read_ms_record_at_ctx:						*/
+/*	Reentrant version of read_ms_record_at, using the specified	*/
+/*	QLIB2_CTX.							*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	EOF on eof.							*/
+/*	QLIB2 error code on error.					*/
+/************************************************************************/
+int read_ms_record_at_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf ptr for MiniSEED record.	*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    return (read_ms_record_at_x (ctx, phdr, pbuf, fd, offset));
+}
+
+/************************************************************************/
+/*  read_ms_at_x:							*/
+/*	Read the MiniSEED record at the specified offset of a file	*/
+/*	descriptor, unpack the data, and return to the user a data_hdr	*/
+/*	and the unpacked data.						*/
+/*	If ctx is NULL, use the global qlib2 settings.			*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+static int read_ms_at_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    int status;
+    char *pbuf = NULL;		/* ptr to ptr to MiniSEED record.	*/
+    int blksize;		/* blksize of MiniSEED record.		*/
+
+    if (max_num_points < 0) return (MS_ERROR);
+    status = blksize = read_ms_record_at_x (ctx, phdr, &pbuf, fd, offset);
+    if (blksize > 0) {
+	/* Volume headers have no samples.				*/
+	if (max_num_points == 0 || is_vol_hdr_ind((*phdr)->record_type))
+	    status = 0;
+	else status = (ctx) ?
+	    ms_unpack_ctx (ctx, *phdr, max_num_points, pbuf, data_buffer) :
+	    ms_unpack (*phdr, max_num_points, pbuf, data_buffer);
+    }
+    if (pbuf) free (pbuf);
+    return (status);
+}
+
+/************************************************************************/
+/*  read_ms_at:								*/
+/*	Read the MiniSEED record at the specified offset of a file	*/
+/*	descriptor with pread, unpack the data, and return to the user	*/
+/*	a data_hdr and the unpacked data.  The next record of the file	*/
+/*	is at offset + (*phdr)->blksize.				*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int read_ms_at
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    return (read_ms_at_x (NULL, phdr, data_buffer, max_num_points, fd, offset));
+}
+
+/************************************************************************/
+/*  read_ms_at_ctx:							*/
+/*	Reentrant version of read_ms_at, using the specified QLIB2_CTX.	*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	EOF on eof.							*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int read_ms_at_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset)		/* offset of record in file.		*/
+{
+    return (read_ms_at_x (ctx, phdr, data_buffer, max_num_points, fd, offset));
+}
+
+/************************************************************************/
+/*  parse_ms_record_x:							*/
+/*	Parse the MiniSEED record at the start of a buffer in memory,	*/
+/*	and return a data_hdr for it.  The buffer must contain the	*/
+/*	full record.							*/
+/*	If ctx is NULL, use the global qlib2 settings.			*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	MS_ERROR on error, or if the buffer is smaller than the record.	*/
+/************************************************************************/
+static int parse_ms_record_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr)		/* pointer to pointer to DATA_HDR.	*/
+{
+    DATA_HDR *hdr;		/* pointer to DATA_HDR.			*/
+    char msg[QLIB2_ERRMSG_LEN];
+    int maxbytes;
+
+    *phdr = (DATA_HDR *)NULL;
+    if (len < FIXED_DATA_HDR_SIZE) {
+	sprintf (msg, "Error: buffer of %d bytes too small for header in parse_ms_record\n",
+		 (int)len);
+	qlib2_ctx_error (ctx, msg);
+	return (MS_ERROR);
+    }
+    maxbytes = (len > MAX_PARSE_LEN) ? MAX_PARSE_LEN : (int)len;
+    hdr = (ctx) ? decode_hdr_sdr_ctx(ctx, (SDR_HDR *)buf, maxbytes) :
+		  decode_hdr_sdr((SDR_HDR *)buf, maxbytes);
+    if (hdr == NULL) return (MS_ERROR);
+
+    /* MiniSEED should have at least blockette 1000.			*/
+    if (! is_vol_hdr_ind(hdr->record_type) && find_blockette (hdr, 1000) == NULL) {
+	free_data_hdr(hdr);
+	return (MS_ERROR);
+    }
+    if ((size_t)hdr->blksize > len) {
+	sprintf (msg, "Error: buffer of %d bytes smaller than blksize %d in parse_ms_record\n",
+		 (int)len, hdr->blksize);
+	qlib2_ctx_error (ctx, msg);
+	free_data_hdr(hdr);
+	return (MS_ERROR);
+    }
+    *phdr = hdr;
+    return (hdr->blksize);
+}
+
+/************************************************************************/
+/*  parse_ms_record:							*/
+/*	Parse the MiniSEED record at the start of a buffer in memory,	*/
+/*	such as a record received from a socket or queue, and return a	*/
+/*	data_hdr for it.  The buffer must contain the full record.	*/
+/*	The record is not copied.					*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	MS_ERROR on error, or if the buffer is smaller than the record.	*/
+/************************************************************************/
+int parse_ms_record
+   (char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr)		/* pointer to pointer to DATA_HDR.	*/
+{
+    return (parse_ms_record_x (NULL, buf, len, phdr));
+}
+
+/************************************************************************/
+/*  parse_ms_record_ctx:						*/
+/*	Reentrant version of parse_ms_record, using the specified	*/
+/*	QLIB2_CTX.							*/
+/*  returns:								*/
+/*	blksize on success.						*/
+/*	MS_ERROR on error, or if the buffer is smaller than the record.	*/
+/************************************************************************/
+int parse_ms_record_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr)		/* pointer to pointer to DATA_HDR.	*/
+{
+    return (parse_ms_record_x (ctx, buf, len, phdr));
+}
+
+/************************************************************************/
+/*  parse_ms_x:								*/
+/*	Parse the MiniSEED record at the start of a buffer in memory,	*/
+/*	unpack the data, and return a data_hdr and the unpacked data.	*/
+/*	If ctx is NULL, use the global qlib2 settings.			*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+static int parse_ms_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points)	/* max # data points to return.		*/
+{
+    int status;
+
+    if (max_num_points < 0) return (MS_ERROR);
+    status = parse_ms_record_x (ctx, buf, len, phdr);
+    if (status > 0) {
+	/* Volume headers have no samples.				*/
+	if (max_num_points == 0 || is_vol_hdr_ind((*phdr)->record_type))
+	    status = 0;
+	else status = (ctx) ?
+	    ms_unpack_ctx (ctx, *phdr, max_num_points, buf, data_buffer) :
+	    ms_unpack (*phdr, max_num_points, buf, data_buffer);
+    }
+    return (status);
+}
+
+/************************************************************************/
+/*  parse_ms:								*/
+/*	Parse the MiniSEED record at the start of a buffer in memory,	*/
+/*	unpack the data, and return a data_hdr and the unpacked data.	*/
+/*	The buffer must contain the full record.			*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int parse_ms
+   (char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points)	/* max # data points to return.		*/
+{
+    return (parse_ms_x (NULL, buf, len, phdr, data_buffer, max_num_points));
+}
+
+/************************************************************************/
+/*  parse_ms_ctx:							*/
+/*	Reentrant version of parse_ms, using the specified QLIB2_CTX.	*/
+/*  returns:								*/
+/*	number of data samples on success.				*/
+/*	MS_ERROR on MiniSEED error.					*/
+/*	QLIB2_MALLOC_ERROR on malloc error.				*/
+/************************************************************************/
+int parse_ms_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points)	/* max # data points to return.		*/
+{
+    return (parse_ms_x (ctx, buf, len, phdr, data_buffer, max_num_points));
+}
+
 /************************************************************************/
 /*  decode_fixed_data_hdr:						*/
 /*	Decode SEED Fixed Data Header in the specified buffer,		*/
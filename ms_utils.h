@@ -42,8 +42,10 @@
 #define	__ms_utils_h
 
 #include "stdio.h"
+#include <sys/types.h>
 #include "data_hdr.h"
 #include "sdr.h"
+#include "qutils.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -55,16 +57,89 @@ extern int read_ms
     int		max_num_points,	/* max # data points to return.		*/
     FILE	*fp);		/* FILE pointer for input file.		*/
 
+extern int read_ms_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    FILE	*fp);		/* FILE pointer for input file.		*/
+
 extern int read_ms_record 
    (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
     char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
     FILE	*fp);		/* FILE pointer for input file.		*/
 
+extern int read_ms_record_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    FILE	*fp);		/* FILE pointer for input file.		*/
+
+extern int read_ms_record_at
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset);	/* offset of record in file.		*/
+
+extern int read_ms_record_at_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset);	/* offset of record in file.		*/
+
+extern int read_ms_at
+   (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset);	/* offset of record in file.		*/
+
+extern int read_ms_at_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points,	/* max # data points to return.		*/
+    int		fd,		/* file descriptor for input file.	*/
+    int64_t	offset);	/* offset of record in file.		*/
+
+extern int parse_ms_record
+   (char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr);	/* pointer to pointer to DATA_HDR.	*/
+
+extern int parse_ms_record_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr);	/* pointer to pointer to DATA_HDR.	*/
+
+extern int parse_ms
+   (char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points);/* max # data points to return.		*/
+
+extern int parse_ms_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    char	*buf,		/* ptr to MiniSEED record.		*/
+    size_t	len,		/* # of bytes in buffer.		*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    void	*data_buffer,	/* pointer to output data buffer.	*/
+    int		max_num_points);/* max # data points to return.		*/
+
 extern int read_ms_hdr 
    (DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
     char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
     FILE	*fp);		/* FILE pointer for input file.		*/
 
+extern int read_ms_hdr_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	**phdr,		/* pointer to pointer to DATA_HDR.	*/
+    char	**pbuf,		/* ptr to buf for MiniSEED record.	*/
+    FILE	*fp);		/* FILE pointer for input file.		*/
+
 extern int read_ms_bkt
    (DATA_HDR	*hdr,		/* data_header structure.		*/
     char	*buf,		/* ptr to fixed data header.		*/
@@ -118,11 +118,13 @@ extern char *qlib2_version;
 #define	exp2(x)	    pow(2.,x)
 #endif
 
-#define QLIB_VERSION 1059
+#define QLIB_VERSION 1060
 
 #define	QLIB2_CLASSIC	(qlib2_op_mode == 0)
 #define	QLIB2_NOEXIT	(qlib2_op_mode == 1)
 
+#define	QLIB2_ERRMSG_LEN	256	/* size of QLIB2_CTX errmsg buffer.	*/
+
 #define	MS_ERROR		-2
 #define	QLIB2_MALLOC_ERROR	-3
 #define	QLIB2_TIME_ERROR	-4
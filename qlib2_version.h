@@ -38,7 +38,7 @@
 
 /* Explicitly set overall qlib2 version here by hand.	*/
 #ifndef lint
-char *qlib2_version = "@(#)qlib2 version 1.59 (2022.229)";
+char *qlib2_version = "@(#)qlib2 version 1.60 (2026.291)";
 #endif
 
 /************************************************************************/
@@ -46,6 +46,126 @@ char *qlib2_version = "@(#)qlib2 version 1.59 (2022.229)";
 Modifications:
 Ver	Date and Action
 ------------------------------------------------------------------------
+1.60    2026.291    DSN
+	qtime.c:    Added SAMPLE_CLOCK functions init_sample_clock(), 
+		    init_sample_clock_sps(), sample_clock_time() and
+		    sample_clock_index() for exact rational sample times.
+	sdr_utils.c: Added init_sample_clock_hdr().  Compute endtime
+		    with the sample clock in decode_hdr_sdr().
+	ms_pack2.c: Compute record times from the sample clock of the
+		    initial header rather than accumulating intervals.
+	qtime.c:    Leap second table is loaded once via pthread_once(),
+		    and is never modified after it is published.  Use the
+		    leap second table compiled in from the leapseconds file
+		    if the default leapseconds file does not exist.
+		    Added reload_leap_second_table().
+	Makefile:   Generate leapseconds_tbl.h from leapseconds.
+		    Programs must be linked with -lpthread.
+	qtime.c:    Added batch time conversion routines int_to_tepoch_v(),
+		    tepoch_to_int_v(), int_to_ext_v() and tdiff_v().
+	qtime.c:    dy_to_mdy() uses a day of year to month table.
+		    normalize_ext() normalizes fields by division, and
+		    only converts through INT_TIME when the second may
+		    span a day or leap second.
+	qtime.c:    Added EXT_CURSOR, init_ext_cursor() and int_to_ext_c()
+		    for repeated conversions of times in the same day.
+	qutils.c:   Added QLIB2_CTX, qlib2_ctx_init() and qlib2_ctx_free()
+		    for per-thread settings and error information.
+		    get_my_wordorder() initializes via pthread_once().
+	ms_utils.c: Added read_ms_ctx(), read_ms_record_ctx() and
+		    read_ms_hdr_ctx().
+	ms_unpack.c: Added ms_unpack_ctx(), which reuses the diff buffer
+		    in the QLIB2_CTX.
+	sdr_utils.c: Added decode_hdr_sdr_ctx(), new_data_hdr_ctx(),
+		    init_data_hdr_ctx() and q_clock_status_r().
+	unpack.c:   Added unpack_steim1_r() and unpack_steim2_r() which
+		    return errors in a caller-supplied buffer.
+	qtime.c:    Added time_to_str_r(), utime_to_str_r() and
+		    interval_to_str_r().
+	ms_parallel.c: New file.  Added ms_decode_file_parallel(),
+		    ms_decode_buf_parallel() and ms_decoded_free() to
+		    decode an entire file using multiple threads.
+	ms_pipeline.c: New file.  Added ms_pipeline_run() to read, decode,
+		    and process records in concurrent pipeline stages.
+	ms_pack_batch.c: New file.  Added ms_pack_batch() to pack many
+		    channels into MiniSEED using multiple threads.
+	ms_scan.c:  New file.  Added ms_scan_record(), ms_scan_buf(),
+		    ms_scan_file() and ms_parse_summary() to summarize
+		    records from their headers only.
+	ms_index.c: New file.  Added ms_index_build(), ms_index_open(),
+		    ms_index_close() and ms_index_query() for a persistent
+		    sorted index of MiniSEED files.
+	ms_scan.c:  Do not print errors for non-MiniSEED data.
+	ms_extract.c: New file.  Added ms_extract_window() and
+		    ms_extract_window_index() to extract a time window
+		    of samples, decoding only the records in the window.
+	ms_scan.c:  Added ms_seek_time() and ms_seek_time_fd() to find a
+		    time in a file by bisection on record headers.
+	ms_extract.c: Use ms_seek_time() to skip records before the window.
+	ms_utils.c: Added read_ms_at(), read_ms_record_at() and _ctx
+		    versions to read records at an offset with pread.
+	ms_utils.c: Added parse_ms(), parse_ms_record() and _ctx versions
+		    to parse records in memory.
+	ms_scan.c:  Added ms_record_length().
+	ms_stream.c: New file.  Added ms_stream_push(), ms_stream_next()
+		    and related routines to split a byte stream into records.
+	ms_scan.c:  Added ms_resync() and ms_resync_buf() to find the next
+		    plausible record header in corrupt data.
+	ms_stream.c: Added ms_stream_resync().
+	ms_utils.c: Check blockette and data offsets against the record
+		    buffer in read_ms_hdr() and read_ms_bkt().
+	unpack.c:   Check the number of samples against the data size in
+		    unpack_int_16(), _24(), _32(), unpack_fp_sp() and _dp().
+	ms_reader.c: New file.  Added ms_reader_open(), ms_reader_next(),
+		    ms_reader_read_ms() and ms_reader_close() to read
+		    records with stdio, mmap, gzip or zstd backends and
+		    optional read-ahead.  gzip and zstd support are
+		    enabled with -DHAVE_ZLIB and -DHAVE_ZSTD (Makefile CZIP).
+	ms_demux.c: New file.  Added ms_demux_record(), ms_demux_reader(),
+		    ms_demux_file() and related routines to route records
+		    into per-channel sample buffers and flag gaps and
+		    overlaps.
+	ms_trace.c: New file.  Added ms_trace_add_hdr(), ms_trace_gaps()
+		    and related routines to assemble records into
+		    continuous segments, with or without their samples.
+	ms_sort.c:  New file.  Added ms_sort_files() to sort records by
+		    channel and time and drop duplicates, with bounded
+		    memory and temporary run files.
+	ms_sncl.c:  New file.  Added ms_sncl_id(), ms_sncl_find(),
+		    ms_sncl_name(), ms_sncl_count() and ms_sncl_free()
+		    to intern channel names as integer ids.
+	data_hdr.h: Added the DATA_HDR sncl_id field, which is assigned
+		    on first use by the routines that group records by
+		    channel.
+	ms_demux.c: Find channels by SNCL id instead of a name hash.
+	ms_trace.c: Find traces by SNCL id instead of name comparisons.
+	ms_scan.c:  Added ms_decode_headers_soa(), ms_hdr_soa_init() and
+		    ms_hdr_soa_free() to decode the headers of many
+		    records into parallel arrays.
+	ms3.c:	    New routines to read and write FDSN miniSEED 3 records
+		    with the existing Steim, integer and floating point
+		    routines, a CRC-32C that uses the CPU crc32c
+		    instructions when available, and ms2_to_ms3() and
+		    ms3_to_ms2() to convert between SEED 2 and miniSEED 3.
+	ms_qc.c:    New routine ms_steim_qc() to summarize flatlines,
+		    constant records and difference sizes of a Steim
+		    record from its control words, without decoding it.
+	ms_qc.c:    Added ms_unpack_stats() and ms_record_stats() to
+		    compute the min, max, mean and RMS of the samples
+		    of a record while decoding it, or without decoding
+		    it into a buffer.
+	sdr_utils.c: Added decode_hdr_sdr_into() to decode a header into
+		    a caller supplied DATA_HDR without allocating memory.
+	ms_pipeline.c: Decode headers into DATA_HDRs kept in the pipeline
+		    slots instead of allocating a DATA_HDR per record.
+	ms_extract.c: ms_extract_window() and ms_extract_window_index()
+		    require a fully specified channel without wildcards,
+		    and the header scan stops at the first record of
+		    the channel after t1.
+	ms_pack2.c: ms_pack2_update_hdr() advances the header time with the
+		    sample clock from an anchor kept in the new DATA_HDR
+		    clock_anchor and clock_index fields, so the time does not
+		    drift across successive calls.
 1.58    2022.020    DSN
         qtime.c:    Rename det_time_to_int_time to det_time_to_ext_time.
 		    Fixed det_time_to_ext_time time calculation.
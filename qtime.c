@@ -45,6 +45,8 @@
 #include <sys/param.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
 
 #include "qdefines.h"
 #include "qutils.h"
@@ -93,6 +95,25 @@ char	    *MON[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
 int	    DPM[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 int	    DOY [] = { 0, 31, 59, 90,120,151,181,212,243,273,304,334,365 };
 
+/*		Month of each day of year (for leap years).		*/
+#define	M7(m)	m,m,m,m,m,m,m
+#define	M28(m)	M7(m),M7(m),M7(m),M7(m)
+#define	M29(m)	M28(m),m
+#define	M30(m)	M29(m),m
+#define	M31(m)	M30(m),m
+static const unsigned char LMONTH[367] = { 0,
+    M31(1), M29(2), M31(3), M30(4), M31(5), M30(6),
+    M31(7), M31(8), M30(9), M31(10), M30(11), M31(12) };
+#undef	M7
+#undef	M28
+#undef	M29
+#undef	M30
+#undef	M31
+
+#define	DAYS_PER_400_YEARS  146097
+#define	DAYS_PER_100_YEARS  36524
+#define	DAYS_PER_4_YEARS    1461
+
 /************************************************************************/
 /*  Leapseconds.							*/
 /*	In order to handle leapseconds, we have to keep a table of when	*/
@@ -121,81 +142,535 @@ typedef struct lsinfo {
 struct lstable {
     int		initialized;	/*  Leap second table inited?		*/
     int		nleapseconds;	/*  Total leap second entries.		*/
+    int		status;		/*  Status from loading the table.	*/
+    int		load_error;	/*  Table could not be fully loaded.	*/
     char	tag_str[LEAPLINELEN+1];	    /*  expiration tag          */
     char	valid_to_str[LEAPLINELEN+1];/*  Valid to date string.	*/
     time_t	valid_to_sec;	/*  Valid to seconds.			*/
     LSINFO	lsinfo[TZ_MAX_LEAPS];
 				/*  Info for each leapsecond.		*/
-} lstable = {0};
+    struct lstable *prev;	/*  Previous (retired) table.		*/
+};
+
+/************************************************************************/
+/* NOTES on lstable:							*/
+/*  1.	For positive leapseconds:					*/
+/*	nepoch is the nominal epoch value of the next non-leapsecond.	*/
+/*	All other time representations are valid times for this second.	*/
+/*  2.  For negative leapseconds:					*/
+/*	The issue here is that this represents a NON-EXISTANT SECOND.	*/
+/*	exttime is NOT a valid time.  When normalized, it converts to	*/
+/*	the next valid second.						*/
+/*	tepoch is value of the normalized time (eg the next valid sec).	*/
+/*	nepoch is nominal epoch value of the (invalid) leapsecond.	*/
+/*	inttime is the value of the normalized time.			*/
+/*  There are inherint ambiguities, because an EXT_TIME entry for a 	*/
+/*  negative leapsecond is by definition NOT a valid time.		*/
+/*  However, an INT_TIME value and a tepoch value CANNOT represent a	*/
+/*  invalid time, so they must represent to the next valid second.	*/
+/************************************************************************/
+
+/************************************************************************/
+/*  Leap second table management.					*/
+/*	The current table is published through the pointer lstablep.	*/
+/*	A table is never modified once it has been published.  The	*/
+/*	first table is loaded exactly once by pthread_once(), either	*/
+/*	from the leapseconds file or from the default table compiled	*/
+/*	into the library.  reload_leap_second_table() builds a new	*/
+/*	table and atomically replaces the published pointer.  Retired	*/
+/*	tables are kept, since other threads may still be using them.	*/
+/************************************************************************/
+
+#if defined(__GNUC__)
+#define	LOAD_TABLE_PTR(p)	__atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define	STORE_TABLE_PTR(p,v)	__atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+#define	LOAD_TABLE_PTR(p)	(p)
+#define	STORE_TABLE_PTR(p,v)	((p) = (v))
+#endif
+
+static struct lstable empty_lstable = {1};
+static struct lstable *lstablep = NULL;
+static pthread_once_t lstable_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t lstable_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*  Default leap second table, generated at build time from the		*/
+/*  leapseconds file distributed with qlib2.				*/
+static char *default_leapseconds[] = {
+#include "leapseconds_tbl.h"
+    NULL
+};
+#define	DEFAULT_LEAP_FILE	"(compiled-in leapseconds)"
+
+static int parse_date_ext (EXT_TIME *pet, char *str);
+
+/************************************************************************/
+/*  lp_leap_second:							*/
+/*	Return lsinfo structure if this second is in leap second table.	*/
+/************************************************************************/
+static LSINFO *lp_leap_second
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME it)		/* INT_TIME structure			*/
+{
+    int		i;
+    /*	Search leap second table.   */
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	if (it.year == lt->lsinfo[i].inttime.year &&
+	    it.second == lt->lsinfo[i].inttime.second)
+	    return (&lt->lsinfo[i]);
+    }
+    return(NULL);
+}
+
+/************************************************************************/
+/*  lp_leap_second_t:							*/
+/*	Return lsinfo structure if true second is in leap second table.	*/
+/************************************************************************/
+static LSINFO *lp_leap_second_t
+   (struct lstable *lt,		/* leap second table.			*/
+    double tepoch)		/* True epoch time			*/
+{
+    int		i;
+    /*	Search leap second table.   */
+    tepoch = floor(tepoch);
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	if (tepoch == lt->lsinfo[i].tepoch)
+	    return (&lt->lsinfo[i]);
+    }
+    return(NULL);
+}
+
+/************************************************************************/
+/*  lp_leap_second_n:							*/
+/*	Return lsinfo structure if nominal second is in leap second table*/
+/************************************************************************/
+static LSINFO *lp_leap_second_n
+   (struct lstable *lt,		/* leap second table.			*/
+    double nepoch)		/* Nominal epoch time			*/
+{
+    int		i;
+    /*	Search leap second table.   */
+    nepoch = floor(nepoch);
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	if (nepoch == lt->lsinfo[i].nepoch)
+	    return (&lt->lsinfo[i]);
+    }
+    return(NULL);
+}
+
+/************************************************************************/
+/*  prior_leaps_in_ext_time:						*/
+/*	Return the number of leap seconds that must be added to this	*/
+/*	EXT_TIME in order to compute the accurate number of seconds	*/
+/*	within the year.						*/
+/************************************************************************/
+static int prior_leaps_in_ext_time
+   (struct lstable *lt,		/* leap second table.			*/
+    EXT_TIME	et)		/* EXT_TIME time structure.		*/
+{
+    LSINFO	*p;
+    int		i;
+    int		result = 0;
+
+    if ((et.year < 1970) ||
+	((i=lt->nleapseconds) == 0) ||
+	(et.year > lt->lsinfo[i-1].inttime.year)) return(result);
+    /* Search the leapsecond table backwards. */
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	p = &lt->lsinfo[i];
+	if (et.year > p->exttime.year) break;
+	if (et.year == p->exttime.year &&
+	    (et.doy > p->exttime.doy ||
+	     (et.doy == p->exttime.doy &&
+	      (et.hour > p->exttime.hour ||
+	       (et.hour == p->exttime.hour &&
+		(et.minute > p->exttime.minute ||
+		 (et.minute == p->exttime.minute &&
+		  (et.second > p->exttime.second))))))))
+	    result += p->leap_value;
+    }
+    return(result);
+}
+
+/************************************************************************/
+/*  prior_leaps_in_int_time:						*/
+/*	Return the accumulated number of leap seconds in this year	*/
+/*	prior to time.							*/
+/************************************************************************/
+static int prior_leaps_in_int_time
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME	it)		/* INT_TIME structure.			*/
+{
+    /*	Return the number of leap seconds that occurred prior to this 	*/
+    /*	time within this year.						*/
+    LSINFO	*p;
+    int		i;
+    int		result = 0;
+
+    if ((it.year < 1970) ||
+	((i=lt->nleapseconds) == 0) ||
+	(it.year > lt->lsinfo[i-1].inttime.year)) return(result);
+    /* Search the leapsecond table backwards. */
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	p = &lt->lsinfo[i];
+	if (it.year > p->inttime.year) break;
+	if (it.year == p->inttime.year &&
+	    (it.second > p->inttime.second))
+	    result += p->leap_value;
+    }
+    return(result);
+}
+
+/************************************************************************/
+/*  sec_per_year_tbl:							*/
+/*	Return number of seconds in the year, accounting for 		*/
+/*	leap seconds in the specified table.				*/
+/************************************************************************/
+static int sec_per_year_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    int		year)		/* year (input).			*/
+{
+    int		i;
+    int		result = ( SEC_PER_DAY * (365 + IS_LEAP(year)) );
+
+    /*	Search leap second table.   */
+    if (lt->nleapseconds == 0 || year < lt->lsinfo[0].inttime.year ||
+	year > lt->lsinfo[lt->nleapseconds-1].inttime.year) return (result);
+    for (i=0; i<lt->nleapseconds; i++) {
+	if (year == lt->lsinfo[i].inttime.year)
+	    result += lt->lsinfo[i].leap_value;
+    }
+    return(result);
+}
+
+/************************************************************************/
+/*  normalize_time_tbl:							*/
+/*  	Normalize an INT_TIME time structure using the specified table.	*/
+/************************************************************************/
+static INT_TIME normalize_time_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME	it)		/* INT_TIME to normalize.   		*/
+{
+    int		s_p_y;
+
+    while (it.usec < 0) {
+	--(it.second);
+	it.usec += USECS_PER_SEC;
+    }
+    while (it.usec >= USECS_PER_SEC) {
+	++(it.second);
+	it.usec -= USECS_PER_SEC;
+    }
+    while (it.second < 0) {
+	--(it.year);
+	it.second += sec_per_year_tbl(lt, it.year);
+    }
+    while (it.second >= (s_p_y = sec_per_year_tbl(lt, it.year))) {
+	it.second -= s_p_y;
+	++(it.year);
+    }
+    return(it);
+}
+
+static INT_TIME ext_to_int_tbl (struct lstable *lt, EXT_TIME et);
+static EXT_TIME int_to_ext_leaps (INT_TIME it, int leaps, LSINFO *lp);
+
+/************************************************************************/
+/*  int_to_ext_tbl:							*/
+/*	Convert internal time to external time using the specified	*/
+/*	leap second table.						*/
+/************************************************************************/
+static EXT_TIME int_to_ext_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME	it)		/* INT_TIME to convert to EXT_TIME.	*/
+{
+    int		leaps;
+    LSINFO	*lp;
+
+    /*	Add or remove leap seconds that occur before this time within	*/
+    /*	the year so that we can convert it to a string using code	*/
+    /*	that is independent of leapseconds.  The only trick is that	*/
+    /*	if the time is an exact leapsecond, we have to know it, since	*/
+    /*	second 60 would normally be considered second 0 of the next	*/
+    /*	minute.								*/
+    /*  If the time is a "negative leap second", we just add 1 second	*/
+    /*  to accomodate the skip.	 Since the time should be initially	*/
+    /*	normalized, we can never represent a negative leapsecond at	*/
+    /*	the end of the year, so we don't have to worry about		*/
+    /*	re-normalizing and possibly crossing year boundaries.		*/
+
+    leaps = prior_leaps_in_int_time (lt, it);
+    lp = lp_leap_second (lt, it);
+    return (int_to_ext_leaps (it, leaps, lp));
+}
+
+/************************************************************************/
+/*  int_to_ext_leaps:							*/
+/*	Convert internal time to external time, given the number of	*/
+/*	leap seconds earlier in the year and the leap second entry (if	*/
+/*	any) for this second.						*/
+/************************************************************************/
+static EXT_TIME int_to_ext_leaps
+   (INT_TIME	it,		/* INT_TIME to convert to EXT_TIME.	*/
+    int		leaps,		/* leap seconds prior to it in year.	*/
+    LSINFO	*lp)		/* leap second entry for it, or NULL.	*/
+{
+    EXT_TIME et;
+
+    et.year = it.year;
+    et.second = it.second;
+    et.second = et.second - leaps;
+    if (lp && (lp->leap_value < 0))
+	/*  For a missing second, adjust accordingly.			*/
+	et.second = et.second - lp->leap_value;
+
+    if (lp && lp->leap_value > 0) {
+	/*  This corresponds to an entry for a positive leap_second.	*/
+	/*  If it is an added second, use the info in the returned	*/
+	/*  leap_second structure for computing the external date.	*/
+	et.doy = lp->exttime.doy;
+	et.month = lp->exttime.month;
+	et.day = lp->exttime.day;
+	et.hour = lp->exttime.hour;
+	et.minute = lp->exttime.minute;
+	et.second = lp->exttime.second;
+    }
+    else {
+	et.doy = (et.second / SEC_PER_DAY) + 1;
+	et.second = et.second % SEC_PER_DAY;
+	et.hour = et.second / SEC_PER_HOUR;
+	et.second = et.second % SEC_PER_HOUR;
+	et.minute = et.second / SEC_PER_MINUTE;
+	et.second = et.second % SEC_PER_MINUTE;
+    }
+    et.usec = it.usec;
+    dy_to_mdy (et.doy, et.year, &et.month, &et.day);
+    return (et);
+}
+
+/************************************************************************/
+/*  floor_div:								*/
+/*	Integer division rounded towards negative infinity.		*/
+/************************************************************************/
+static int floor_div
+   (int		a,		/* dividend.				*/
+    int		b)		/* divisor (positive).			*/
+{
+    int q = a / b;
+    if (a % b < 0) --q;
+    return (q);
+}
+
+/************************************************************************/
+/*  days_before_year:							*/
+/*	Return the number of days from Jan 1 of year 1 to Jan 1 of	*/
+/*	the specified year in the proleptic Gregorian calendar.		*/
+/************************************************************************/
+static int days_before_year
+   (int		year)		/* year (input).			*/
+{
+    int y = year - 1;
+    return (365 * y + floor_div(y, 4) - floor_div(y, 100) + floor_div(y, 400));
+}
+
+/************************************************************************/
+/*  year_doy_from_days:							*/
+/*	Convert a day count from Jan 1 of year 1 to year and doy.	*/
+/*	Inverse of days_before_year.					*/
+/************************************************************************/
+static void year_doy_from_days
+   (int		days,		/* days since Jan 1 of year 1.		*/
+    int		*year,		/* year (returned).			*/
+    int		*doy)		/* day of year (returned).		*/
+{
+    int n400, n100, n4, n1;
+
+    n400 = floor_div (days, DAYS_PER_400_YEARS);
+    days -= n400 * DAYS_PER_400_YEARS;
+    n100 = days / DAYS_PER_100_YEARS;
+    if (n100 == 4) n100 = 3;	/* Dec 31 of a 400th year.		*/
+    days -= n100 * DAYS_PER_100_YEARS;
+    n4 = days / DAYS_PER_4_YEARS;
+    days -= n4 * DAYS_PER_4_YEARS;
+    n1 = days / 365;
+    if (n1 == 4) n1 = 3;	/* Dec 31 of a leap year.		*/
+    days -= n1 * 365;
+    *year = 400 * n400 + 100 * n100 + 4 * n4 + n1 + 1;
+    *doy = days + 1;
+}
+
+/************************************************************************/
+/*  normalize_ext_tbl:							*/
+/*	Normalize time in an EXT_TIME structure using the specified	*/
+/*	leap second table.						*/
+/************************************************************************/
+static EXT_TIME normalize_ext_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    EXT_TIME	et)		/* EXT_TIME to normalize.		*/
+{
+    int		n;
+
+    /*  Normalize external time from the minute up.			*/
+    if (et.minute < 0 || et.minute >= 60) {
+	n = floor_div (et.minute, 60);
+	et.minute -= n * 60;
+	et.hour += n;
+    }
+    if (et.hour < 0 || et.hour >= 24) {
+	n = floor_div (et.hour, 24);
+	et.hour -= n * 24;
+	et.doy += n;
+    }
+    if (et.doy <= 0 || et.doy > DAYS_PER_YEAR(et.year)) {
+	n = days_before_year (et.year) + et.doy - 1;
+	year_doy_from_days (n, &et.year, &et.doy);
+    }
+    dy_to_mdy (et.doy, et.year, &et.month, &et.day);
+    /* Now worry about seconds, which may span a leap day.		*/
+    /* A second within 0-58 cannot span a day or a leap second.	*/
+    /* Otherwise, for efficiency:					*/
+    /* 1.  Convert time (ignoring second and usec) to int_time.		*/
+    /* 2. Add second and usec field, the reconvert to ext_time.		*/
+    if (et.second >= 0 && et.second < 59 && 
+	et.usec >= 0 && et.usec < USECS_PER_SEC) {
+	return (et);
+    }
+    if (et.second || et.usec) {
+	EXT_TIME et2;
+	INT_TIME it2;
+	et2 = et;
+	et2.second = et2.usec = 0;
+	it2 = ext_to_int_tbl(lt, et2);
+	it2.second += et.second;
+	it2.usec += et.usec;
+	it2 = normalize_time_tbl(lt, it2);
+	et = int_to_ext_tbl(lt, it2);
+    }
+    return (et);
+}
+
+/************************************************************************/
+/*  ext_to_int_tbl:							*/
+/*	Convert external time to internal time using the specified	*/
+/*	leap second table.						*/
+/************************************************************************/
+static INT_TIME ext_to_int_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    EXT_TIME	et)		/* EXT_TIME to convert to INT_TIME.	*/
+{
+    INT_TIME	it, it2;
+    int		leaps;
+
+    et = normalize_ext_tbl(lt, et);
+    leaps = prior_leaps_in_ext_time (lt, et);
+    it.year = et.year;
+    it.second = (et.doy-1) * (int)SEC_PER_DAY +
+		et.hour * (int)SEC_PER_HOUR +
+		et.minute * (int)SEC_PER_MINUTE +
+		et.second + leaps;
+    it.usec = et.usec;
+    it2 = normalize_time_tbl(lt, it);
+    return (it2);
+}
+
+/************************************************************************/
+/*  int_to_tepoch_tbl:							*/
+/*	Convert internal time to true epoch time using the specified	*/
+/*	leap second table.						*/
+/************************************************************************/
+static double int_to_tepoch_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME	it)		/* INT_TIME to convert to True epoch.	*/
+{
+    double	tepoch = 0.0;
+    int		year = 1970;
+
+    while (it.year < year) {
+	tepoch -= sec_per_year_tbl(lt, --year);
+    }
+    while (it.year > year) {
+	tepoch += sec_per_year_tbl(lt, year++);
+    }
+    tepoch += it.second;
+    tepoch += ((double)it.usec / (double)USECS_PER_SEC);
+    return(tepoch);
+}
+
+/************************************************************************/
+/*  int_to_nepoch_tbl:							*/
+/*	Convert internal time to nominal epoch time using the specified	*/
+/*	leap second table.						*/
+/************************************************************************/
+static double int_to_nepoch_tbl
+   (struct lstable *lt,		/* leap second table.			*/
+    INT_TIME	it)		/* INT_TIME to convert to Nominal epoch.*/
+{
+    double	nepoch = 0.0;
+    int		year = 1970;
+    int		leaps;
+
+    while (it.year < year) {
+	nepoch -= nsec_per_year(--year);
+    }
+    while (it.year > year) {
+	nepoch += nsec_per_year(year++);
+    }
+    nepoch += it.second;
+    nepoch += ((double)it.usec / (double)USECS_PER_SEC);
+    /* Adjust by the number of leapseconds that preceed this time	*/
+    /* within this year. */
+    leaps = prior_leaps_in_int_time (lt, it);
+    nepoch -= leaps;
+    return(nepoch);
+}
 
 /************************************************************************/
-/* NOTES on lstable:							*/
-/*  1.	For positive leapseconds:					*/
-/*	nepoch is the nominal epoch value of the next non-leapsecond.	*/
-/*	All other time representations are valid times for this second.	*/
-/*  2.  For negative leapseconds:					*/
-/*	The issue here is that this represents a NON-EXISTANT SECOND.	*/
-/*	exttime is NOT a valid time.  When normalized, it converts to	*/
-/*	the next valid second.						*/
-/*	tepoch is value of the normalized time (eg the next valid sec).	*/
-/*	nepoch is nominal epoch value of the (invalid) leapsecond.	*/
-/*	inttime is the value of the normalized time.			*/
-/*  There are inherint ambiguities, because an EXT_TIME entry for a 	*/
-/*  negative leapsecond is by definition NOT a valid time.		*/
-/*  However, an INT_TIME value and a tepoch value CANNOT represent a	*/
-/*  invalid time, so they must represent to the next valid second.	*/
+/*  next_leap_line:							*/
+/*	Return the next line of a leapsecond file, read either from	*/
+/*	an open file or from the compiled-in default table.		*/
+/*  return:								*/
+/*	ptr to line on success, NULL at end of input.			*/
 /************************************************************************/
+static char *next_leap_line
+   (char	*line,		/* buffer for line (LEAPLINELEN+1).	*/
+    FILE	*lf,		/* FILE ptr, or NULL for default table.	*/
+    char	***pp)		/* ptr to ptr to next default line.	*/
+{
+    if (lf) return (fgets(line,LEAPLINELEN,lf));
+    if (**pp == NULL) return (NULL);
+    strncpy (line, **pp, LEAPLINELEN);
+    line[LEAPLINELEN] = '\0';
+    ++(*pp);
+    return (line);
+}
 
 /************************************************************************/
-/*  init_leap_second_table:						*/
-/*	Initialize leap second table from external file.		*/
-/*  Return: 0 on success, 1 on warning, -1 on error.			*/
+/*  load_leap_second_table:						*/
+/*	Load a leap second table from a file, or from the compiled-in	*/
+/*	default table if lf is NULL.					*/
+/*  Return: 0 on success, 1 on warning, -1 or QLIB2_TIME_ERROR on error.*/
 /************************************************************************/
-int init_leap_second_table ()
+static int load_leap_second_table
+   (struct lstable *lt,		/* leap second table to fill in.	*/
+    FILE	*lf,		/* FILE ptr, or NULL for default table.	*/
+    char	*leap_file)	/* name of leapsecond file.		*/
 {
-    FILE    *lf;
     char    line[LEAPLINELEN+1], keywd[10], s_month[10], corr[10], type[10];
     int	    i, l, ls, n, delta_second;
     int	    lnum = 0;
-    char    leap_file[MAXPATHLEN];
     char    *ep;
+    char    **dp = default_leapseconds;
     LSINFO  *p;
     EXT_TIME et;
-    struct stat stat_buf;
-    static int status = 0;
+    int status = 0;
     INT_TIME prev_inttime;
     INT_TIME inttime_epoch_origin = {1970,0,0};
-    double sdif;
     int edp = strlen(EXPIRATION_TAG);
 
-    if (lstable.initialized) return (status);
-    lstable.initialized = 1;
-
-#ifdef	NO_LEAPSECONDS
-    /* If people want to use qlib2 without leapsecond inclusion,	*/
-    /* they can define NO_LEAPSECONDS in the Makefile.			*/
-    if (1) return (status);
-#endif
-
-    /*	If the environment variable LEAPSECONDS exists, it should	*/
-    /*	override the default LEAPSECONDS file.				*/
-    if ((ep=getenv("LEAPSECONDS"))!=NULL)
-	strcpy(leap_file,ep);
-    else strcpy(leap_file, LEAPSECONDS);
-
-    /* Check to make leapsecond is either a file or char device.	*/
-    if (stat(leap_file, &stat_buf) == 0 && 
-	! (S_ISREG(stat_buf.st_mode) || S_ISCHR(stat_buf.st_mode))) {
-	fprintf (stderr, "Error: invalid leapsecond file %s\n", leap_file);
-	return (-1);
-    }
-
-    if ((lf=fopen(leap_file, "r"))==NULL) {
-	fprintf (stderr, "Warning: unable to open leap second file: %s\n",leap_file);
-	return (1);
-    }
+    memset ((void *)lt, 0, sizeof(struct lstable));
+    lt->initialized = 1;
 
-    while (status == 0 && fgets(line,LEAPLINELEN,lf)!=NULL) {
+    while (status == 0 && next_leap_line(line,lf,&dp)!=NULL) {
 	++lnum;
 	line[LEAPLINELEN]='\0';
 	trim(line);
@@ -203,21 +678,21 @@ int init_leap_second_table ()
 	if (l>0 && line[l-1]=='\n') line[--l] = '\0';
 
 	/* Look for structured comment with expiration date. */
-	if (lstable.valid_to_str[0] == 0 && l>edp && strncmp(line,EXPIRATION_TAG,edp)==0) {
-	    strncpy(lstable.tag_str, line, LEAPLINELEN);
+	if (lt->valid_to_str[0] == 0 && l>edp && strncmp(line,EXPIRATION_TAG,edp)==0) {
+	    strncpy(lt->tag_str, line, LEAPLINELEN);
 	    ep = line+edp;
 	    while (strchr(":= \t",*ep)) ++ep;
-	    strncpy( lstable.valid_to_str, ep, LEAPLINELEN);
+	    strncpy( lt->valid_to_str, ep, LEAPLINELEN);
 	    continue;
 	}
 
 #ifdef EXPIRATION_TAG2
     // look for alternate expiration formats provided by OS
     // this can be a line starting with '#Expires' or 'Expires' without the preceeding comment character
-    if ( lstable.valid_to_str[0] == 0 &&
+    if ( lt->valid_to_str[0] == 0 &&
             (strncmp(line, EXPIRATION_TAG2, strlen(EXPIRATION_TAG2)) == 0 ||
              strncmp(line, EXPIRATION_TAG3, strlen(EXPIRATION_TAG3)) == 0) ) {
-        strncpy(lstable.tag_str, line, LEAPLINELEN);
+        strncpy(lt->tag_str, line, LEAPLINELEN);
         //fprintf( stdout, "Debug qtime.c: found RH keyword in line %s\n", line);
         int year, month, day, hour, minute, second;
         // date format is assumed to be yyyy mon dd hh:mm:ss
@@ -233,7 +708,7 @@ int init_leap_second_table ()
                 ++i;
             }
             sprintf(expire_string, "%04d/%02d/%02d %02d:%02d:%02d", year, month, day, hour, minute, second);
-            strncpy(lstable.valid_to_str, expire_string, LEAPLINELEN);
+            strncpy(lt->valid_to_str, expire_string, LEAPLINELEN);
             // fprintf( stdout, "Debug qtime.c: parsed expiration date as %s\n", expire_string);
         }
         continue;
@@ -241,16 +716,16 @@ int init_leap_second_table ()
 #endif //  EXPIRATION_TAG2
 
 	if (l<=0 || line[0]=='#') continue;
-	if ((ls=lstable.nleapseconds) >= TZ_MAX_LEAPS) {
+	if ((ls=lt->nleapseconds) >= TZ_MAX_LEAPS) {
 	    fprintf (stderr, "Error: too many leapsecond entries - line %d\n", lnum);
 	    fflush (stderr);
 	    if (QLIB2_CLASSIC) exit(1);
 	    status = QLIB2_TIME_ERROR;
 	    continue;
 	}
- 	p = &lstable.lsinfo[ls];
-	if ((l=sscanf(line,"%s %d %s %d %d:%d:%d %s %s", keywd, &p->exttime.year, 
-		      s_month, &p->exttime.day, &p->exttime.hour, &p->exttime.minute, 
+ 	p = &lt->lsinfo[ls];
+	if ((l=sscanf(line,"%s %d %s %d %d:%d:%d %s %s", keywd, &p->exttime.year,
+		      s_month, &p->exttime.day, &p->exttime.hour, &p->exttime.minute,
 		      &p->exttime.second, corr, type))!= 9) {
 	    fprintf (stderr, "Error: invalid leapsecond line - line %d\n", lnum);
 	    fflush (stderr);
@@ -284,7 +759,8 @@ int init_leap_second_table ()
 
 	/* Make sure we can handle consecutive leapseconds. */
 	/* Both leapseconds will map to the same nominal time. */
-	n = lstable.nleapseconds;
+	/* Conversions use the entries of this table loaded so far. */
+	n = lt->nleapseconds;
 	et = p->exttime;
 	if (p->leap_value == 1) {
 	    /* Positive leap second: */
@@ -293,9 +769,9 @@ int init_leap_second_table ()
 	    et = p->exttime;
 	    et.second = 59;
 	    delta_second = p->exttime.second - et.second;
-	    p->inttime = ext_to_int (et);
-	    p->tepoch = int_to_tepoch (p->inttime);
-	    p->nepoch = int_to_nepoch (p->inttime);
+	    p->inttime = ext_to_int_tbl (lt, et);
+	    p->tepoch = int_to_tepoch_tbl (lt, p->inttime);
+	    p->nepoch = int_to_nepoch_tbl (lt, p->inttime);
 	    /* Now define the values for this leapsecond. */
 	    /* Compute nominal and true epoch times for this second. */
 	    /* Nominal time for a POSITIVE leapsecond is defined as the */
@@ -303,18 +779,18 @@ int init_leap_second_table ()
 	    p->inttime.second += delta_second;
 	    p->tepoch += delta_second;
 	    p->nepoch += 1;
-	    p->total_offset = (n > 0) ? lstable.lsinfo[n-1].total_offset + p->leap_value : p->leap_value;
+	    p->total_offset = (n > 0) ? lt->lsinfo[n-1].total_offset + p->leap_value : p->leap_value;
 	}
-	else {	
+	else {
 	    /* Negative leap second: */
 	    /* Compute nominal and true epoch time of (worst case) last second with 1-1 mapping  */
 	    /* before this leap second. */
 	    et = p->exttime;
 	    et.second = 57; /* There can never be more than 2 consecutive negative leap seconds. */
 	    delta_second = p->exttime.second - et.second;
-	    p->inttime = ext_to_int (et);
-	    p->tepoch = int_to_tepoch (p->inttime);
-	    p->nepoch = int_to_nepoch (p->inttime);
+	    p->inttime = ext_to_int_tbl (lt, et);
+	    p->tepoch = int_to_tepoch_tbl (lt, p->inttime);
+	    p->nepoch = int_to_nepoch_tbl (lt, p->inttime);
 	    /* Now define the values for this leapsecond. */
 	    /* Compute nominal and true epoch times for this second. */
 	    /* Nominal time for a NEGATIVE leapsecond is defined as the */
@@ -322,12 +798,13 @@ int init_leap_second_table ()
 	    p->tepoch += delta_second;
 	    p->nepoch += delta_second;
 	    p->inttime.second += delta_second; /* IS THIS CORRECT ? */
-	    p->total_offset = (n > 0) ? lstable.lsinfo[n-1].total_offset + p->leap_value : p->leap_value;
+	    p->total_offset = (n > 0) ? lt->lsinfo[n-1].total_offset + p->leap_value : p->leap_value;
 	}
 	/* Sanity check - ensure entries are in increasing time order. */
-	prev_inttime = (n > 0) ? lstable.lsinfo[n-1].inttime : inttime_epoch_origin;
-	sdif = tdiff (p->inttime, prev_inttime) / USECS_PER_SEC;
-	if (sdif < 0) {
+	prev_inttime = (n > 0) ? lt->lsinfo[n-1].inttime : inttime_epoch_origin;
+	if (p->inttime.year < prev_inttime.year ||
+	    (p->inttime.year == prev_inttime.year &&
+	     p->inttime.second < prev_inttime.second)) {
 	    fprintf (stderr, "Error: leapsecond table not in increasing time order.\n");
 	    fprintf (stderr, "%s\n", line);
 	    fflush (stderr);
@@ -335,28 +812,34 @@ int init_leap_second_table ()
 	    status = QLIB2_TIME_ERROR;
 	    continue;
 	}
-	++lstable.nleapseconds;
+	++lt->nleapseconds;
     }
-    if (ferror(lf)) {
+    if (lf && ferror(lf)) {
 	fprintf (stderr, "Error: reading leap second file: %s\n",leap_file);
 	status = -1;
     }
-	
+    if (status != 0) {
+	lt->load_error = 1;
+	return (status);
+    }
+
     /* Determine whether leapsecond table is still valid. */
-    if (lstable.nleapseconds > 0) {
-	if (lstable.valid_to_str[0]) {
+    /* The expiration date is parsed without reference to any leap	*/
+    /* second table, since it only needs to be compared to Unix time.	*/
+    if (lt->nleapseconds > 0) {
+	if (lt->valid_to_str[0]) {
 	    time_t now = time(NULL);
-	    INT_TIME *valid = parse_date(lstable.valid_to_str);
-	    if (valid == NULL) {
+	    EXT_TIME valid;
+	    if (parse_date_ext(&valid, lt->valid_to_str) != 0) {
 		fprintf (stderr, "Error: determining expiration date from '%s' in leap second file: %s\n",
-                lstable.tag_str, leap_file);
+                lt->tag_str, leap_file);
 		status = -1;
 	    }
 	    else {
-		lstable.valid_to_sec = unix_time_from_int_time(*valid);
-		if (now > lstable.valid_to_sec) {
+		lt->valid_to_sec = unix_time_from_ext_time(valid);
+		if (now > lt->valid_to_sec) {
 		    fprintf (stderr, "Error: EXPIRED date '%s' in leap second file: %s\n",
-                    lstable.valid_to_str, leap_file);
+                    lt->valid_to_str, leap_file);
 		    status = -1;
 		}
 	    }
@@ -371,69 +854,155 @@ int init_leap_second_table ()
 	    status = 1;
 	}
     }
-    
-    fclose(lf);
     return (status);
 }
 
 /************************************************************************/
-/*  lp_leap_second:							*/
-/*	Return lsinfo structure if this second is in leap second table.	*/
+/*  build_leap_second_table:						*/
+/*	Allocate and load a new leap second table from the specified	*/
+/*	leapsecond file.  If leap_file is NULL, use the file specified	*/
+/*	by the LEAPSECONDS environment variable or the compile-time	*/
+/*	LEAPSECONDS file, and fall back to the compiled-in default	*/
+/*	table if that file does not exist.				*/
+/*  return:								*/
+/*	ptr to new table, or NULL if no table could be loaded.		*/
+/*	The load status is returned in the table.			*/
 /************************************************************************/
-static LSINFO *lp_leap_second
-   (INT_TIME it)		/* INT_TIME structure			*/
+static struct lstable *build_leap_second_table
+   (char	*leap_file,	/* leapsecond file, or NULL for default.*/
+    int		*pstatus)	/* returned status if no table.		*/
 {
-    int		i;
-    /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
+    FILE    *lf = NULL;
+    char    file[MAXPATHLEN];
+    char    *ep;
+    struct stat stat_buf;
+    struct lstable *lt;
+    int	    use_default = 0;
+
+    if (leap_file != NULL) {
+	strncpy (file, leap_file, MAXPATHLEN-1);
+	file[MAXPATHLEN-1] = '\0';
     }
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	if (it.year == lstable.lsinfo[i].inttime.year &&
-	    it.second == lstable.lsinfo[i].inttime.second)
-	    return (&lstable.lsinfo[i]);
+    /*	If the environment variable LEAPSECONDS exists, it should	*/
+    /*	override the default LEAPSECONDS file.				*/
+    else if ((ep=getenv("LEAPSECONDS"))!=NULL) {
+	strncpy (file, ep, MAXPATHLEN-1);
+	file[MAXPATHLEN-1] = '\0';
     }
-    return(NULL);
+    else {
+	strcpy(file, LEAPSECONDS);
+	/* Use the compiled-in table if the default file does not exist.*/
+	if (stat(file, &stat_buf) != 0) use_default = 1;
+    }
+
+    if (! use_default) {
+	/* Check to make leapsecond is either a file or char device.	*/
+	if (stat(file, &stat_buf) == 0 &&
+	    ! (S_ISREG(stat_buf.st_mode) || S_ISCHR(stat_buf.st_mode))) {
+	    fprintf (stderr, "Error: invalid leapsecond file %s\n", file);
+	    *pstatus = -1;
+	    return (NULL);
+	}
+	if ((lf=fopen(file, "r"))==NULL) {
+	    fprintf (stderr, "Warning: unable to open leap second file: %s\n",file);
+	    *pstatus = 1;
+	    return (NULL);
+	}
+    }
+    else strcpy (file, DEFAULT_LEAP_FILE);
+
+    if ((lt = (struct lstable *)malloc(sizeof(struct lstable))) == NULL) {
+	fprintf (stderr, "Error: unable to malloc leap second table\n");
+	fflush (stderr);
+	if (lf) fclose (lf);
+	if (QLIB2_CLASSIC) exit(1);
+	*pstatus = QLIB2_MALLOC_ERROR;
+	return (NULL);
+    }
+    lt->status = load_leap_second_table (lt, lf, file);
+    if (lf) fclose (lf);
+    *pstatus = lt->status;
+    return (lt);
 }
 
 /************************************************************************/
-/*  lp_leap_second_t:							*/
-/*	Return lsinfo structure if true second is in leap second table.	*/
+/*  init_leap_second_table_once:					*/
+/*	Load and publish the initial leap second table.  Called only	*/
+/*	through pthread_once().						*/
 /************************************************************************/
-static LSINFO *lp_leap_second_t
-   (double tepoch)		/* True epoch time			*/
+static void init_leap_second_table_once ()
 {
-    int		i;
-    /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    tepoch = floor(tepoch);
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	if (tepoch == lstable.lsinfo[i].tepoch)
-	    return (&lstable.lsinfo[i]);
+    struct lstable *lt = NULL;
+    int status = 0;
+
+#ifndef	NO_LEAPSECONDS
+    lt = build_leap_second_table (NULL, &status);
+#endif
+    /* If people want to use qlib2 without leapsecond inclusion,	*/
+    /* they can define NO_LEAPSECONDS in the Makefile.			*/
+    if (lt == NULL) {
+	empty_lstable.status = status;
+	lt = &empty_lstable;
     }
-    return(NULL);
+    STORE_TABLE_PTR (lstablep, lt);
 }
 
 /************************************************************************/
-/*  lp_leap_second_n:							*/
-/*	Return lsinfo structure if nominal second is in leap second table*/
+/*  leap_table:								*/
+/*	Return the current leap second table, initializing it if	*/
+/*	necessary.  Callers should use the returned table for the	*/
+/*	duration of a conversion.					*/
 /************************************************************************/
-static LSINFO *lp_leap_second_n
-   (double nepoch)		/* Nominal epoch time			*/
+static struct lstable *leap_table ()
 {
-    int		i;
-    /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    nepoch = floor(nepoch);
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	if (nepoch == lstable.lsinfo[i].nepoch)
-	    return (&lstable.lsinfo[i]);
-    }
-    return(NULL);
+    pthread_once (&lstable_once, init_leap_second_table_once);
+    return (LOAD_TABLE_PTR(lstablep));
+}
+
+/************************************************************************/
+/*  init_leap_second_table:						*/
+/*	Initialize leap second table from external file, or from the	*/
+/*	compiled-in table if the leapsecond file does not exist.	*/
+/*	It is safe to call this from multiple threads.			*/
+/*  Return: 0 on success, 1 on warning, -1 on error.			*/
+/************************************************************************/
+int init_leap_second_table ()
+{
+    return (leap_table()->status);
+}
+
+/************************************************************************/
+/*  reload_leap_second_table:						*/
+/*	Load a new leap second table and atomically replace the current	*/
+/*	table.  If leap_file is NULL, reload the table from the default	*/
+/*	location.  The current table is retained if the new table	*/
+/*	cannot be opened or contains errors.  Conversions already in	*/
+/*	progress in other threads complete using the previous table.	*/
+/*  Return: 0 on success, 1 on warning, negative value on error.	*/
+/************************************************************************/
+int reload_leap_second_table
+   (char	*leap_file)	/* leapsecond file, or NULL for default.*/
+{
+    struct lstable *lt;
+    int status = 0;
+
+    (void)leap_table();
+#ifdef	NO_LEAPSECONDS
+    if (1) return (status);
+#endif
+    pthread_mutex_lock (&lstable_mutex);
+    lt = build_leap_second_table (leap_file, &status);
+    if (lt != NULL && lt->load_error) {
+	/* Keep the current table.					*/
+	free ((char *)lt);
+	lt = NULL;
+    }
+    if (lt != NULL) {
+	lt->prev = lstablep;
+	STORE_TABLE_PTR (lstablep, lt);
+    }
+    pthread_mutex_unlock (&lstable_mutex);
+    return (status);
 }
 
 /************************************************************************/
@@ -445,7 +1014,7 @@ int is_leap_second
 {
     LSINFO *lp;
     int leap_value = 0;
-    if ((lp=lp_leap_second(it))) leap_value = lp->leap_value;
+    if ((lp=lp_leap_second(leap_table(),it))) leap_value = lp->leap_value;
     return leap_value;
 }
 
@@ -458,7 +1027,7 @@ int is_leap_second_te
 {
     LSINFO *lp;
     int leap_value = 0;
-    if ((lp=lp_leap_second_t(tepoch))) leap_value = lp->leap_value;
+    if ((lp=lp_leap_second_t(leap_table(),tepoch))) leap_value = lp->leap_value;
     return leap_value;
 }
 
@@ -471,118 +1040,30 @@ int is_leap_second_ne
 {
     LSINFO *lp;
     int leap_value = 0;
-    if ((lp=lp_leap_second_n(nepoch))) leap_value = lp->leap_value;
+    if ((lp=lp_leap_second_n(leap_table(),nepoch))) leap_value = lp->leap_value;
     return leap_value;
 }
 
-#if 0
-/************************************************************************/
-/*  sec_per_min:							*/
-/*	Return the number of seconds in this minute.			*/
-/************************************************************************/
-static int sec_per_min
-   (EXT_TIME	et)		/* EXT_TIME structure to convert.	*/
-{
-    /*	Search leap second table.   */
-    int i;
-
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    for (i=0; i<lstable.nleapseconds; i++) {
-	if (et.year < lstable.lsinfo[i].exttime.year) break;
-	if (et.year == lstable.lsinfo[i].exttime.year &&
-	    et.month == lstable.lsinfo[i].exttime.month &&
-	    et.day == lstable.lsinfo[i].exttime.day &&
-	    et.hour == lstable.lsinfo[i].exttime.hour &&
-	    et.minute == lstable.lsinfo[i].exttime.minute)
-	    return (60+lstable.lsinfo[i].leap_value);
-    }
-    return(60);
-}
-#endif
-
-/************************************************************************/
-/*  prior_leaps_in_ext_time:						*/
-/*	Return the number of leap seconds that must be added to this	*/
-/*	EXT_TIME in order to compute the accurate number of seconds	*/
-/*	within the year.						*/
-/************************************************************************/
-static int prior_leaps_in_ext_time
-   (EXT_TIME	et)		/* EXT_TIME time structure.		*/
-{
-    LSINFO	*p;
-    int		i;
-    int		result = 0;
-
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    if ((et.year < 1970) ||
-	((i=lstable.nleapseconds) == 0) ||
-	(et.year > lstable.lsinfo[i-1].inttime.year)) return(result);
-    /* Search the leapsecond table backwards. */
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	p = &lstable.lsinfo[i];
-	if (et.year > p->exttime.year) break;
-	p = &lstable.lsinfo[i];
-	if (et.year == p->exttime.year && 
-	    (et.doy > p->exttime.doy ||
-	     (et.doy == p->exttime.doy &&
-	      (et.hour > p->exttime.hour ||
-	       (et.hour == p->exttime.hour &&
-		(et.minute > p->exttime.minute ||
-		 (et.minute == p->exttime.minute &&
-		  (et.second > p->exttime.second))))))))
-	    result += p->leap_value;
-    }
-    return(result);
-}
-
-/************************************************************************/
-/*  prior_leaps_in_int_time:						*/
-/*	Return the accumulated number of leap seconds in this year	*/
-/*	prior to time.							*/
-/************************************************************************/
-static int prior_leaps_in_int_time
-   (INT_TIME	it)		/* INT_TIME structure.			*/
-{
-    /*	Return the number of leap seconds that occurred prior to this 	*/
-    /*	time within this year.						*/
-    LSINFO	*p;
-    int		i;
-    int		result = 0;
-
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    if ((it.year < 1970) ||
-	((i=lstable.nleapseconds) == 0) ||
-	(it.year > lstable.lsinfo[i-1].inttime.year)) return(result);
-    /* Search the leapsecond table backwards. */
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	p = &lstable.lsinfo[i];
-	if (it.year > p->inttime.year) break;
-	if (it.year == p->inttime.year && 
-	    (it.second > p->inttime.second))
-	    result += p->leap_value;
-    }
-    return(result);
-}
-
 /************************************************************************/
 /*  dy_to_mdy:								*/
 /*	Return month and day from day,year info.  Handle leap years.	*/
 /************************************************************************/
-void dy_to_mdy 
+void dy_to_mdy
    (int		doy,		/* day of year (input).			*/
     int		year,		/* year (input).			*/
     int		*month,		/* month of year (returned).		*/
     int		*mday)		/* day of month (returned).		*/
 {
+    int leap = IS_LEAP(year);
+    if (doy >= 1 && doy <= 365 + leap) {
+	/* Use the leap year table, skipping Feb 29 for non-leap years.	*/
+	*month = LMONTH[(leap || doy < 60) ? doy : doy + 1];
+	*mday = doy - LDOY(year,*month-1);
+	return;
+    }
     *month=1;
     *mday = doy;
-    while (doy > LDOY(year,*month)) ++*month;
+    while (*month < 12 && doy > LDOY(year,*month)) ++*month;
     *mday = doy - LDOY(year,*month-1);
 }
 
@@ -605,37 +1086,10 @@ int mdy_to_doy
 /*  return:								*/
 /*	Normalized EXT_TIME structure.					*/
 /************************************************************************/
-EXT_TIME normalize_ext 
+EXT_TIME normalize_ext
    (EXT_TIME	et)		/* EXT_TIME to normalize.		*/
 {
-    /*  Normalize external time from the minute up.			*/
-    while (et.minute >= 60) { et.minute -= 60; ++(et.hour); }
-    while (et.minute <   0) { et.minute += 60; --(et.hour); }
-    while (et.hour >= 24) { et.hour -= 24; ++(et.doy); }
-    while (et.hour <   0) { et.hour += 24; --(et.doy); }
-    while (et.doy > DAYS_PER_YEAR(et.year)) {
-	et.doy -= DAYS_PER_YEAR(et.year);
-	++(et.year);
-    }
-    while (et.doy <= 0) {
-	--(et.year);
-	et.doy += DAYS_PER_YEAR(et.year);
-    }
-    dy_to_mdy (et.doy, et.year, &et.month, &et.day);
-    /* Now worry about seconds, which may span a leap day.		*/
-    /* For efficiency:							*/
-    /* 1.  Convert time (ignoring second and usec) to int_time.		*/
-    /* 2. Add second and usec field, the reconvert to ext_time.		*/
-    if (et.second || et.usec) {
-	EXT_TIME et2;
-	INT_TIME it2;
-	et2 = et;
-	et2.second = et2.usec = 0;
-	it2 = ext_to_int(et2);
-	it2 = add_time(it2, et.second, et.usec);
-	et = int_to_ext(it2);
-    }
-    return (et);
+    return (normalize_ext_tbl(leap_table(), et));
 }
 
 /************************************************************************/
@@ -647,83 +1101,86 @@ EXT_TIME normalize_ext
 INT_TIME normalize_time
    (INT_TIME	it)		/* INT_TIME to normalize.   		*/
 {
-    int		s_p_y;
-
-    while (it.usec < 0) {
-	--(it.second);
-	it.usec += USECS_PER_SEC;
-    }
-    while (it.usec >= USECS_PER_SEC) {
-	++(it.second);
-	it.usec -= USECS_PER_SEC;
-    }
-    while (it.second < 0) {
-	--(it.year);
-	it.second += sec_per_year(it.year);
-    }
-    while (it.second >= (s_p_y = sec_per_year(it.year))) {
-	it.second -= s_p_y;
-	++(it.year);
-    }
-    return(it);
+    return (normalize_time_tbl(leap_table(), it));
 }
 
-/************************************************************************/
-/*  int_to_ext:								*/
-/*	Convert internal time to external time, accounting for		*/
-/*	leap seconds.							*/
-/*  return:								*/
-/*	EXT_TIME structure converted from input INT_TIME.		*/
-/************************************************************************/
-EXT_TIME int_to_ext
-   (INT_TIME	it)		/* INT_TIME to convert to EXT_TIME.	*/
-{
-    EXT_TIME et;
-    int		leaps;
-    LSINFO	*lp;
-
-    /*	Add or remove leap seconds that occur before this time within	*/
-    /*	the year so that we can convert it to a string using code	*/
-    /*	that is independent of leapseconds.  The only trick is that	*/
-    /*	if the time is an exact leapsecond, we have to know it, since	*/
-    /*	second 60 would normally be considered second 0 of the next	*/
-    /*	minute.								*/
-    /*  If the time is a "negative leap second", we just add 1 second	*/
-    /*  to accomodate the skip.	 Since the time should be initially	*/
-    /*	normalized, we can never represent a negative leapsecond at	*/
-    /*	the end of the year, so we don't have to worry about		*/
-    /*	re-normalizing and possibly crossing year boundaries.		*/
-
-    et.year = it.year;
-    et.second = it.second;
-    leaps = prior_leaps_in_int_time (it);
-
-    et.second = et.second - leaps;
-    if ((lp = lp_leap_second (it)) && (lp->leap_value < 0))
-	/*  For a missing second, adjust accordingly.			*/
-	et.second = et.second - lp->leap_value;
-
-    if (lp && lp->leap_value > 0) {
-	/*  This corresponds to an entry for a positive leap_second.	*/
-	/*  If it is an added second, use the info in the returned	*/
-	/*  leap_second structure for computing the external date.	*/
-	et.doy = lp->exttime.doy;
-	et.month = lp->exttime.month;
-	et.day = lp->exttime.day;
-	et.hour = lp->exttime.hour;
-	et.minute = lp->exttime.minute;
-	et.second = lp->exttime.second;
-    }
-    else {
-	et.doy = (et.second / SEC_PER_DAY) + 1;
-	et.second = et.second % SEC_PER_DAY;
-	et.hour = et.second / SEC_PER_HOUR;
-	et.second = et.second % SEC_PER_HOUR;
-	et.minute = et.second / SEC_PER_MINUTE;
-	et.second = et.second % SEC_PER_MINUTE;
-    }
-    et.usec = it.usec;
-    dy_to_mdy (et.doy, et.year, &et.month, &et.day);
+/************************************************************************/
+/*  int_to_ext:								*/
+/*	Convert internal time to external time, accounting for		*/
+/*	leap seconds.							*/
+/*  return:								*/
+/*	EXT_TIME structure converted from input INT_TIME.		*/
+/************************************************************************/
+EXT_TIME int_to_ext
+   (INT_TIME	it)		/* INT_TIME to convert to EXT_TIME.	*/
+{
+    return (int_to_ext_tbl(leap_table(), it));
+}
+
+/************************************************************************/
+/*  init_ext_cursor:							*/
+/*	Initialize an EXT_CURSOR to contain no cached day.		*/
+/************************************************************************/
+void init_ext_cursor
+   (EXT_CURSOR	*ec)		/* ptr to EXT_CURSOR.			*/
+{
+    ec->table = NULL;
+    ec->year = ec->start = ec->end = 0;
+    ec->doy = ec->month = ec->day = 0;
+}
+
+/************************************************************************/
+/*  int_to_ext_c:							*/
+/*	Convert internal time to external time, accounting for		*/
+/*	leap seconds, using the day cached in the EXT_CURSOR.		*/
+/*	Days that contain a leap second are never cached, so a cached	*/
+/*	day is always exactly SEC_PER_DAY seconds long.			*/
+/*  return:								*/
+/*	EXT_TIME structure converted from input INT_TIME.		*/
+/************************************************************************/
+EXT_TIME int_to_ext_c
+   (EXT_CURSOR	*ec,		/* ptr to EXT_CURSOR.			*/
+    INT_TIME	it)		/* INT_TIME to convert to EXT_TIME.	*/
+{
+    struct lstable *lt = leap_table();
+    EXT_TIME	et;
+    int		s, i;
+
+    if (ec->table == lt && it.year == ec->year && 
+	it.second >= ec->start && it.second < ec->end) {
+	/* Time is within the cached day.				*/
+	s = it.second - ec->start;
+	et.year = it.year;
+	et.doy = ec->doy;
+	et.month = ec->month;
+	et.day = ec->day;
+	et.hour = s / SEC_PER_HOUR;
+	s = s % SEC_PER_HOUR;
+	et.minute = s / SEC_PER_MINUTE;
+	et.second = s % SEC_PER_MINUTE;
+	et.usec = it.usec;
+	return (et);
+    }
+
+    et = int_to_ext_tbl(lt, it);
+    ec->table = NULL;
+    if (et.second >= 60) return (et);
+
+    /* Cache this day unless it contains a leap second.			*/
+    s = it.second - (et.hour * SEC_PER_HOUR + et.minute * SEC_PER_MINUTE + 
+		     et.second);
+    for (i=0; i<lt->nleapseconds; i++) {
+	if (lt->lsinfo[i].inttime.year == it.year &&
+	    lt->lsinfo[i].inttime.second >= s &&
+	    lt->lsinfo[i].inttime.second < s + SEC_PER_DAY) return (et);
+    }
+    ec->table = lt;
+    ec->year = it.year;
+    ec->start = s;
+    ec->end = s + SEC_PER_DAY;
+    ec->doy = et.doy;
+    ec->month = et.month;
+    ec->day = et.day;
     return (et);
 }
 
@@ -737,19 +1194,7 @@ EXT_TIME int_to_ext
 INT_TIME ext_to_int
    (EXT_TIME	et)		/* EXT_TIME to convert to INT_TIME.	*/
 {
-    INT_TIME	it, it2;
-    int		leaps;
-
-    et = normalize_ext(et);
-    leaps = prior_leaps_in_ext_time (et);
-    it.year = et.year;
-    it.second = (et.doy-1) * (int)SEC_PER_DAY +
-		et.hour * (int)SEC_PER_HOUR +
-		et.minute * (int)SEC_PER_MINUTE +
-		et.second + leaps;
-    it.usec = et.usec;
-    it2 = normalize_time(it);
-    return (it2);
+    return (ext_to_int_tbl(leap_table(), et));
 }
 
 /************************************************************************/
@@ -762,18 +1207,7 @@ INT_TIME ext_to_int
 double int_to_tepoch
    (INT_TIME	it)		/* INT_TIME to convert to True epoch.	*/
 {
-    double	tepoch = 0.0;
-    int		year = 1970;
-
-    while (it.year < year) {
-	tepoch -= sec_per_year(--year);
-    }
-    while (it.year > year) {
-	tepoch += sec_per_year(year++);
-    }
-    tepoch += it.second;
-    tepoch += ((double)it.usec / (double)USECS_PER_SEC);
-    return(tepoch);
+    return (int_to_tepoch_tbl(leap_table(), it));
 }
 
 /************************************************************************/
@@ -788,21 +1222,22 @@ INT_TIME tepoch_to_int
 {
     INT_TIME	it;
     int		s_p_y;
+    struct lstable *lt = leap_table();
 
     it.year = 1970;
     it.second = it.usec = 0;
     while (tepoch < 0) {
 	--(it.year);
-	tepoch += sec_per_year(it.year);
+	tepoch += sec_per_year_tbl(lt, it.year);
     }
-    while (tepoch >= (s_p_y = sec_per_year(it.year))) {
+    while (tepoch >= (s_p_y = sec_per_year_tbl(lt, it.year))) {
 	tepoch -= s_p_y;
 	++(it.year);
     }
     it.second = (int)tepoch;
     tepoch -= it.second;
     it.usec = roundoff(tepoch*USECS_PER_SEC);
-    return(normalize_time(it));
+    return(normalize_time_tbl(lt, it));
 }
 
 /************************************************************************/
@@ -815,23 +1250,7 @@ INT_TIME tepoch_to_int
 double int_to_nepoch
    (INT_TIME	it)		/* INT_TIME to convert to Nominal epoch.*/
 {
-    double	nepoch = 0.0;
-    int		year = 1970;
-    int		leaps;
-
-    while (it.year < year) {
-	nepoch -= nsec_per_year(--year);
-    }
-    while (it.year > year) {
-	nepoch += nsec_per_year(year++);
-    }
-    nepoch += it.second;
-    nepoch += ((double)it.usec / (double)USECS_PER_SEC);
-    /* Adjust by the number of leapseconds that preceed this time	*/
-    /* within this year. */
-    leaps = prior_leaps_in_int_time (it);
-    nepoch -= leaps;
-    return(nepoch);
+    return (int_to_nepoch_tbl(leap_table(), it));
 }
 
 /************************************************************************/
@@ -848,10 +1267,8 @@ INT_TIME nepoch_to_int
     int		s_p_y;
     int		leaps;
     LSINFO	*lp;
+    struct lstable *lt = leap_table();
 
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
     it.year = 1970;
     it.second = it.usec = 0;
     while (nepoch < 0) {
@@ -867,10 +1284,10 @@ INT_TIME nepoch_to_int
     nepoch -= it.second;
     it.usec = roundoff(nepoch*USECS_PER_SEC);
     /* Perform leap second adjustment if necessary. */
-    leaps = prior_leaps_in_int_time (it);
-    if ((lp = lp_leap_second (it))) leaps += lp->leap_value;
+    leaps = prior_leaps_in_int_time (lt, it);
+    if ((lp = lp_leap_second (lt, it))) leaps += lp->leap_value;
     it.second += leaps;
-    return(normalize_time(it));
+    return(normalize_time_tbl(lt, it));
 }
 
 /************************************************************************/
@@ -886,17 +1303,15 @@ double nepoch_to_tepoch
     int		i;
     LSINFO	*lp;
     int		offset = 0;
+    struct lstable *lt = leap_table();
 
     /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
     /* Assuming that most time operates are with current time,		*/
     /* process the leapsecond table in reverse time order.		*/
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	if (nepoch >= lstable.lsinfo[i].nepoch) {
-	    offset = lstable.lsinfo[i].total_offset;
-	    if ((lp = lp_leap_second_n(floor(nepoch)))) {
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	if (nepoch >= lt->lsinfo[i].nepoch) {
+	    offset = lt->lsinfo[i].total_offset;
+	    if ((lp = lp_leap_second_n(lt, floor(nepoch)))) {
 		/* No additional offset change required for positive leapsecond.    */
 		/* Map negative leapsecond to true second FOLLOWING leapsecond.   */
 		if (lp->leap_value < 0) offset -= lp->leap_value;
@@ -921,17 +1336,15 @@ double tepoch_to_nepoch
     int		i;
     LSINFO	*lp;
     int		offset = 0;
+    struct lstable *lt = leap_table();
 
     /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
     /* Assuming that most time operates are with current time,		*/
     /* process the leapsecond table in reverse time order.		*/
-    for (i=lstable.nleapseconds-1; i>=0; i--) {
-	if (tepoch >= lstable.lsinfo[i].tepoch) {
-	    offset = lstable.lsinfo[i].total_offset;
-	    if ((lp = lp_leap_second_t(floor(tepoch)))) {
+    for (i=lt->nleapseconds-1; i>=0; i--) {
+	if (tepoch >= lt->lsinfo[i].tepoch) {
+	    offset = lt->lsinfo[i].total_offset;
+	    if ((lp = lp_leap_second_t(lt, floor(tepoch)))) {
 		/* Map positive leapsecond to nominal second FOLLOWING leapsecond.   */
 		/* No additional offset change required for negative leapsecond.    */
 		if (lp->leap_value > 0) offset -= lp->leap_value;
@@ -951,18 +1364,7 @@ double tepoch_to_nepoch
 int sec_per_year
    (int		year)		/* year (input).			*/
 {
-    int		i;
-    int		result = ( SEC_PER_DAY * (365 + IS_LEAP(year)) );
-
-    /*	Search leap second table.   */
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    for (i=0; i<lstable.nleapseconds; i++) {
-	if (year == lstable.lsinfo[i].inttime.year)
-	    result += lstable.lsinfo[i].leap_value;
-    }
-    return(result);
+    return (sec_per_year_tbl(leap_table(), year));
 }
 
 /************************************************************************/
@@ -1156,6 +1558,429 @@ double tdiff
     return (usecs);
 }
 
+/************************************************************************/
+/*  Batch time conversions.						*/
+/*	The following routines convert arrays of times.  The leap	*/
+/*	second table is fetched once per call, and the per-year		*/
+/*	information needed for the conversion is cached and reused 	*/
+/*	while consecutive times fall in the same year.  They produce	*/
+/*	the same results as the single value routines for any input,	*/
+/*	and are fastest when the input is sorted in time.		*/
+/************************************************************************/
+
+/************************************************************************/
+/*  year_leap_range:							*/
+/*	Find the range of leap second table entries for a year.		*/
+/************************************************************************/
+static void year_leap_range
+   (struct lstable *lt,		/* leap second table.			*/
+    int		year,		/* year (input).			*/
+    int		*first,		/* index of first entry (returned).	*/
+    int		*last)		/* index after last entry (returned).	*/
+{
+    int i = 0;
+    while (i < lt->nleapseconds && lt->lsinfo[i].inttime.year < year) ++i;
+    *first = i;
+    while (i < lt->nleapseconds && lt->lsinfo[i].inttime.year == year) ++i;
+    *last = i;
+}
+
+/************************************************************************/
+/*  int_to_tepoch_v:							*/
+/*	Convert an array of internal times to true epoch times.		*/
+/************************************************************************/
+void int_to_tepoch_v
+   (INT_TIME	*it,		/* array of INT_TIME to convert.	*/
+    double	*tepoch,	/* array of returned true epoch times.	*/
+    int		n)		/* number of times to convert.		*/
+{
+    struct lstable *lt = leap_table();
+    INT_TIME	ys;
+    double	ystart = 0.;	/* true epoch time of start of year.	*/
+    int		year = 0;
+    int		valid = 0;
+    int		i;
+
+    ys.second = ys.usec = 0;
+    for (i=0; i<n; i++) {
+	if (! valid || it[i].year != year) {
+	    if (valid && it[i].year == year + 1) {
+		ystart += sec_per_year_tbl(lt, year);
+	    }
+	    else {
+		ys.year = it[i].year;
+		ystart = int_to_tepoch_tbl(lt, ys);
+	    }
+	    year = it[i].year;
+	    valid = 1;
+	}
+	tepoch[i] = ystart + it[i].second;
+	tepoch[i] += ((double)it[i].usec / (double)USECS_PER_SEC);
+    }
+}
+
+/************************************************************************/
+/*  tepoch_to_int_v:							*/
+/*	Convert an array of true epoch times to internal times.		*/
+/************************************************************************/
+void tepoch_to_int_v
+   (double	*tepoch,	/* array of true epoch times to convert.*/
+    INT_TIME	*it,		/* array of returned INT_TIME.		*/
+    int		n)		/* number of times to convert.		*/
+{
+    struct lstable *lt = leap_table();
+    INT_TIME	ys;
+    double	ystart = 0.;	/* true epoch time of start of year.	*/
+    double	yend = 0.;	/* true epoch time of start of next year*/
+    double	t;
+    int		i;
+
+    ys.year = 0;
+    ys.second = ys.usec = 0;
+    for (i=0; i<n; i++) {
+	t = tepoch[i];
+	if (! (t >= ystart && t < yend)) {
+	    if (t >= yend && yend > ystart && t < yend + sec_per_year_tbl(lt, ys.year+1)) {
+		/* Next year - the usual case for sorted input.		*/
+		++ys.year;
+		ystart = yend;
+	    }
+	    else {
+		ys = tepoch_to_int (t);
+		ys.second = ys.usec = 0;
+		ystart = int_to_tepoch_tbl(lt, ys);
+	    }
+	    yend = ystart + sec_per_year_tbl(lt, ys.year);
+	}
+	t -= ystart;
+	it[i].year = ys.year;
+	it[i].second = (int)t;
+	t -= it[i].second;
+	it[i].usec = roundoff(t*USECS_PER_SEC);
+	if (it[i].usec >= USECS_PER_SEC) it[i] = normalize_time_tbl(lt, it[i]);
+    }
+}
+
+/************************************************************************/
+/*  int_to_ext_v:							*/
+/*	Convert an array of internal times to external times.		*/
+/************************************************************************/
+void int_to_ext_v
+   (INT_TIME	*it,		/* array of INT_TIME to convert.	*/
+    EXT_TIME	*et,		/* array of returned EXT_TIME.		*/
+    int		n)		/* number of times to convert.		*/
+{
+    struct lstable *lt = leap_table();
+    int		year = 0;
+    int		valid = 0;
+    int		first = 0, last = 0;
+    int		i, j, leaps;
+    LSINFO	*lp;
+
+    for (i=0; i<n; i++) {
+	if (! valid || it[i].year != year) {
+	    year = it[i].year;
+	    valid = 1;
+	    /* Only leap seconds within the year affect the conversion.	*/
+	    if (year < 1970) first = last = 0;
+	    else year_leap_range (lt, year, &first, &last);
+	}
+	leaps = 0;
+	lp = NULL;
+	for (j=first; j<last; j++) {
+	    if (it[i].second > lt->lsinfo[j].inttime.second) 
+		leaps += lt->lsinfo[j].leap_value;
+	    else if (it[i].second == lt->lsinfo[j].inttime.second) 
+		lp = &lt->lsinfo[j];
+	}
+	et[i] = int_to_ext_leaps (it[i], leaps, lp);
+    }
+}
+
+/************************************************************************/
+/*  tdiff_v:								*/
+/*	Compute the difference (t[i]-ref) in usecs for an array of 	*/
+/*	times.								*/
+/************************************************************************/
+void tdiff_v
+   (INT_TIME	*it,		/* array of INT_TIME t[i].		*/
+    INT_TIME	ref,		/* reference INT_TIME.			*/
+    double	*usecs,		/* array of returned differences.	*/
+    int		n)		/* number of times.			*/
+{
+    struct lstable *lt = leap_table();
+    double	yoff = 0.;	/* seconds from start of ref year to	*/
+				/* start of cached year.		*/
+    double	seconds;
+    int		year = ref.year;
+    int		y, i, du;
+
+    for (i=0; i<n; i++) {
+	if (it[i].year != year) {
+	    if (it[i].year == year + 1) {
+		yoff += sec_per_year_tbl(lt, year);
+	    }
+	    else {
+		yoff = 0.;
+		for (y=ref.year; y<it[i].year; y++) yoff += sec_per_year_tbl(lt, y);
+		for (y=it[i].year; y<ref.year; y++) yoff -= sec_per_year_tbl(lt, y);
+	    }
+	    year = it[i].year;
+	}
+	seconds = yoff + it[i].second - ref.second;
+	du = it[i].usec - ref.usec;
+	/* Match the arithmetic of tdiff() exactly.			*/
+	if (seconds > 0 || (seconds == 0 && du >= 0))
+	    usecs[i] = du + seconds*USECS_PER_SEC;
+	else 
+	    usecs[i] = -(-du + (-seconds)*USECS_PER_SEC);
+    }
+}
+
+/************************************************************************/
+/*  Sample clock.							*/
+/*	A SAMPLE_CLOCK represents a sample rate as an exact rational	*/
+/*	number num/den (samples per second) and an anchor time for	*/
+/*	sample 0.  The time of any sample is computed directly from the	*/
+/*	anchor using integer arithmetic, so that times do not drift 	*/
+/*	when a long series is processed one record at a time.		*/
+/************************************************************************/
+
+#define	MAX_CLOCK_TERM	2147483647	/* max value of num or den.	*/
+#define	MAX_CLOCK_DEN	1000000		/* max den for actual rates.	*/
+
+/************************************************************************/
+/*  floor_div64:							*/
+/*	Integer division rounded towards negative infinity.		*/
+/*	Denominator must be positive.					*/
+/************************************************************************/
+static int64_t floor_div64
+   (int64_t	a,		/* numerator.				*/
+    int64_t	b,		/* denominator (> 0).			*/
+    int64_t	*r)		/* returned non-negative remainder.	*/
+{
+    int64_t q = a / b;
+    int64_t m = a % b;
+    if (m < 0) {
+	--q;
+	m += b;
+    }
+    if (r) *r = m;
+    return (q);
+}
+
+/************************************************************************/
+/*  gcd64:								*/
+/*	Greatest common divisor of 2 positive numbers.			*/
+/************************************************************************/
+static int64_t gcd64
+   (int64_t	a,		/* first number.			*/
+    int64_t	b)		/* second number.			*/
+{
+    int64_t t;
+    while (b != 0) {
+	t = a % b;
+	a = b;
+	b = t;
+    }
+    return (a);
+}
+
+/************************************************************************/
+/*  set_sample_clock_rate:						*/
+/*	Set the rational rate of a sample clock, reduced to lowest	*/
+/*	terms.								*/
+/*  return:								*/
+/*	0 on success, MS_ERROR if the rate is not valid.		*/
+/************************************************************************/
+static int set_sample_clock_rate
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK.			*/
+    int64_t	num,		/* samples ...				*/
+    int64_t	den)		/* ... per den seconds.			*/
+{
+    int64_t g;
+    if (num <= 0 || den <= 0) {
+	sc->num = sc->den = 0;
+	return (MS_ERROR);
+    }
+    g = gcd64 (num, den);
+    num /= g;
+    den /= g;
+    if (num > MAX_CLOCK_TERM || den > MAX_CLOCK_TERM) {
+	sc->num = sc->den = 0;
+	return (MS_ERROR);
+    }
+    sc->num = num;
+    sc->den = den;
+    return (0);
+}
+
+/************************************************************************/
+/*  init_sample_clock:							*/
+/*	Initialize a sample clock from a sample rate and sample rate	*/
+/*	multiplier in the qlib convention.				*/
+/*  return:								*/
+/*	0 on success, MS_ERROR if the rate is zero or invalid.		*/
+/************************************************************************/
+int init_sample_clock
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    INT_TIME	anchor,		/* time of sample 0.			*/
+    int		rate,		/* sample rate in qlib convention.	*/
+    int		rate_mult)	/* sample rate_mult in qlib convention.	*/
+{
+    int64_t num, den;
+
+    sc->anchor = anchor;
+    if (rate != 0 && rate_mult == 0) rate_mult = 1; /* backwards compat.*/
+    if (rate == 0 || rate_mult == 0) {
+	sc->num = sc->den = 0;
+	return (MS_ERROR);
+    }
+    if (rate > 0 && rate_mult > 0) {
+	num = (int64_t)rate * rate_mult;
+	den = 1;
+    }
+    else if (rate > 0 && rate_mult < 0) {
+	num = rate;
+	den = -(int64_t)rate_mult;
+    }
+    else if (rate < 0 && rate_mult > 0) {
+	num = rate_mult;
+	den = -(int64_t)rate;
+    }
+    else {
+	num = 1;
+	den = (int64_t)rate * rate_mult;
+    }
+    return (set_sample_clock_rate (sc, num, den));
+}
+
+/************************************************************************/
+/*  init_sample_clock_sps:						*/
+/*	Initialize a sample clock from a floating point sample rate,	*/
+/*	such as the actual rate in a blockette 100.  The rate is	*/
+/*	converted to the simplest rational number that reproduces the	*/
+/*	single precision value of the rate, so that nominal rates such	*/
+/*	as 0.1 or 40.0 are represented exactly.				*/
+/*  return:								*/
+/*	0 on success, MS_ERROR if the rate is zero or invalid.		*/
+/************************************************************************/
+int init_sample_clock_sps
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    INT_TIME	anchor,		/* time of sample 0.			*/
+    double	sps)		/* sample rate in samples per second.	*/
+{
+    /* Continued fraction expansion of the rate.			*/
+    /* Convergents are p[i]/q[i], with p[-1]=1, q[-1]=0, p[-2]=0, q[-2]=1*/
+    double x, a;
+    int64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0, p2, q2, ai;
+    int64_t best_p = 0, best_q = 1;
+    float target;
+    int i;
+
+    sc->anchor = anchor;
+    if (! (sps > 0.) || sps > (double)MAX_CLOCK_TERM) {
+	sc->num = sc->den = 0;
+	return (MS_ERROR);
+    }
+    target = (float)sps;
+    x = sps;
+    for (i=0; i<64; i++) {
+	a = floor(x);
+	ai = (int64_t)a;
+	p2 = ai * p1 + p0;
+	q2 = ai * q1 + q0;
+	if (p2 > MAX_CLOCK_TERM || q2 > MAX_CLOCK_DEN) break;
+	best_p = p2;
+	best_q = q2;
+	if ((float)((double)p2 / (double)q2) == target) break;
+	if (x - a == 0.) break;
+	x = 1. / (x - a);
+	p0 = p1; q0 = q1;
+	p1 = p2; q1 = q2;
+    }
+    if (best_p <= 0) {
+	sc->num = sc->den = 0;
+	return (MS_ERROR);
+    }
+    return (set_sample_clock_rate (sc, best_p, best_q));
+}
+
+/************************************************************************/
+/*  sample_clock_time:							*/
+/*	Compute the time of sample k of a sample clock, rounded to the	*/
+/*	nearest usec.  k may be negative for samples before the anchor.	*/
+/*  return:								*/
+/*	INT_TIME of the sample.						*/
+/************************************************************************/
+INT_TIME sample_clock_time
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK.			*/
+    int64_t	k)		/* sample index relative to anchor.	*/
+{
+    INT_TIME it;
+    int64_t q, r, seconds, rem, usecs, step;
+
+    it = sc->anchor;
+    if (sc->num <= 0 || sc->den <= 0 || k == 0) return (it);
+
+    /* time = k * den / num seconds, computed without overflow.		*/
+    q = floor_div64 (k, sc->num, &r);
+    seconds = q * sc->den + floor_div64 (r * sc->den, sc->num, &rem);
+    usecs = (rem * 2 * USECS_PER_SEC + sc->num) / (2 * sc->num);
+
+    /* Add the offset in steps that fit in an int.			*/
+    while (seconds > INT_MAX/2 || seconds < -(INT_MAX/2)) {
+	step = (seconds > 0) ? INT_MAX/2 : -(INT_MAX/2);
+	it = add_time (it, (int)step, 0);
+	seconds -= step;
+    }
+    return (add_time (it, (int)seconds, (int)usecs));
+}
+
+/************************************************************************/
+/*  sample_clock_index:							*/
+/*	Compute the index of the last sample of a sample clock whose	*/
+/*	time (as returned by sample_clock_time) is at or before the	*/
+/*	specified time.							*/
+/*  return:								*/
+/*	sample index relative to the anchor.				*/
+/************************************************************************/
+int64_t sample_clock_index
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK.			*/
+    INT_TIME	it)		/* time of interest.			*/
+{
+    INT_TIME	x1, x2;
+    int64_t seconds, usecs, qa, ra, rb;
+    int m = 1;
+
+    if (sc->num <= 0 || sc->den <= 0) return (0);
+
+    /* Compute the exact (it - anchor) in seconds and usecs.		*/
+    x1 = it;
+    x2 = sc->anchor;
+    if (x1.year < x2.year) {
+	x1 = sc->anchor;
+	x2 = it;
+	m = -1;
+    }
+    seconds = x1.second;
+    while (x1.year > x2.year) {
+	--x1.year;
+	seconds += sec_per_year(x1.year);
+    }
+    seconds = m * (seconds - x2.second);
+    usecs = m * (x1.usec - x2.usec);
+    seconds += floor_div64 (usecs, USECS_PER_SEC, &usecs);
+
+    /* Sample times are rounded to the nearest usec, so find the	*/
+    /* largest index with (index * den / num) < (seconds + (usecs+0.5)/1e6).*/
+    qa = floor_div64 (seconds * sc->num, sc->den, &ra);
+    qa += floor_div64 (ra * 2 * USECS_PER_SEC + (2 * usecs + 1) * sc->num,
+		       sc->den * 2 * USECS_PER_SEC, &rb);
+    if (rb == 0) --qa;
+    return (qa);
+}
+
 /************************************************************************/
 /*  time_to_str:							*/
 /*	Convert internal time to printable string.			*/
@@ -1165,6 +1990,19 @@ char *time_to_str
     int		fmt)		/* format specifier.			*/
 {
     static char str[80];	    /* contains printable time string.	*/
+    return (time_to_str_r (it, fmt, str));
+}
+
+/************************************************************************/
+/*  time_to_str_r:							*/
+/*	Convert internal time to printable string.			*/
+/*	Reentrant version of time_to_str.				*/
+/************************************************************************/
+char *time_to_str_r
+   (INT_TIME	it,		/* INT_TIME to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str)		/* output string (at least 80 chars).	*/
+{
     int delim;
     EXT_TIME	et = int_to_ext (it);
 
@@ -1220,7 +2058,20 @@ char *utime_to_str
    (INT_TIME	it,		/* INT_TIME to convert to string.	*/
     int		fmt)		/* format specifier.			*/
 {
-    static char str[80];	/* contains printable time string.	*/
+    static char str[80];	    /* contains printable time string.	*/
+    return (utime_to_str_r (it, fmt, str));
+}
+
+/************************************************************************/
+/*  utime_to_str_r:							*/
+/*	Convert extended internal time to printable string.		*/
+/*	Reentrant version of utime_to_str.				*/
+/************************************************************************/
+char *utime_to_str_r
+   (INT_TIME	it,		/* INT_TIME to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str)		/* output string (at least 80 chars).	*/
+{
     int delim;
     EXT_TIME	et = int_to_ext (it);
 
@@ -1253,6 +2104,19 @@ char *interval_to_str
     int		fmt)		/* format specifier.			*/
 {
     static char str[80];	    /* contains printable time string.	*/
+    return (interval_to_str_r (et, fmt, str));
+}
+
+/************************************************************************/
+/*  interval_to_str_r:							*/
+/*	Convert interval store in EXT_TIME format to printable string.	*/
+/*	Reentrant version of interval_to_str.				*/
+/************************************************************************/
+char *interval_to_str_r
+   (EXT_TIME	et,		/* Interval to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str)		/* output string (at least 80 chars).	*/
+{
     int		delim = ',';
     sprintf (str, "%d.%d%c%02d:%02d:%02d.%04d",
 	     et.year,et.doy, delim, et.hour, et.minute, et.second, 
@@ -1307,19 +2171,11 @@ int parse_date_r
     The time is optional.  If not specified, it is 00:00:00.0000
     */
 
-    char	*p, *q, *eos;
-    char	*delim;
+    char	*p, *q;
     EXT_TIME	et;
-    int		trip, nd;
-    int		error = 0;
-    int		format;
-    int		ndelim;
     int		l;
     double	epoch;
 
-    et.year = et.doy = et.month = et.day = 0;
-    et.hour = et.minute = et.second = et.usec = 0;
-
     /* First check for true or nominal epoch time.  */
     l = strlen(str);
     p = strpbrk (str, "TtNn");
@@ -1331,6 +2187,41 @@ int parse_date_r
 	else return 1;
     }
 
+    if (parse_date_ext (&et, str) != 0) return 1;
+
+/*::
+    printf ("year = %d, doy = %d, hour = %d, min = %d, sec = %d, usec = %d\n",
+	    et.year, et.doy, et.hour, et.minute, et.second, et.usec);
+::*/
+
+    *it = ext_to_int (et);
+/*    return (&it);*/
+    return 0;
+}
+
+/************************************************************************/
+/*  parse_date_ext:							*/
+/*	Parse a date/time string (not an epoch time) into an EXT_TIME	*/
+/*	structure, without leap second normalization.  Used by		*/
+/*	parse_date_r() and by the leap second table loader.		*/
+/*  return:                                                             */
+/*	0 on success, 1 on error.					*/
+/************************************************************************/
+static int parse_date_ext
+   (EXT_TIME	*pet,		/* output EXT_TIME.			*/
+    char	*str)		/* string containing date to parse.	*/
+{
+    char	*p, *q, *eos;
+    char	*delim;
+    EXT_TIME	et;
+    int		trip, nd;
+    int		error = 0;
+    int		format;
+    int		ndelim;
+
+    et.year = et.doy = et.month = et.day = 0;
+    et.hour = et.minute = et.second = et.usec = 0;
+
     /* Now check for normal date time specification in various format.	*/
     /* Scan for first ":", and then determine the number of		*/
     /* delimiters before to determine year.doy or year.mm.dd format.	*/
@@ -1441,14 +2332,7 @@ int parse_date_r
     if (error) {
         return 1;
     }
-
-/*::
-    printf ("year = %d, doy = %d, hour = %d, min = %d, sec = %d, usec = %d\n",
-	    et.year, et.doy, et.hour, et.minute, et.second, et.usec);
-::*/
-
-    *it = ext_to_int (et);
-/*    return (&it);*/
+    *pet = et;
     return 0;
 }
 
@@ -1971,14 +2855,12 @@ void dump_leapsecond_table ()
 {
     int i;
     LSINFO *lp;
+    struct lstable *lt = leap_table();
 
-    if (!lstable.initialized) {
-	(void)init_leap_second_table();
-    }
-    printf ("initialized = %d\n", lstable.initialized);
-    printf ("nleapseconds = %d\n", lstable.nleapseconds);
-    for (i=0; i<lstable.nleapseconds; i++) {
-	lp = &lstable.lsinfo[i];
+    printf ("initialized = %d\n", lt->initialized);
+    printf ("nleapseconds = %d\n", lt->nleapseconds);
+    for (i=0; i<lt->nleapseconds; i++) {
+	lp = &lt->lsinfo[i];
 	printf ("\n");
 	printf ("[%d]\t%04d/%02d/%02d,%02d:%02d:%02d\t%s\n", i, 
 		lp->exttime.year, lp->exttime.month, lp->exttime.day,
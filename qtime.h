@@ -49,6 +49,9 @@ extern "C" {
 
 extern int init_leap_second_table ();
 
+extern int reload_leap_second_table
+   (char	*leap_file);	/* leapsecond file, or NULL for default.*/
+
 extern int is_leap_second
    (INT_TIME it);		/* INT_TIME structure			*/
 
@@ -78,6 +81,13 @@ extern INT_TIME normalize_time
 extern EXT_TIME int_to_ext
    (INT_TIME	it);		/* INT_TIME to convert to EXT_TIME.	*/
 
+extern void init_ext_cursor
+   (EXT_CURSOR	*ec);		/* ptr to EXT_CURSOR.			*/
+
+extern EXT_TIME int_to_ext_c
+   (EXT_CURSOR	*ec,		/* ptr to EXT_CURSOR.			*/
+    INT_TIME	it);		/* INT_TIME to convert to EXT_TIME.	*/
+
 extern INT_TIME ext_to_int
    (EXT_TIME	et);		/* EXT_TIME to convert to INT_TIME.	*/
 
@@ -137,6 +147,46 @@ extern double tdiff
    (INT_TIME	it1,		/* INT_TIME t1.				*/
     INT_TIME	it2);		/* INT_TIME t2.				*/
 
+extern void int_to_tepoch_v
+   (INT_TIME	*it,		/* array of INT_TIME to convert.	*/
+    double	*tepoch,	/* array of returned true epoch times.	*/
+    int		n);		/* number of times to convert.		*/
+
+extern void tepoch_to_int_v
+   (double	*tepoch,	/* array of true epoch times to convert.*/
+    INT_TIME	*it,		/* array of returned INT_TIME.		*/
+    int		n);		/* number of times to convert.		*/
+
+extern void int_to_ext_v
+   (INT_TIME	*it,		/* array of INT_TIME to convert.	*/
+    EXT_TIME	*et,		/* array of returned EXT_TIME.		*/
+    int		n);		/* number of times to convert.		*/
+
+extern void tdiff_v
+   (INT_TIME	*it,		/* array of INT_TIME t[i].		*/
+    INT_TIME	ref,		/* reference INT_TIME.			*/
+    double	*usecs,		/* array of returned differences.	*/
+    int		n);		/* number of times.			*/
+
+extern int init_sample_clock
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    INT_TIME	anchor,		/* time of sample 0.			*/
+    int		rate,		/* sample rate in qlib convention.	*/
+    int		rate_mult);	/* sample rate_mult in qlib convention.	*/
+
+extern int init_sample_clock_sps
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    INT_TIME	anchor,		/* time of sample 0.			*/
+    double	sps);		/* sample rate in samples per second.	*/
+
+extern INT_TIME sample_clock_time
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK.			*/
+    int64_t	k);		/* sample index relative to anchor.	*/
+
+extern int64_t sample_clock_index
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK.			*/
+    INT_TIME	it);		/* time of interest.			*/
+
 extern char *time_to_str 
    (INT_TIME	it,		/* INT_TIME to convert to string.	*/
     int		fmt);		/* format specifier.			*/
@@ -149,6 +199,21 @@ extern char *interval_to_str
    (EXT_TIME	et,		/* Interval to convert to string.	*/
     int		fmt);		/* format specifier.			*/
 
+extern char *time_to_str_r
+   (INT_TIME	it,		/* INT_TIME to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str);		/* output string (at least 80 chars).	*/
+
+extern char *utime_to_str_r
+   (INT_TIME	it,		/* INT_TIME to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str);		/* output string (at least 80 chars).	*/
+
+extern char *interval_to_str_r
+   (EXT_TIME	et,		/* Interval to convert to string.	*/
+    int		fmt,		/* format specifier.			*/
+    char	*str);		/* output string (at least 80 chars).	*/
+
 extern int parse_date_r
    (INT_TIME    *it,            /* INT_TIME it.                         */
     char        *str);          /* string containing date to parse.     */
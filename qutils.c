@@ -42,6 +42,7 @@
 #include <string.h>
 #include <math.h>
 #include <errno.h>
+#include <pthread.h>
 #ifdef	SUNOS4
 #include <malloc.h>
 #endif
@@ -66,6 +67,8 @@ int default_data_hdr_ind = DATA_HDR_IND_D;  /* dflt data_hdr_ind (R/W).	*/
 int qlib2_errno = 0;			/* qlib2 extented error code.	*/
 int qlib2_op_mode = 0;			/* op mode for qlib2 (R/W)	*/
 
+static pthread_once_t wordorder_once = PTHREAD_ONCE_INIT;
+
 /************************************************************************/
 /*  SEED channel to station/stream mapping tables.			*/
 /*									*/
@@ -562,14 +565,11 @@ int init_qlib2
 }
 
 /************************************************************************/
-/*  get_my_wordorder:							*/
+/*  init_my_wordorder:							*/
 /*	Determine which endian (byte order) this machine is.		*/
-/*	Set default hdr and data wordorder if not previously set.	*/
-/*  Return:								*/
-/*	machine wordorder on success.					*/
-/*	MS_ERROR on error.						*/
+/*	Called only once, via pthread_once().				*/
 /************************************************************************/
-int get_my_wordorder()
+static void init_my_wordorder(void)
 {
     int ival = 0x01234567;		/* hex 01234567			*/
     unsigned char *pc;
@@ -580,11 +580,104 @@ int get_my_wordorder()
     if (my_wordorder < 0) {
 	fprintf (stderr, "Error: Unable to determine computer wordorder.\n");
 	fflush (stderr);
-	if (QLIB2_CLASSIC) exit (1);
-	return (MS_ERROR);
+	return;
     }
     if (hdr_wordorder < 0) set_hdr_wordorder (my_wordorder);
     if (data_wordorder < 0) set_data_wordorder (my_wordorder);
+}
+
+/************************************************************************/
+/*  qlib2_ctx_init:							*/
+/*	Initialize a QLIB2_CTX from the current global settings.	*/
+/*	The context may then be modified and used by a single thread	*/
+/*	with the reentrant *_ctx routines.				*/
+/*  Return:								*/
+/*	0 on success.							*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int qlib2_ctx_init
+   (QLIB2_CTX	*ctx)		/* ptr to QLIB2_CTX to initialize.	*/
+{
+    int status;
+    memset ((void *)ctx, 0, sizeof(QLIB2_CTX));
+    ctx->op_mode = qlib2_op_mode;
+    if ((status = get_my_wordorder()) < 0) return (status);
+    /* Ensure the leapsecond table is loaded before threads use it.	*/
+    init_leap_second_table();
+    ctx->hdr_wordorder = hdr_wordorder;
+    ctx->data_wordorder = data_wordorder;
+    ctx->default_data_hdr_ind = default_data_hdr_ind;
+    return (0);
+}
+
+/************************************************************************/
+/*  qlib2_ctx_free:							*/
+/*	Free storage allocated within a QLIB2_CTX.			*/
+/************************************************************************/
+void qlib2_ctx_free
+   (QLIB2_CTX	*ctx)		/* ptr to QLIB2_CTX.			*/
+{
+    if (ctx->diffbuf) free ((char *)ctx->diffbuf);
+    ctx->diffbuf = NULL;
+    ctx->diffbuf_len = 0;
+}
+
+/************************************************************************/
+/*  qlib2_ctx_error:							*/
+/*	Report an error message.  If a QLIB2_CTX is specified, save the	*/
+/*	message in the context.  Otherwise, print it on stderr.		*/
+/************************************************************************/
+void qlib2_ctx_error
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    char	*msg)		/* error message.			*/
+{
+    if (ctx) {
+	strncpy (ctx->errmsg, msg, QLIB2_ERRMSG_LEN-1);
+	ctx->errmsg[QLIB2_ERRMSG_LEN-1] = '\0';
+    }
+    else {
+	fprintf (stderr, "%s", msg);
+	fflush (stderr);
+    }
+}
+
+/************************************************************************/
+/*  qlib2_ctx_diffbuf:							*/
+/*	Return the difference buffer of a QLIB2_CTX, growing it to at	*/
+/*	least n ints if necessary.					*/
+/*  Return:								*/
+/*	ptr to buffer on success.					*/
+/*	NULL on malloc error.						*/
+/************************************************************************/
+int *qlib2_ctx_diffbuf
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    int		n)		/* # of ints required.			*/
+{
+    int *p;
+    if (n <= ctx->diffbuf_len) return (ctx->diffbuf);
+    if (n < 1024) n = 1024;
+    if ((p = (int *)realloc(ctx->diffbuf, n * sizeof(int))) == NULL) 
+	return (NULL);
+    ctx->diffbuf = p;
+    ctx->diffbuf_len = n;
+    return (p);
+}
+
+/************************************************************************/
+/*  get_my_wordorder:							*/
+/*	Determine which endian (byte order) this machine is.		*/
+/*	Set default hdr and data wordorder if not previously set.	*/
+/*  Return:								*/
+/*	machine wordorder on success.					*/
+/*	MS_ERROR on error.						*/
+/************************************************************************/
+int get_my_wordorder()
+{
+    pthread_once (&wordorder_once, init_my_wordorder);
+    if (my_wordorder < 0) {
+	if (QLIB2_CLASSIC) exit (1);
+	return (MS_ERROR);
+    }
     return (my_wordorder);
 }
 
@@ -43,12 +43,29 @@
 
 #include "stdio.h"
 #include "ctype.h"
+#include "qdefines.h"
 #include "sdr.h"
 
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
+/*  Per-thread qlib2 state.  A QLIB2_CTX holds the settings and error	*/
+/*  information that are otherwise kept in the global variables below,	*/
+/*  for use with the reentrant *_ctx routines.				*/
+typedef struct _qlib2_ctx {
+    int		hdr_wordorder;	/* desired hdr wordorder.		*/
+    int		data_wordorder;	/* desired data wordorder.		*/
+    int		default_data_hdr_ind;/* dflt data_hdr_ind.		*/
+    int		op_mode;	/* qlib2 operation mode.		*/
+    int		qlib2_errno;	/* qlib2 extented error code.		*/
+    char	errmsg[QLIB2_ERRMSG_LEN]; /* last error message.	*/
+    int		*diffbuf;	/* reusable Steim difference buffer.	*/
+    int		diffbuf_len;	/* # of ints allocated in diffbuf.	*/
+} QLIB2_CTX;
+
+#define	QLIB2_CTX_CLASSIC(ctx)	((ctx) ? (ctx)->op_mode == 0 : QLIB2_CLASSIC)
+
 extern int my_wordorder;	/* Unknown endian.			*/
 extern int hdr_wordorder;	/* desired hdr wordorder. (W)		*/
 extern int data_wordorder;	/* desired data wordorder. (W)		*/
@@ -162,6 +179,20 @@ extern char set_record_type
 extern int init_qlib2
    (int		mode);		/* desired qlib2 operation mode.	*/
 
+extern int qlib2_ctx_init
+   (QLIB2_CTX	*ctx);		/* ptr to QLIB2_CTX to initialize.	*/
+
+extern void qlib2_ctx_free
+   (QLIB2_CTX	*ctx);		/* ptr to QLIB2_CTX.			*/
+
+extern void qlib2_ctx_error
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    char	*msg);		/* error message.			*/
+
+extern int *qlib2_ctx_diffbuf
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    int		n);		/* # of ints required.			*/
+
 extern int wordorder_from_time
    (unsigned char *p);		/* ptr to fixed data time field.	*/
 
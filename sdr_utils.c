@@ -52,6 +52,7 @@
 #include "qutils.h"
 #include "sdr_utils.h"
 #include "ms_utils.h"
+#include "ms_sncl.h"
 
 #ifdef	QLIB_DEBUG
 extern FILE *info;		/*:: required only for debugging	*/
@@ -123,19 +124,127 @@ SDR_TIME encode_time_sdr
 }
 
 /************************************************************************/
-/*  decode_hdr_sdr:							*/
-/*	Decode SDR header stored with each SDR data block,		*/
-/*	and return ptr to dynamically allocated DATA_HDR structure.	*/
-/*	Fill in structure with the information in a easy-to-use format.	*/
-/*	Skip over vol_hdr record, which may be on Quanterra Ultra-Shear	*/
-/*	tapes.								*/
+/*  known_blockette_len:						*/
+/*	Return the length of a known blockette type, or 0 if the	*/
+/*	type is unknown.						*/
+/************************************************************************/
+static int known_blockette_len
+   (int		bl_type,	/* blockette type.			*/
+    char	*pb,		/* ptr to blockette.			*/
+    int		swapflag)	/* 1 if blockette must be swapped.	*/
+{
+    SEED_UWORD bl_len;
+
+    switch (bl_type) {
+      /* Fixed length blockettes.	*/
+      case 100: return (sizeof (BLOCKETTE_100));
+      case 200: return (sizeof (BLOCKETTE_200));
+      case 201: return (sizeof (BLOCKETTE_201));
+      case 300: return (sizeof (BLOCKETTE_300));
+      case 310: return (sizeof (BLOCKETTE_310));
+      case 320: return (sizeof (BLOCKETTE_320));
+      case 390: return (sizeof (BLOCKETTE_390));
+      case 395: return (sizeof (BLOCKETTE_395));
+      case 400: return (sizeof (BLOCKETTE_400));
+      case 405: return (sizeof (BLOCKETTE_405));
+      case 500: return (sizeof (BLOCKETTE_500));
+      case 1000: return (sizeof (BLOCKETTE_1000));
+      case 1001: return (sizeof (BLOCKETTE_1001));
+      /* Variable length blockettes.  Preserve original length,	*/
+      /* even though it may not is divisible by 4.		*/
+      /* It is up to the user to ensure that that blockettes	*/
+      /* have 4 byte alignment in a SEED data record.		*/
+      case 2000: 
+	bl_len = ((BLOCKETTE_2000 *)pb)->blockette_len; 
+	if (swapflag) swab2 ((short int *)&bl_len);
+	return (bl_len);
+      default: return (0);
+    }
+}
+
+/************************************************************************/
+/*  read_blockettes_into:						*/
+/*	Build the blockette list of a DATA_HDR from caller supplied BS	*/
+/*	structures, without allocating memory.  Each blockette points	*/
+/*	into the record.  The length of each blockette is determined as	*/
+/*	in read_blockettes, and must lie within the record.		*/
+/*  return:								*/
+/*	1 on success, negative QLIB2 error code on error.		*/
+/************************************************************************/
+static int read_blockettes_into
+   (DATA_HDR	*hdr,		/* data_header structure.		*/
+    char	*str,		/* ptr to fixed data header.		*/
+    int		maxbytes,	/* max # bytes in record.		*/
+    BS		*pool,		/* BS structures for the blockettes.	*/
+    int		npool)		/* # of BS structures.			*/
+{
+    BS		*bs, *pbs = NULL;
+    int		offset, i, n = 0;
+    int		swapflag = (hdr->hdr_wordorder != my_wordorder);
+    SEED_UWORD	bl_len, bl_next = 0, bl_type;
+
+    offset = hdr->first_blockette;
+    hdr->pblockettes = (BS *)NULL;
+    for (i=0; i<hdr->num_blockettes; i++) {
+	if (n >= npool ||
+	    offset < (int)sizeof(SDR_HDR) || 
+	    offset + (int)sizeof(BLOCKETTE_HDR) > maxbytes)
+	    return (MS_ERROR);
+	bl_type = ((BLOCKETTE_HDR *)(str+offset))->type;
+	bl_next = ((BLOCKETTE_HDR *)(str+offset))->next;
+	if (swapflag) {
+	    swab2 ((short int *)&bl_type);
+	    swab2 ((short int *)&bl_next);
+	}
+	if (bl_next > 0) {
+	    if (bl_next <= offset) return (MS_ERROR);
+	    bl_len = bl_next - offset;
+	}
+	else {
+	    bl_len = known_blockette_len (bl_type, str+offset, swapflag);
+	    if (bl_len == 0) {
+		/* Assume the blockette reaches to first data.		*/
+		if (hdr->first_data <= offset) break;
+		bl_len = hdr->first_data - offset;
+	    }
+	    else if (hdr->first_data > offset && 
+		     (int)bl_len > hdr->first_data - offset)
+		bl_len = hdr->first_data - offset;
+	}
+	if (offset + (int)bl_len > maxbytes) return (MS_ERROR);
+	bs = &pool[n++];
+	bs->pb = str + offset;
+	bs->len = bl_len;
+	bs->type = bl_type;
+	bs->wordorder = hdr->hdr_wordorder;
+	bs->next = (BS *)NULL;
+	if (pbs == NULL) hdr->pblockettes = bs;
+	else pbs->next = bs;
+	pbs = bs;
+	if (bl_next == 0) break;
+	offset += bl_len;
+    }
+    return (1);
+}
+
+/************************************************************************/
+/*  decode_hdr_sdr_x:							*/
+/*	Decode SDR header stored with each SDR data block.  If uhdr is	*/
+/*	NULL, return ptr to dynamically allocated DATA_HDR structure.	*/
+/*	Otherwise decode into uhdr, with blockettes in the supplied BS	*/
+/*	structures that point into the record.				*/
+/*	If ctx is NULL, use the global qlib2 settings and qlib2_errno.	*/
 /*  return:								*/
 /*	DATA_HDR pointer on success.					*/
 /*	NULL on failure.						*/
 /************************************************************************/
-DATA_HDR *decode_hdr_sdr
-   (SDR_HDR	*ihdr,		/* input SDR header.			*/
-    int		maxbytes)	/* max # bytes in buffer.		*/
+static DATA_HDR *decode_hdr_sdr_x
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes,	/* max # bytes in buffer.		*/
+    DATA_HDR	*uhdr,		/* DATA_HDR to decode into, or NULL.	*/
+    BS		*ubs,		/* BS structures for uhdr blockettes.	*/
+    int		nbs)		/* # of BS structures.			*/
 {
     char tmp[80];
     DATA_HDR *ohdr;
@@ -143,14 +252,15 @@ DATA_HDR *decode_hdr_sdr
     char *p;
     char *pc;
     int i, next_seq;
-    int seconds, usecs;
+    SAMPLE_CLOCK sc;
     int swapflag;
     int		itmp[2];
     short int	stmp[2];
     unsigned short int ustmp[2];
     int		wo;
+    int		*perrno = (ctx) ? &ctx->qlib2_errno : &qlib2_errno;
 
-    qlib2_errno = 0;
+    *perrno = 0;
     if (my_wordorder < 0) get_my_wordorder();
 
     /* Perform data integrity check, and pick out pertinent header info.*/
@@ -163,12 +273,20 @@ DATA_HDR *decode_hdr_sdr
 	    return ((DATA_HDR *)NULL);
 	}
 	else {
-	    qlib2_errno = 1;
+	    *perrno = 1;
 	    return ((DATA_HDR *)NULL);
 	}
     }
 
-    if ((ohdr = new_data_hdr()) == NULL) return (NULL);
+    if (uhdr) {
+	ohdr = uhdr;
+	if (ctx) init_data_hdr_ctx (ctx, ohdr);
+	else init_data_hdr (ohdr);
+    }
+    else {
+	ohdr = (ctx) ? new_data_hdr_ctx(ctx) : new_data_hdr();
+	if (ohdr == NULL) return (NULL);
+    }
     ohdr->record_type = ihdr->data_hdr_ind;
     ohdr->seq_no = atoi (charncpy (tmp, ihdr->seq_no, 6) );
 
@@ -187,11 +305,25 @@ DATA_HDR *decode_hdr_sdr
 	  case 8:
 	  case 10:
 	    ohdr->blksize = (int)pow(2.0,atoi(charncpy(tmp,p+11,2)));
-	    ok = add_blockette (ohdr, p, ohdr->data_type, 
-			   atoi(charncpy(tmp,p+3,4)), my_wordorder, 0);
+	    if (uhdr) {
+		i = atoi(charncpy(tmp,p+3,4));
+		ok = (nbs > 0 && i > 0 && 8 + i <= maxbytes);
+		if (ok) {
+		    ubs->pb = p;
+		    ubs->type = ohdr->data_type;
+		    ubs->len = i;
+		    ubs->wordorder = my_wordorder;
+		    ubs->next = NULL;
+		    ohdr->pblockettes = ubs;
+		    ohdr->num_blockettes = 1;
+		    ohdr->first_blockette = 48;
+		}
+	    }
+	    else ok = add_blockette (ohdr, p, ohdr->data_type, 
+				atoi(charncpy(tmp,p+3,4)), my_wordorder, 0);
 	    if (! ok) {
-		qlib2_errno = 2;
-		free_data_hdr(ohdr);
+		*perrno = 2;
+		if (! uhdr) free_data_hdr(ohdr);
 		return ((DATA_HDR *)NULL);
 	    }
 	    break;
@@ -203,8 +335,8 @@ DATA_HDR *decode_hdr_sdr
 
     /* Determine word order of the fixed record header.			*/
     if ((wo = wordorder_from_time((unsigned char *)&(ihdr->time))) < 0) {
-	qlib2_errno = 3;
-	free_data_hdr (ohdr);
+	*perrno = 3;
+	if (! uhdr) free_data_hdr (ohdr);
 	return ((DATA_HDR *)NULL);
     }
     ohdr->hdr_wordorder = wo;
@@ -218,6 +350,8 @@ DATA_HDR *decode_hdr_sdr
     trim (ohdr->location_id);
     trim (ohdr->channel_id);
     trim (ohdr->network_id);
+    /* The SNCL id is assigned only by callers that use it.		*/
+    ohdr->sncl_id = MS_SNCL_NONE;
     ohdr->hdrtime = decode_time_sdr(ihdr->time, ohdr->hdr_wordorder);
     if (swapflag) {
 	/* num_samples.	*/
@@ -264,6 +398,10 @@ DATA_HDR *decode_hdr_sdr
     ohdr->pblockettes = (BS *)NULL;	/* Do not parse blockettes here.*/
 
     if (ohdr->num_blockettes == 0) ohdr->pblockettes = (BS *)NULL;
+    else if (uhdr) {
+	if (read_blockettes_into (ohdr, (char *)ihdr, maxbytes, ubs, nbs) != 1)
+	    return ((DATA_HDR *)NULL);
+    }
     else {
 	if (read_blockettes (ohdr, (char *)ihdr) != 1) {
 	    free ((char *)ohdr);
@@ -301,23 +439,23 @@ DATA_HDR *decode_hdr_sdr
     }
     /* Compute endtime.  Use precise sample interval in blockette 100.	*/
     /* For client convenience convert it to my_wordorder if not already.*/
+    /* Blockettes that point into the record are not modified.	*/
     if ((bs=find_blockette(ohdr, 100))) {
-	double actual_rate, dusecs;
         BLOCKETTE_100 *b = (BLOCKETTE_100 *) bs->pb;
-	if (bs->wordorder != my_wordorder) {
+	BLOCKETTE_100 b100;
+	if (bs->wordorder != my_wordorder && uhdr) {
+	    memcpy ((char *)&b100, bs->pb, sizeof(b100));
+	    swab_blockette (bs->type, (char *)&b100, sizeof(b100));
+	    b = &b100;
+	}
+	else if (bs->wordorder != my_wordorder) {
 	    swab_blockette (bs->type, bs->pb, bs->len);
 	    bs->wordorder = my_wordorder;
 	}
-	actual_rate = b->actual_rate;
-	dusecs = ((double)((ohdr->num_samples-1)/actual_rate))*USECS_PER_SEC;
-	ohdr->endtime = add_dtime (ohdr->begtime,  dusecs);
-	ohdr->rate_spsec = actual_rate;
-    }
-    else {
-	time_interval2(ohdr->num_samples - 1, ohdr->sample_rate, ohdr->sample_rate_mult,
-		       &seconds, &usecs);
-	ohdr->endtime = add_time(ohdr->begtime, seconds, usecs);
+	ohdr->rate_spsec = b->actual_rate;
     }
+    init_sample_clock_hdr (&sc, ohdr);
+    ohdr->endtime = sample_clock_time (&sc, ohdr->num_samples - 1);
 
     /*	Attempt to determine blocksize if current setting is 0.		*/
     /*	We can detect files of either 512 byte or 4K byte blocks.	*/
@@ -352,6 +490,65 @@ DATA_HDR *decode_hdr_sdr
     return (ohdr);
 }
 
+/************************************************************************/
+/*  decode_hdr_sdr:							*/
+/*	Decode SDR header stored with each SDR data block,		*/
+/*	and return ptr to dynamically allocated DATA_HDR structure.	*/
+/*	Fill in structure with the information in a easy-to-use format.	*/
+/*	Skip over vol_hdr record, which may be on Quanterra Ultra-Shear	*/
+/*	tapes.								*/
+/*  return:								*/
+/*	DATA_HDR pointer on success.					*/
+/*	NULL on failure.						*/
+/************************************************************************/
+DATA_HDR *decode_hdr_sdr
+   (SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes)	/* max # bytes in buffer.		*/
+{
+    return (decode_hdr_sdr_x (NULL, ihdr, maxbytes, NULL, NULL, 0));
+}
+
+/************************************************************************/
+/*  decode_hdr_sdr_ctx:							*/
+/*	Reentrant version of decode_hdr_sdr.  Use the settings in the	*/
+/*	QLIB2_CTX, and set the qlib2_errno in the QLIB2_CTX.		*/
+/*  return:								*/
+/*	DATA_HDR pointer on success.					*/
+/*	NULL on failure.						*/
+/************************************************************************/
+DATA_HDR *decode_hdr_sdr_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes)	/* max # bytes in buffer.		*/
+{
+    return (decode_hdr_sdr_x (ctx, ihdr, maxbytes, NULL, NULL, 0));
+}
+
+/************************************************************************/
+/*  decode_hdr_sdr_into:						*/
+/*	Decode SDR header into a caller supplied DATA_HDR without	*/
+/*	allocating memory, so that a DATA_HDR can be reused for many	*/
+/*	records.  The blockette list is built from the nbs BS		*/
+/*	structures in bs, and the blockettes point into the record,	*/
+/*	which must remain unchanged while the DATA_HDR is in use.	*/
+/*	Blockettes are left in the byte order of the record.  The	*/
+/*	DATA_HDR must not be passed to free_data_hdr or to routines	*/
+/*	that add or delete blockettes.  ctx may be NULL.		*/
+/*  return:								*/
+/*	hdr on success.							*/
+/*	NULL on failure, or if there are more than nbs blockettes.	*/
+/************************************************************************/
+DATA_HDR *decode_hdr_sdr_into
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes,	/* max # bytes in buffer.		*/
+    DATA_HDR	*hdr,		/* DATA_HDR to decode into.		*/
+    BS		*bs,		/* BS structures for blockettes.	*/
+    int		nbs)		/* # of BS structures.			*/
+{
+    return (decode_hdr_sdr_x (ctx, ihdr, maxbytes, hdr, bs, nbs));
+}
+
 /************************************************************************/
 /*  eval_rate:								*/
 /*	Evaluate sample rate.						*/
@@ -380,6 +577,35 @@ int eval_rate
     return (rate);
 }
 
+/************************************************************************/
+/*  init_sample_clock_hdr:						*/
+/*	Initialize a sample clock for the data described by a DATA_HDR.	*/
+/*	The anchor is the begtime of the header.  Use the actual rate	*/
+/*	in blockette 100 if it exists, otherwise use the nominal rate.	*/
+/*  return:								*/
+/*	0 on success, MS_ERROR if the header has no valid sample rate.	*/
+/************************************************************************/
+int init_sample_clock_hdr
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    DATA_HDR	*hdr)		/* ptr to DATA_HDR.			*/
+{
+    BS *bs;
+
+    if ((bs=find_blockette(hdr, 100))) {
+	BLOCKETTE_100 b100;
+	memcpy ((void *)&b100, bs->pb, sizeof(BLOCKETTE_100));
+	if (my_wordorder < 0) get_my_wordorder();
+	if (bs->wordorder != my_wordorder) {
+	    swab_blockette (bs->type, (char *)&b100, sizeof(BLOCKETTE_100));
+	}
+	if (init_sample_clock_sps (sc, hdr->begtime, b100.actual_rate) == 0) {
+	    return (0);
+	}
+    }
+    return (init_sample_clock (sc, hdr->begtime, hdr->sample_rate, 
+			       hdr->sample_rate_mult));
+}
+
 /************************************************************************/
 /*  asc_sdr_time:							*/
 /*	Convert SDR_TIME to ascii string.				*/
@@ -496,33 +722,9 @@ int read_blockettes
 	}
 	else {
 	    /* No further blockettes.  Assume length of blockette structure.*/
-	    switch (bl_type) {
-	      /* Fixed length blockettes.	*/
-	      case 100: bl_len = sizeof (BLOCKETTE_100); break;
-	      case 200: bl_len = sizeof (BLOCKETTE_200); break;
-	      case 201: bl_len = sizeof (BLOCKETTE_201); break;
-	      case 300: bl_len = sizeof (BLOCKETTE_300); break;
-	      case 310: bl_len = sizeof (BLOCKETTE_310); break;
-	      case 320: bl_len = sizeof (BLOCKETTE_320); break;
-	      case 390: bl_len = sizeof (BLOCKETTE_390); break;
-	      case 395: bl_len = sizeof (BLOCKETTE_395); break;
-	      case 400: bl_len = sizeof (BLOCKETTE_400); break;
-	      case 405: bl_len = sizeof (BLOCKETTE_405); break;
-	      case 500: bl_len = sizeof (BLOCKETTE_500); break;
-	      case 1000: bl_len = sizeof (BLOCKETTE_1000); break;
-	      case 1001: bl_len = sizeof (BLOCKETTE_1001); break;
-	      /* Variable length blockettes.  Preserve original length,	*/
-	      /* even though it may not is divisible by 4.		*/
-	      /* It is up to the user to ensure that that blockettes	*/
-	      /* have 4 byte alignment in a SEED data record.		*/
-	      case 2000: 
-		bl_len = ((BLOCKETTE_2000 *)(str+offset))->blockette_len; 
-		if (hdr->hdr_wordorder != my_wordorder) {
-		    swab2 ((short int *)&bl_len);
-		}
-		break;
-	      default: bl_type = 0; bl_len = 0; break;
-	    }
+	    bl_len = known_blockette_len (bl_type, str+offset, 
+					  hdr->hdr_wordorder != my_wordorder);
+	    if (bl_len == 0) bl_type = 0;
 	    /* Ensure that the blockette length does not exceed space	*/
 	    /* available for it after the header and before first_data.	*/
 	    if (hdr->first_data > 0 && hdr->first_data - offset > 0 && 
@@ -921,6 +1123,24 @@ void init_data_hdr
     hdr->data_wordorder = data_wordorder;
     hdr->record_type = default_data_hdr_ind;
     hdr->sample_rate_mult = 1;
+    hdr->sncl_id = MS_SNCL_NONE;
+}
+
+/************************************************************************/
+/*  init_data_hdr_ctx:							*/
+/*	Initialize a DATA_HDR structure using the settings in the	*/
+/*	QLIB2_CTX.							*/
+/************************************************************************/
+void init_data_hdr_ctx 
+   (QLIB2_CTX	    *ctx,	/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	    *hdr)	/* ptr to DATA_HDR to initialize.	*/
+{
+    memset ((void *)hdr, 0, sizeof(DATA_HDR));
+    hdr->hdr_wordorder = ctx->hdr_wordorder;
+    hdr->data_wordorder = ctx->data_wordorder;
+    hdr->record_type = ctx->default_data_hdr_ind;
+    hdr->sample_rate_mult = 1;
+    hdr->sncl_id = MS_SNCL_NONE;
 }
 
 /************************************************************************/
@@ -946,6 +1166,29 @@ DATA_HDR *new_data_hdr ()
     return (hdr);
 }
 
+/************************************************************************/
+/*  new_data_hdr_ctx:							*/
+/*	Allocate and initialize a DATA_HDR structure using the settings	*/
+/*	in the QLIB2_CTX.						*/
+/*  Return:								*/
+/*	Pointer to DATA_HDR structure on success.			*/
+/*	NULL on error.							*/
+/************************************************************************/
+DATA_HDR *new_data_hdr_ctx 
+   (QLIB2_CTX	    *ctx)	/* ptr to QLIB2_CTX.			*/
+{
+    DATA_HDR	    *hdr;
+
+    hdr = (DATA_HDR *) malloc (sizeof(DATA_HDR));
+    if (hdr == NULL) {
+	qlib2_ctx_error (ctx, "Error: unable to allocate data_hdr for output\n");
+	if (QLIB2_CTX_CLASSIC(ctx)) exit (1);
+	return (NULL);
+    }
+    init_data_hdr_ctx (ctx, hdr);
+    return (hdr);
+}
+
 /************************************************************************/
 /*  copy_data_hdr:							*/
 /*	Copy one DATA_HDR to another DATA_HDR, including all blockettes.*/
@@ -1177,6 +1420,22 @@ char *q_clock_status
     char	clock_model)	/* numeric clock model from blockette.	*/
 {
     static char snr[40];
+    return (q_clock_status_r (status, clock_model, snr));
+}
+
+/************************************************************************/
+/*  q_clock_status_r:							*/
+/*	Get string for the clock status specified in blockette.		*/
+/*	Reentrant version of q_clock_status.				*/
+/*  return:								*/
+/*	String containing clock status, which may be a static constant	*/
+/*	string or the caller's buffer.					*/
+/************************************************************************/
+char *q_clock_status_r
+   (char	*status,	/* status string from blockette.	*/
+    char	clock_model,	/* numeric clock model from blockette.	*/
+    char	*snr)		/* output buffer (at least 40 chars).	*/
+{
     switch (clock_model) {
       case 3:	
 	switch(status[0]) {
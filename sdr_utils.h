@@ -44,6 +44,7 @@
 #include "timedef.h"
 #include "sdr.h"
 #include "data_hdr.h"
+#include "qutils.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -61,10 +62,27 @@ extern DATA_HDR *decode_hdr_sdr
    (SDR_HDR	*ihdr,		/* input SDR header.			*/
     int		maxbytes);	/* max # bytes in buffer.		*/
 
+extern DATA_HDR *decode_hdr_sdr_ctx
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX.			*/
+    SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes);	/* max # bytes in buffer.		*/
+
+extern DATA_HDR *decode_hdr_sdr_into
+   (QLIB2_CTX	*ctx,		/* ptr to QLIB2_CTX, or NULL.		*/
+    SDR_HDR	*ihdr,		/* input SDR header.			*/
+    int		maxbytes,	/* max # bytes in buffer.		*/
+    DATA_HDR	*hdr,		/* DATA_HDR to decode into.		*/
+    BS		*bs,		/* BS structures for blockettes.	*/
+    int		nbs);		/* # of BS structures.			*/
+
 extern int eval_rate 
    (int	sample_rate_factor,	/* Fixed data hdr sample rate factor.	*/
     int	sample_rate_mult);	/* Fixed data hdr sample rate multiplier*/
 
+extern int init_sample_clock_hdr
+   (SAMPLE_CLOCK *sc,		/* ptr to SAMPLE_CLOCK to initialize.	*/
+    DATA_HDR	*hdr);		/* ptr to DATA_HDR.			*/
+
 extern char *asc_sdr_time
    (char	*str,		/* string to encode time into.		*/
     SDR_TIME	st,		/* SDR_TIME structure to decode.	*/
@@ -120,6 +138,13 @@ extern void init_data_hdr
 
 extern DATA_HDR *new_data_hdr (void);	
 
+extern void init_data_hdr_ctx 
+   (QLIB2_CTX	    *ctx,	/* ptr to QLIB2_CTX.			*/
+    DATA_HDR	    *hdr);	/* ptr to DATA_HDR to initialize.	*/
+
+extern DATA_HDR *new_data_hdr_ctx 
+   (QLIB2_CTX	    *ctx);	/* ptr to QLIB2_CTX.			*/
+
 extern DATA_HDR *copy_data_hdr
    (DATA_HDR	    *hdr_dst,	/* ptr to destination DATA_HDR.		*/
     DATA_HDR	    *hdr_src);	/* ptr to source DATA_HDR to copy.	*/
@@ -158,6 +183,11 @@ extern char *q_clock_status
    (char	*status,	/* status string from blockette.	*/
     char	clock_model);	/* numeric clock model from blockette.	*/
 
+extern char *q_clock_status_r
+   (char	*status,	/* status string from blockette.	*/
+    char	clock_model,	/* numeric clock model from blockette.	*/
+    char	*snr);		/* output buffer (at least 40 chars).	*/
+
 extern int swab_blockette
    (int		type,		/* blockette number.			*/
     char	*contents,	/* string containing blockette.		*/
@@ -65,5 +65,25 @@ typedef struct	_int_time {
     int		usec;		/* Microseconds (0-999999)	*/
 } INT_TIME;
 
+/*	Sample clock: exact rational sample rate and anchor time.	*/
+
+typedef struct	_sample_clock {
+    INT_TIME	anchor;		/* Time of sample 0.		*/
+    int64_t	num;		/* Rate is num samples ...	*/
+    int64_t	den;		/* ... per den seconds.		*/
+} SAMPLE_CLOCK;
+
+/*	Conversion cursor: day cached by int_to_ext_c().		*/
+
+typedef struct	_ext_cursor {
+    const void	*table;		/* Leap table of cached day.	*/
+    int		year;		/* Year of cached day.		*/
+    int		start;		/* INT_TIME second of 00:00:00.	*/
+    int		end;		/* INT_TIME second of next day.	*/
+    int		doy;		/* Day of year of cached day.	*/
+    int		month;		/* Month of cached day.		*/
+    int		day;		/* Day of month of cached day.	*/
+} EXT_CURSOR;
+
 #endif
 
@@ -57,7 +57,7 @@
 
 
 /************************************************************************/
-/*  unpack_steim1:							*/
+/*  unpack_steim1_r:						*/
 /*	Unpack STEIM1 data frames and place in supplied buffer.		*/
 /*	Data is divided into frames.					*/
 /*	If req_samples < 0, perform fast decompression of |req_samples|.*/
@@ -68,7 +68,7 @@
 /*	# of samples returned on success.				*/
 /*	negative QLIB2 error code on error.				*/
 /************************************************************************/
-int unpack_steim1
+int unpack_steim1_r
    (FRAME	*pf,		/* ptr to Steim1 data frames.		*/
     int		nbytes,		/* number of bytes in all data frames.	*/
     int		num_samples,	/* number of data samples in all frames.*/
@@ -78,7 +78,7 @@ int unpack_steim1
     int		*px0,		/* return X0, first sample in frame.	*/
     int		*pxn,		/* return XN, last sample in frame.	*/
     int		data_wordorder,	/* wordorder of data.			*/
-    char	**p_errmsg)	/* ptr to ptr to error message.		*/
+    char	*errmsg)	/* buffer for error message, or NULL.	*/
 {
     int		*diff = diffbuff;
     int		*data = databuff;
@@ -94,7 +94,7 @@ int unpack_steim1
     short int	stmp;
     int		swapflag;
     unsigned int ctrl;
-    static char	errmsg[256];
+    char	msg[QLIB2_ERRMSG_LEN];
 
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
@@ -209,11 +209,11 @@ int unpack_steim1
 
 	/* Verify that the last value is identical to xn.		*/
 	if (last_data != *pxn) {
-	    sprintf(errmsg, "%s, last_data=%d, xn=%d\n", 
+	    sprintf (msg, "%s, last_data=%d, xn=%d\n", 
 		    "Data integrity for STEIM1 data frame",
 		    last_data, *pxn);
-	    if (p_errmsg) *p_errmsg = errmsg;
-	    else fprintf (info, "%s", errmsg);
+	    if (errmsg) strcpy (errmsg, msg);
+	    else fprintf (info, "%s", msg);
 	    return (MS_ERROR);
 	}
     }
@@ -222,7 +222,39 @@ int unpack_steim1
 }
 
 /************************************************************************/
-/*  unpack_steim2:							*/
+/*  unpack_steim1:							*/
+/*	Unpack STEIM1 data frames and place in supplied buffer.		*/
+/*	Not reentrant - the error message is returned in a static	*/
+/*	buffer.  Use unpack_steim1_r in multi-threaded programs.	*/
+/*  Return:								*/
+/*	# of samples returned on success.				*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int unpack_steim1
+   (FRAME	*pf,		/* ptr to Steim1 data frames.		*/
+    int		nbytes,		/* number of bytes in all data frames.	*/
+    int		num_samples,	/* number of data samples in all frames.*/
+    int		req_samples,	/* number of data desired by caller.	*/
+    int		*databuff,	/* ptr to unpacked data array.		*/
+    int		*diffbuff,	/* ptr to unpacked diff array.		*/
+    int		*px0,		/* return X0, first sample in frame.	*/
+    int		*pxn,		/* return XN, last sample in frame.	*/
+    int		data_wordorder,	/* wordorder of data.			*/
+    char	**p_errmsg)	/* ptr to ptr to error message.		*/
+{
+    static char	errmsg[QLIB2_ERRMSG_LEN];
+    int		status;
+
+    errmsg[0] = '\0';
+    status = unpack_steim1_r (pf, nbytes, num_samples, req_samples,
+			     databuff, diffbuff, px0, pxn, data_wordorder,
+			     (p_errmsg) ? errmsg : NULL);
+    if (status < 0 && p_errmsg && errmsg[0]) *p_errmsg = errmsg;
+    return (status);
+}
+
+/************************************************************************/
+/*  unpack_steim2_r:						*/
 /*	Unpack STEIM2 data frames and place in supplied buffer.		*/
 /*	Data is divided into frames.					*/
 /*	If req_samples < 0, perform fast decompression of |req_samples|.*/
@@ -233,7 +265,7 @@ int unpack_steim1
 /*	# of samples returned on success.				*/
 /*	negative QLIB2 error code on error.				*/
 /************************************************************************/
-int unpack_steim2 
+int unpack_steim2_r
    (FRAME	*pf,		/* ptr to Steim2 data frames.		*/
     int		nbytes,		/* number of bytes in all data frames.	*/
     int		num_samples,	/* number of data samples in all frames.*/
@@ -243,7 +275,7 @@ int unpack_steim2
     int		*px0,		/* return X0, first sample in frame.	*/
     int		*pxn,		/* return XN, last sample in frame.	*/
     int		data_wordorder,	/* wordorder of data.			*/
-    char	**p_errmsg)	/* ptr to ptr to error message.		*/
+    char	*errmsg)	/* buffer for error message, or NULL.	*/
 {
     int		*diff = diffbuff;
     int		*data = databuff;
@@ -259,7 +291,7 @@ int unpack_steim2
     int		val, dnib;
     int		swapflag;
     unsigned int ctrl;
-    static char	errmsg[256];
+    char	msg[QLIB2_ERRMSG_LEN];
 
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
@@ -310,10 +342,10 @@ int unpack_steim2
 		  case 3:	/*  3 10-bit differences.		*/
 		    bits = 10; n = 3; m1 = 0x000003ff; m2 = 0x00000200; break;
 		  default:	/*	should NEVER get here.		*/
-		    sprintf (errmsg, "invalid ck, dnib, fn, wn = %d, %d, %d, %d\n", 
+		    sprintf (msg, "invalid ck, dnib, fn, wn = %d, %d, %d, %d\n", 
 			     c, dnib, fn, wn);
-		    if (p_errmsg) *p_errmsg = errmsg;
-		    else fprintf (info, "%s", errmsg);
+		    if (errmsg) strcpy (errmsg, msg);
+		    else fprintf (info, "%s", msg);
 		    return(MS_ERROR);
 		    break;
 		}
@@ -336,10 +368,10 @@ int unpack_steim2
 		  case 2:	/*  7 4-bit differences.		*/
 		    bits = 4; n = 7; m1 = 0x0000000f; m2 = 0x00000008; break;
 		  default:
-		    sprintf (errmsg, "invalid ck, dnib, fn, wn = %d, %d, %d, %d\n",
+		    sprintf (msg, "invalid ck, dnib, fn, wn = %d, %d, %d, %d\n",
 			     c, dnib, fn, wn);
-		    if (p_errmsg) *p_errmsg = errmsg;
-		    else fprintf (info, "%s", errmsg);
+		    if (errmsg) strcpy (errmsg, msg);
+		    else fprintf (info, "%s", msg);
 		    return(MS_ERROR);
 		    break;
 		}
@@ -396,11 +428,11 @@ int unpack_steim2
 
 	/* Verify that the last value is identical to xn.		*/
 	if (last_data != *pxn) {
-	    sprintf(errmsg, "%s, last_data=%d, xn=%d\n", 
+	    sprintf (msg, "%s, last_data=%d, xn=%d\n", 
 		    "Data integrity for STEIM2 data frame",
 		    last_data, *pxn);
-	    if (p_errmsg) *p_errmsg = errmsg;
-	    else fprintf (info, "%s", errmsg);
+	    if (errmsg) strcpy (errmsg, msg);
+	    else fprintf (info, "%s", msg);
 	    return (MS_ERROR);
 	    }
     }
@@ -408,6 +440,38 @@ int unpack_steim2
     return ((req_samples<num_samples) ? req_samples : num_samples);
 }
 
+/************************************************************************/
+/*  unpack_steim2:							*/
+/*	Unpack STEIM2 data frames and place in supplied buffer.		*/
+/*	Not reentrant - the error message is returned in a static	*/
+/*	buffer.  Use unpack_steim2_r in multi-threaded programs.	*/
+/*  Return:								*/
+/*	# of samples returned on success.				*/
+/*	negative QLIB2 error code on error.				*/
+/************************************************************************/
+int unpack_steim2
+   (FRAME	*pf,		/* ptr to Steim2 data frames.		*/
+    int		nbytes,		/* number of bytes in all data frames.	*/
+    int		num_samples,	/* number of data samples in all frames.*/
+    int		req_samples,	/* number of data desired by caller.	*/
+    int		*databuff,	/* ptr to unpacked data array.		*/
+    int		*diffbuff,	/* ptr to unpacked diff array.		*/
+    int		*px0,		/* return X0, first sample in frame.	*/
+    int		*pxn,		/* return XN, last sample in frame.	*/
+    int		data_wordorder,	/* wordorder of data.			*/
+    char	**p_errmsg)	/* ptr to ptr to error message.		*/
+{
+    static char	errmsg[QLIB2_ERRMSG_LEN];
+    int		status;
+
+    errmsg[0] = '\0';
+    status = unpack_steim2_r (pf, nbytes, num_samples, req_samples,
+			     databuff, diffbuff, px0, pxn, data_wordorder,
+			     (p_errmsg) ? errmsg : NULL);
+    if (status < 0 && p_errmsg && errmsg[0]) *p_errmsg = errmsg;
+    return (status);
+}
+
 /************************************************************************/
 /*  unpack_int_16:							*/
 /*	Unpack int_16 miniSEED data and place in supplied buffer.	*/
@@ -433,7 +497,7 @@ int unpack_int_16
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
 
-    if (num_samples < 0) return (MS_ERROR);
+    if (num_samples < 0 || num_samples > nbytes / 2) return (MS_ERROR);
     if (req_samples < 0) req_samples = -req_samples;
 
     for (nd=0; nd<req_samples && nd<num_samples; nd++) {
@@ -470,7 +534,7 @@ int unpack_int_32
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
 
-    if (num_samples < 0) return (MS_ERROR);
+    if (num_samples < 0 || num_samples > nbytes / 4) return (MS_ERROR);
     if (req_samples < 0) req_samples = -req_samples;
 
     for (nd=0; nd<req_samples && nd<num_samples; nd++) {
@@ -513,7 +577,7 @@ int unpack_int_24
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
 
-    if (num_samples < 0) return (MS_ERROR);
+    if (num_samples < 0 || num_samples > nbytes / 3) return (MS_ERROR);
     if (req_samples < 0) req_samples = -req_samples;
 
     if (my_wordorder == SEED_BIG_ENDIAN) {
@@ -569,7 +633,7 @@ int unpack_fp_sp
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
 
-    if (num_samples < 0) return (MS_ERROR);
+    if (num_samples < 0 || num_samples > nbytes / 4) return (MS_ERROR);
     if (req_samples < 0) req_samples = -req_samples;
 
     for (nd=0; nd<req_samples && nd<num_samples; nd++) {
@@ -609,7 +673,7 @@ int unpack_fp_dp
     if (my_wordorder < 0) get_my_wordorder();
     swapflag = (my_wordorder != data_wordorder);
 
-    if (num_samples < 0) return (MS_ERROR);
+    if (num_samples < 0 || num_samples > nbytes / 8) return (MS_ERROR);
     if (req_samples < 0) req_samples = -req_samples;
 
     for (nd=0; nd<req_samples && nd<num_samples; nd++) {
@@ -60,6 +60,18 @@ extern int unpack_steim1
     int		data_wordorder,	/* wordorder of data (NOT USED).	*/
     char	**p_errmsg);	/* ptr to ptr to error message.		*/
 
+extern int unpack_steim1_r
+   (FRAME	*pf,		/* ptr to Steim1 data frames.		*/
+    int		nbytes,		/* number of bytes in all data frames.	*/
+    int		num_samples,	/* number of data samples in all frames.*/
+    int		req_samples,	/* number of data desired by caller.	*/
+    int		*databuff,	/* ptr to unpacked data array.		*/
+    int		*diffbuff,	/* ptr to unpacked diff array.		*/
+    int		*px0,		/* return X0, first sample in frame.	*/
+    int		*pxn,		/* return XN, last sample in frame.	*/
+    int		data_wordorder,	/* wordorder of data (NOT USED).	*/
+    char	*errmsg);	/* buffer for error message, or NULL.	*/
+
 extern int unpack_steim2 
    (FRAME	*pf,		/* ptr to Steim2 data frames.		*/
     int		nbytes,		/* number of bytes in all data frames.	*/
@@ -72,6 +84,18 @@ extern int unpack_steim2
     int		data_wordorder,	/* wordorder of data (NOT USED).	*/
     char	**p_errmsg);	/* ptr to ptr to error message.		*/
 
+extern int unpack_steim2_r
+   (FRAME	*pf,		/* ptr to Steim2 data frames.		*/
+    int		nbytes,		/* number of bytes in all data frames.	*/
+    int		num_samples,	/* number of data samples in all frames.*/
+    int		req_samples,	/* number of data desired by caller.	*/
+    int		*databuff,	/* ptr to unpacked data array.		*/
+    int		*diffbuff,	/* ptr to unpacked diff array.		*/
+    int		*px0,		/* return X0, first sample in frame.	*/
+    int		*pxn,		/* return XN, last sample in frame.	*/
+    int		data_wordorder,	/* wordorder of data (NOT USED).	*/
+    char	*errmsg);	/* buffer for error message, or NULL.	*/
+
 extern int unpack_int_16 
    (short int	*ibuf,		/* ptr to input data.			*/
     int		nbytes,		/* number of bytes in all data frames.	*/